@@ -0,0 +1,82 @@
+#ifndef MIOPENTENSILE_GUARD_BENCHMARK_BENCHMARK_HPP
+#define MIOPENTENSILE_GUARD_BENCHMARK_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+template <class F>
+double time_ms(F f)
+{
+    auto start = clock::now();
+    f();
+    auto finish = clock::now();
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+template <class F>
+double time_us(F f)
+{
+    return time_ms(f) * 1000.0;
+}
+
+// Resident set size of the process in MiB
+inline double resident_memory_mb()
+{
+    std::ifstream is("/proc/self/statm");
+    std::size_t size     = 0;
+    std::size_t resident = 0;
+    is >> size >> resident;
+    return double(resident) * double(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+// The p-th percentile (0-100) of the samples
+inline double percentile(std::vector<double> samples, double p)
+{
+    if(samples.empty())
+        return 0.0;
+    std::sort(samples.begin(), samples.end());
+    auto i = std::size_t(p / 100.0 * double(samples.size() - 1) + 0.5);
+    return samples[std::min(i, samples.size() - 1)];
+}
+
+// Compute unit counts of the devices the logic files were tuned on
+inline const std::map<std::string, int>& arch_cu_counts()
+{
+    static const std::map<std::string, int> result = {{"gfx803", 64},
+                                                      {"gfx900", 64},
+                                                      {"gfx906", 60},
+                                                      {"gfx908", 120},
+                                                      {"gfx90a", 104},
+                                                      {"gfx1030", 80}};
+    return result;
+}
+
+// Runs f in a forked child so its memory use is not shared with the parent
+template <class F>
+void run_child(F f)
+{
+    auto pid = fork();
+    if(pid == 0)
+    {
+        f();
+        std::exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,57 @@
+#include <miopentensile/code_objects.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <Tensile/hip/HipSolutionAdapter.hpp>
+#include <iostream>
+#include "benchmark.hpp"
+
+// Compares loading every installed code object, as done at startup before,
+// with indexing the code objects of the current device and loading only the
+// files holding the requested kernels. Each mode runs in a child process so
+// the resident memory is not shared between them.
+
+void run_eager()
+{
+    Tensile::hip::SolutionAdapter adapter;
+    auto arch  = miopentensile::hardware_arch(*miopentensile::hardware().current());
+    auto files = miopentensile::library_code_objects(miopentensile::library_path(arch));
+    auto t     = bench::time_ms([&] {
+        for(auto&& f : files)
+            adapter.loadCodeObjectFile(f);
+    });
+    std::cout << "eager: " << files.size() << " files, " << t << " ms, "
+              << bench::resident_memory_mb() << " MiB resident" << std::endl;
+}
+
+void run_lazy(std::size_t nkernels)
+{
+    auto arch = miopentensile::hardware_arch(*miopentensile::hardware().current());
+    std::vector<std::string> kernels;
+    auto files = miopentensile::library_code_objects(miopentensile::library_path(arch));
+    for(auto&& f : files)
+    {
+        if(not miopentensile::code_object_matches_arch(f, arch))
+            continue;
+        for(auto&& k : miopentensile::code_object_kernels(f))
+        {
+            if(kernels.size() < nkernels)
+                kernels.push_back(k);
+        }
+    }
+    auto& loader = miopentensile::code_objects(arch);
+    auto t       = bench::time_ms([&] {
+        for(auto&& k : kernels)
+            loader.load_kernel(k);
+    });
+    std::cout << "lazy (" << arch << ", " << kernels.size() << " kernels): "
+              << loader.loaded_files() << "/" << loader.indexed_files() << " files, " << t
+              << " ms, " << bench::resident_memory_mb() << " MiB resident" << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::size_t nkernels = argc > 1 ? std::stoul(argv[1]) : 8;
+    std::cout << "baseline: " << bench::resident_memory_mb() << " MiB resident" << std::endl;
+    bench::run_child([&] { run_lazy(nkernels); });
+    bench::run_child([] { run_eager(); });
+}
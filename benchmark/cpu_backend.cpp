@@ -0,0 +1,131 @@
+#include <miopentensile/gemm.h>
+#include <iostream>
+#include <string>
+#include "cpu_gemm.hpp"
+#include "benchmark.hpp"
+
+// Times miopen_tensile_gemm_hip on the cpu backend against the element by
+// element reference of the tests. No gpu is needed.
+//
+//     bench_cpu_backend [size]...
+//
+// Sizes default to 256, 1024 and 4096 for m, n and k. The reference only runs
+// at sizes of at most 512, as it takes minutes beyond that. Set
+// MIOPEN_TENSILE_CPU_THREADS to limit the threads of the backend. The time of
+// tiny gemms shows the cost of a call, where one task runs on the calling
+// thread and more wake the threads of the backend.
+
+using mitensile::shape;
+
+template <class T>
+miopen_tensile_type type_of();
+
+template <>
+miopen_tensile_type type_of<float>()
+{
+    return miopen_tensile_type_float;
+}
+
+template <>
+miopen_tensile_type type_of<mitensile::half>()
+{
+    return miopen_tensile_type_half;
+}
+
+template <>
+miopen_tensile_type type_of<mitensile::int8x4>()
+{
+    return miopen_tensile_type_int8x4;
+}
+
+template <>
+miopen_tensile_type type_of<std::int32_t>()
+{
+    return miopen_tensile_type_int32;
+}
+
+miopen_tensile_matrix square(std::size_t n, bool transposed, miopen_tensile_type type, void* data)
+{
+    miopen_tensile_matrix m{{n, n}, {n, 1}, {0, 0}, type, data};
+    if(transposed)
+        std::swap(m.strides[0], m.strides[1]);
+    return m;
+}
+
+double gflops(std::size_t n, double ms) { return 2.0 * n * n * n / (ms * 1.0e6); }
+
+template <class T, class Out = T>
+void run(const std::string& name, std::size_t n, bool ta, bool tb)
+{
+    auto lanes = mitensile::element_lanes<T>{};
+    auto as    = shape::from_lens({n, n});
+    auto bs    = shape::from_lens({n, n});
+    if(ta)
+        as = as.transpose();
+    if(tb)
+        bs = bs.transpose();
+    auto p = mitensile::problem<T, Out>::generate(
+        as.step(-1, lanes), bs.step(-2, lanes), shape::from_lens({n, n}));
+    auto c = p.c;
+    auto a = square(n, ta, type_of<T>(), p.a.data());
+    auto b = square(n, tb, type_of<T>(), p.b.data());
+    auto d = square(n, false, type_of<Out>(), c.data());
+    // The first call starts the threads and touches the buffers
+    miopen_tensile_gemm_hip(nullptr, &a, &b, &d, 1.0, 0.0);
+    auto t = bench::time_ms([&] {
+        if(miopen_tensile_gemm_hip(nullptr, &a, &b, &d, 1.0, 0.0) !=
+           miopen_tensile_status_success)
+            throw std::runtime_error("Gemm failed");
+    });
+    std::cout << name << (ta ? "T" : "N") << (tb ? "T" : "N") << " " << n << ": " << t
+              << " ms, " << gflops(n, t) << " GFLOPS";
+    if(n <= 512)
+    {
+        std::vector<Out> expected;
+        auto naive = bench::time_ms([&] { expected = mitensile::naive_gemm(p); });
+        std::cout << ", reference " << naive << " ms, " << naive / t << "x";
+        if(expected != c)
+            std::cout << ", results differ";
+    }
+    std::cout << std::endl;
+}
+
+// Time per call of a gemm of tiny batch items, one task each, which is mostly
+// handing the tasks to the threads of the backend
+void overhead(std::size_t batch)
+{
+    const std::size_t n     = 8;
+    const std::size_t calls = 10000;
+    std::vector<float> x(n * n * batch, 1.0f);
+    std::vector<float> y(n * n * batch);
+    auto a  = square(n, false, miopen_tensile_type_float, x.data());
+    auto c  = square(n, false, miopen_tensile_type_float, y.data());
+    a.batch = {batch, n * n};
+    c.batch = {batch, n * n};
+    miopen_tensile_gemm_hip(nullptr, &a, &a, &c, 1.0, 0.0);
+    auto t = bench::time_us([&] {
+        for(std::size_t i = 0; i < calls; i++)
+            miopen_tensile_gemm_hip(nullptr, &a, &a, &c, 1.0, 0.0);
+    });
+    std::cout << "overhead of " << batch << " tasks: " << t / calls << " us per call"
+              << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for(int i = 1; i < argc; i++)
+        sizes.push_back(std::stoul(argv[i]));
+    if(sizes.empty())
+        sizes = {256, 1024, 4096};
+    miopen_tensile_set_backend(miopen_tensile_backend_cpu);
+    overhead(1);
+    overhead(64);
+    for(auto n : sizes)
+    {
+        run<float>("float ", n, false, false);
+        run<float>("float ", n, true, true);
+        run<mitensile::half>("half ", n, false, true);
+        run<mitensile::int8x4, std::int32_t>("int8x4 ", n, false, true);
+    }
+}
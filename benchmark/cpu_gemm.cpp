@@ -0,0 +1,53 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include "cpu_gemm.hpp"
+#include "benchmark.hpp"
+
+// Times the reference gemm the tests verify the gpu results with. No gpu is
+// needed.
+//
+//     bench_cpu_gemm [size]
+//
+// The size defaults to 4096, for m, n and k. The element by element
+// reference is timed at a small size for comparison.
+
+using mitensile::shape;
+
+shape square(std::size_t n, bool transposed)
+{
+    auto s = shape::from_lens({n, n});
+    return transposed ? s.transpose() : s;
+}
+
+template <class T, class Out = T>
+void run(const std::string& name, std::size_t n, bool ta, bool tb, bool naive = false)
+{
+    auto as = square(n, ta);
+    auto bs = square(n, tb);
+    auto cs = square(n, false);
+    auto lanes = mitensile::element_lanes<T>{};
+    auto p = mitensile::problem<T, Out>::generate(as.step(-1, lanes), bs.step(-2, lanes), cs);
+    auto t = bench::time_ms([&] {
+        if(naive)
+            mitensile::naive_gemm(p);
+        else
+            mitensile::cpu_gemm(p);
+    });
+    auto gflops = 2.0 * n * n * n / (t * 1.0e6);
+    std::cout << name << (ta ? "T" : "N") << (tb ? "T" : "N") << " " << n << ": " << t / 1000.0
+              << " s, " << gflops << " GFLOPS" << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 4096;
+    std::cout << std::thread::hardware_concurrency() << " threads" << std::endl;
+    run<float>("naive float ", 256, false, false, true);
+    run<float>("float ", 256, false, false);
+    run<float>("float ", n, false, false);
+    run<float>("float ", n, true, true);
+    run<mitensile::half>("half ", n, false, true);
+    run<mitensile::bfloat16>("bfloat16 ", n, false, true);
+    run<mitensile::int8x4, std::int32_t>("int8x4 ", n, false, true);
+}
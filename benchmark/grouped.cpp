@@ -0,0 +1,81 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <iostream>
+#include <string>
+#include "benchmark.hpp"
+#include "fixtures.hpp"
+
+// Host side cost of launching a set of differently shaped gemms one call at a
+// time compared with a single grouped call. The device is faked and kernels
+// are dropped by a stub launcher, so only selection, argument patching and
+// grouping are measured.
+
+struct null_launcher : miopentensile::kernel_launcher
+{
+    std::size_t launches = 0;
+    void load_code_object(const std::string&) override {}
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>& kernels, hipStream_t) override
+    {
+        launches += kernels.size();
+        return hipSuccess;
+    }
+};
+
+std::vector<miopen_tensile_gemm_desc> make_group(std::size_t n)
+{
+    static const std::size_t sizes[] = {64, 128, 256, 384, 512, 1024};
+    std::vector<miopen_tensile_gemm_desc> result;
+    for(std::size_t i = 0; i < n; i++)
+    {
+        auto m = sizes[i % 6];
+        auto k = sizes[(i / 6) % 6];
+        auto c = sizes[(i / 36) % 6];
+        result.push_back({mitensile::make_matrix(m, k),
+                          mitensile::make_matrix(k, c),
+                          mitensile::make_matrix(m, c),
+                          1.0,
+                          0.0});
+    }
+    return result;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string arch   = argc > 1 ? argv[1] : "gfx908";
+    std::size_t count  = argc > 2 ? std::stoul(argv[2]) : 64;
+    std::size_t repeat = argc > 3 ? std::stoul(argv[3]) : 200;
+    auto launcher      = std::make_shared<null_launcher>();
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 120));
+    miopentensile::set_kernel_launcher(launcher);
+
+    auto group = make_group(count);
+    // Populate the plan cache so both modes run from cached plans
+    if(miopen_tensile_gemm_grouped_hip(nullptr, group.data(), group.size()) !=
+       miopen_tensile_status_success)
+    {
+        std::cerr << "No solution for the group on " << arch << std::endl;
+        return 1;
+    }
+
+    std::vector<double> single;
+    std::vector<double> grouped;
+    for(std::size_t r = 0; r < repeat; r++)
+    {
+        single.push_back(bench::time_us([&] {
+            for(auto&& g : group)
+                miopen_tensile_gemm_hip(nullptr, &g.a, &g.b, &g.c, g.alpha, g.beta);
+        }));
+        grouped.push_back(bench::time_us(
+            [&] { miopen_tensile_gemm_grouped_hip(nullptr, group.data(), group.size()); }));
+    }
+    auto per_gemm = [&](const std::vector<double>& x, double p) {
+        return bench::percentile(x, p) / double(count);
+    };
+    std::cout << arch << ", " << count << " gemms, " << launcher->launches << " kernels launched"
+              << std::endl;
+    std::cout << "single:  p50 " << per_gemm(single, 50) << " us/gemm, p99 "
+              << per_gemm(single, 99) << " us/gemm" << std::endl;
+    std::cout << "grouped: p50 " << per_gemm(grouped, 50) << " us/gemm, p99 "
+              << per_gemm(grouped, 99) << " us/gemm" << std::endl;
+}
@@ -0,0 +1,57 @@
+#include <miopentensile/library.hpp>
+#include <iostream>
+#include <set>
+#include <thread>
+#include "benchmark.hpp"
+
+// Times loading the tensile library of an architecture with an increasing
+// number of threads. The library is split into one part per data type when
+// built with MIOPEN_TENSILE_SPLIT_LIBRARY, and the parts are parsed in
+// parallel. No gpu is needed.
+//
+//     bench_library_load [arch]...
+//
+// Each load runs in its own process so nothing parsed is shared between
+// them. The files are read once first so every load finds them in the page
+// cache.
+
+void load(const std::vector<std::string>& parts, std::size_t threads)
+{
+    auto t = bench::time_ms([&] { miopentensile::load_library(parts, threads); });
+    std::cout << "    " << threads << " threads: " << t << " ms, "
+              << bench::resident_memory_mb() << " MiB resident" << std::endl;
+}
+
+void run_arch(const std::string& arch)
+{
+    auto parts = miopentensile::library_parts(miopentensile::library_path(arch));
+    std::cout << arch << ": " << parts.size() << " parts" << std::endl;
+    bench::run_child([&] { miopentensile::load_library(parts, 1); });
+    std::size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for(std::size_t threads = 1; threads < max_threads * 2 and threads <= parts.size();
+        threads *= 2)
+        bench::run_child([&] { load(parts, threads); });
+}
+
+int main(int argc, const char* argv[])
+{
+    std::set<std::string> archs;
+    for(int i = 1; i < argc; i++)
+        archs.insert(argv[i]);
+    if(archs.empty())
+    {
+        for(auto&& p : bench::arch_cu_counts())
+            archs.insert(p.first);
+    }
+    for(auto&& arch : archs)
+    {
+        try
+        {
+            run_arch(arch);
+        }
+        catch(const std::exception& e)
+        {
+            std::cout << arch << ": " << e.what() << std::endl;
+        }
+    }
+}
@@ -0,0 +1,192 @@
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_file.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "benchmark.hpp"
+
+// Shows what the binary logic index saves over the logic yaml at a cold
+// start, and what it does not: the tensile library is still loaded in full on
+// the first gemm of an architecture. No gpu is needed.
+//
+//     bench_logic_index <yaml directory> [arch]...
+//
+// For each architecture the index is compiled from its logic files, and then
+// in separate processes:
+//
+//   - parsing the yaml, which selection would need without the index
+//   - mapping the index and looking up one size of every file, twice in one
+//     process to show the cost of the nearest size trees built on first use
+//   - loading the installed tensile library, when there is one
+//
+// and the resident memory each adds. The index is mapped by a second process
+// while the first one still holds it, and the pages the two share are
+// reported.
+
+void find_yaml(const std::string& path, std::vector<std::string>& result)
+{
+    auto* dir = opendir(path.c_str());
+    if(dir == nullptr)
+        return;
+    while(auto* e = readdir(dir))
+    {
+        std::string name = e->d_name;
+        if(name == "." or name == "..")
+            continue;
+        auto child = path + "/" + name;
+        struct stat st;
+        if(stat(child.c_str(), &st) == 0 and S_ISDIR(st.st_mode))
+            find_yaml(child, result);
+        else if(name.size() > 5 and name.compare(name.size() - 5, 5, ".yaml") == 0)
+            result.push_back(child);
+    }
+    closedir(dir);
+}
+
+// Sum of a field of /proc/self/smaps, in KiB, over the mappings of path
+double mapped_kb(const std::string& path, const std::string& field)
+{
+    std::ifstream is("/proc/self/smaps");
+    std::string line;
+    bool in_path  = false;
+    double result = 0;
+    while(std::getline(is, line))
+    {
+        // Mapping headers start with an address range, fields with a name
+        if(line.find(':') > line.find('-') and line.find(' ') > line.find('-'))
+        {
+            in_path = line.size() >= path.size() and
+                      line.compare(line.size() - path.size(), path.size(), path) == 0;
+            continue;
+        }
+        if(in_path and line.compare(0, field.size() + 1, field + ":") == 0)
+        {
+            std::istringstream fields(line.substr(field.size() + 1));
+            double kb = 0;
+            fields >> kb;
+            result += kb;
+        }
+    }
+    return result;
+}
+
+std::vector<miopentensile::logic_file> parse_arch(const std::vector<std::string>& paths,
+                                                  const std::string& arch)
+{
+    std::vector<miopentensile::logic_file> result;
+    for(auto&& p : paths)
+    {
+        auto f = miopentensile::parse_logic_file(p);
+        if(f.arch == arch)
+            result.push_back(std::move(f));
+    }
+    return result;
+}
+
+// One exact and one nearest lookup of every type with entries
+void lookup_all(const miopentensile::logic_index& index)
+{
+    for(std::size_t type = 0; type < index.type_count(); type++)
+    {
+        auto entries = index.entries_of(index.type(type));
+        if(entries.empty())
+            continue;
+        const auto& e = entries.first[entries.size() / 2];
+        index.find_exact(type, e.m, e.n, e.batch, e.k);
+        index.find_nearest(type, e.m + 1, e.n + 1, e.batch, e.k + 1);
+    }
+}
+
+void run_arch(const std::vector<std::string>& paths, const std::string& arch)
+{
+    auto output = "/tmp/bench_logic_index_" + std::to_string(getpid()) + "_" + arch + ".idx";
+    // Compiled in a child so the heap of this process stays as it was
+    bench::run_child([&] {
+        auto files = parse_arch(paths, arch);
+        if(not files.empty())
+            miopentensile::write_logic_index(files, output);
+        std::cout << arch << ": " << files.size() << " logic files";
+    });
+    struct stat st;
+    if(stat(output.c_str(), &st) != 0)
+    {
+        std::cout << std::endl;
+        return;
+    }
+    std::cout << ", index of " << double(st.st_size) / (1024 * 1024) << " MiB" << std::endl;
+
+    bench::run_child([&] {
+        auto before = bench::resident_memory_mb();
+        std::vector<miopentensile::logic_file> parsed;
+        auto ms = bench::time_ms([&] { parsed = parse_arch(paths, arch); });
+        std::cout << "    parse yaml: " << ms << " ms, "
+                  << bench::resident_memory_mb() - before << " MiB resident" << std::endl;
+    });
+    bench::run_child([&] {
+        auto before = bench::resident_memory_mb();
+        std::unique_ptr<miopentensile::logic_index> index;
+        auto open  = bench::time_ms([&] { index.reset(new miopentensile::logic_index{output}); });
+        auto first = bench::time_ms([&] { lookup_all(*index); });
+        auto again = bench::time_ms([&] { lookup_all(*index); });
+        std::cout << "    map index: " << open << " ms, first lookups " << first
+                  << " ms, again " << again << " ms, "
+                  << bench::resident_memory_mb() - before << " MiB resident, "
+                  << mapped_kb(output, "Rss") / 1024 << " MiB of it mapped" << std::endl;
+        // A second process on the node maps the same pages
+        bench::run_child([&] {
+            // Not the mapping inherited through fork
+            index.reset();
+            miopentensile::logic_index other{output};
+            lookup_all(other);
+            // Pages of an index written just before are still dirty
+            auto shared = mapped_kb(output, "Shared_Clean") + mapped_kb(output, "Shared_Dirty");
+            std::cout << "    second process: " << shared / 1024
+                      << " MiB of the index shared" << std::endl;
+        });
+    });
+    bench::run_child([&] {
+        try
+        {
+            auto parts  = miopentensile::library_parts(miopentensile::library_path(arch));
+            auto before = bench::resident_memory_mb();
+            auto ms = bench::time_ms([&] { miopentensile::load_library(parts, 1); });
+            std::cout << "    load tensile library: " << ms << " ms, "
+                      << bench::resident_memory_mb() - before << " MiB resident" << std::endl;
+        }
+        catch(const std::exception& e)
+        {
+            std::cout << "    load tensile library: " << e.what() << std::endl;
+        }
+    });
+    std::remove(output.c_str());
+}
+
+int main(int argc, const char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <yaml directory> [arch]..." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> paths;
+    find_yaml(argv[1], paths);
+    std::vector<std::string> archs(argv + 2, argv + argc);
+    if(archs.empty())
+        archs = {"gfx906", "gfx908"};
+    // Later runs find the files in the page cache
+    for(auto&& p : paths)
+    {
+        std::ifstream is(p, std::ios::binary);
+        std::vector<char> buffer(1 << 20);
+        while(is.read(buffer.data(), buffer.size()))
+            ;
+    }
+    for(auto&& arch : archs)
+        run_arch(paths, arch);
+}
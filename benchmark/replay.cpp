@@ -0,0 +1,359 @@
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_problem.hpp>
+#include <miopentensile/problem.hpp>
+#include <miopentensile/solution_list.hpp>
+#include <miopentensile/trace.hpp>
+#include <miopentensile/tuning.hpp>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include "benchmark.hpp"
+#include "fixtures.hpp"
+
+// Replays gemm calls captured with MIOPEN_TENSILE_TRACE=<file> through problem
+// construction and selection, and reports the host cost and the solution
+// selected for each shape:
+//
+//     bench_replay [--arch gfx908] [--cu 120] [--runs 20] <trace.jsonl>...
+//
+// With --arch the device is faked and nothing is launched, so selections can
+// be compared between library versions on hosts without a gpu. Otherwise the
+// gemms also run on the current device on scratch buffers, and the measured
+// gflops are reported next to the gflops the logic tables predict.
+
+struct null_launcher : miopentensile::kernel_launcher
+{
+    void load_code_object(const std::string&) override {}
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>&, hipStream_t) override
+    {
+        return hipSuccess;
+    }
+};
+
+// The text of a field of a flat json object, without quotes for strings, or
+// an empty string when it is missing
+std::string json_field(const std::string& line, const std::string& name)
+{
+    auto key = "\"" + name + "\":";
+    auto i   = line.find(key);
+    if(i == std::string::npos)
+        return "";
+    i += key.size();
+    if(i < line.size() and line[i] == '"')
+    {
+        auto j = line.find('"', i + 1);
+        return line.substr(i + 1, j - i - 1);
+    }
+    auto j = line.find_first_of(",}]", i);
+    return line.substr(i, j - i);
+}
+
+std::size_t json_size(const std::string& line, const std::string& name)
+{
+    auto x = json_field(line, name);
+    return x.empty() ? 0 : std::stoull(x);
+}
+
+miopen_tensile_type parse_type(const std::string& name)
+{
+    for(auto t : {miopen_tensile_type_float,
+                  miopen_tensile_type_half,
+                  miopen_tensile_type_bfloat16,
+                  miopen_tensile_type_int8x4,
+                  miopen_tensile_type_int32})
+    {
+        if(name == miopentensile::type_name(t))
+            return t;
+    }
+    throw std::runtime_error("Unknown type: " + name);
+}
+
+// A matrix with unit stride along its contiguous dimension, in the layout
+// create_problem_key reads back as the same lengths and leading dimension
+miopen_tensile_matrix make_matrix(std::size_t rows,
+                                  std::size_t cols,
+                                  bool transposed,
+                                  std::size_t ld,
+                                  std::size_t batch,
+                                  std::size_t stride,
+                                  miopen_tensile_type type)
+{
+    auto result       = mitensile::make_matrix(rows, cols, type);
+    result.strides[0] = ld;
+    result.batch      = {batch, stride};
+    if(transposed)
+    {
+        result.strides[0] = 1;
+        result.strides[1] = ld;
+    }
+    return result;
+}
+
+struct captured_shape
+{
+    miopentensile::tensile_operands x;
+    double alpha              = 1.0;
+    double beta               = 0.0;
+    std::size_t max_workspace = 0;
+    std::uint64_t solution_id = 0;
+    std::size_t cu_count      = 0;
+    // The solution selected when the calls were captured
+    std::string solution;
+    std::size_t calls = 0;
+};
+
+struct replayed_shape
+{
+    miopentensile::gemm_plan_ptr plan;
+    double select_us       = 0;
+    double call_us         = 0;
+    double measured_gflops = 0;
+};
+
+// Shapes of the traced calls that ran one plan, keyed by everything that
+// selects a solution
+std::vector<captured_shape> read_capture(const std::vector<std::string>& files)
+{
+    std::unordered_map<miopentensile::problem_key, captured_shape, miopentensile::problem_key_hash>
+        shapes;
+    std::size_t skipped = 0;
+    for(auto&& file : files)
+    {
+        std::ifstream is(file);
+        if(not is)
+            throw std::runtime_error("Failed to open capture: " + file);
+        std::string line;
+        while(std::getline(is, line))
+        {
+            if(json_field(line, "m").empty() or json_field(line, "pointer_batched") == "1")
+            {
+                skipped++;
+                continue;
+            }
+            auto m     = json_size(line, "m");
+            auto n     = json_size(line, "n");
+            auto k     = json_size(line, "k");
+            auto batch = json_size(line, "batch");
+            captured_shape s;
+            s.x.a = make_matrix(k,
+                                m,
+                                json_field(line, "transpose_a") == "1",
+                                json_size(line, "lda"),
+                                batch,
+                                json_size(line, "stride_a"),
+                                parse_type(json_field(line, "type_a")));
+            s.x.b = make_matrix(n,
+                                k,
+                                json_field(line, "transpose_b") == "1",
+                                json_size(line, "ldb"),
+                                batch,
+                                json_size(line, "stride_b"),
+                                parse_type(json_field(line, "type_b")));
+            s.x.c = make_matrix(n,
+                                m,
+                                false,
+                                json_size(line, "ldc"),
+                                batch,
+                                json_size(line, "stride_c"),
+                                parse_type(json_field(line, "type_c")));
+            // Older captures only have the beta class
+            auto beta_class = json_field(line, "beta");
+            s.beta          = miopentensile::generic_beta;
+            if(beta_class == "zero")
+                s.beta = 0.0;
+            else if(beta_class == "one")
+                s.beta = 1.0;
+            if(not json_field(line, "beta_value").empty())
+            {
+                s.alpha = std::stod(json_field(line, "alpha"));
+                s.beta  = std::stod(json_field(line, "beta_value"));
+            }
+            s.max_workspace = json_size(line, "max_workspace");
+            if(json_field(line, "call") == "gemm_solution")
+                s.solution_id = std::stoull(json_field(line, "solution_id"), nullptr, 16);
+            s.cu_count = json_size(line, "cu_count");
+            s.solution = json_field(line, "solution");
+
+            auto key          = miopentensile::create_problem_key(s.x.a, s.x.b, s.x.c, s.beta, 0);
+            key.max_workspace = s.max_workspace;
+            key.solution_id   = s.solution_id;
+            key.cu_count      = s.cu_count;
+            auto it           = shapes.emplace(key, s).first;
+            it->second.calls++;
+        }
+    }
+    if(skipped > 0)
+        std::cout << skipped << " records without a single plan skipped" << std::endl;
+    std::vector<captured_shape> result;
+    for(auto&& p : shapes)
+        result.push_back(p.second);
+    std::sort(result.begin(), result.end(), [](auto&& x, auto&& y) { return x.calls > y.calls; });
+    return result;
+}
+
+replayed_shape replay(const captured_shape& s, int device, std::size_t runs, bool launch)
+{
+    replayed_shape result;
+    std::vector<double> select;
+    for(std::size_t i = 0; i < runs; i++)
+    {
+        select.push_back(bench::time_us([&] {
+            result.plan = miopentensile::create_gemm_plan(
+                s.x.a, s.x.b, s.x.c, s.beta, device, s.max_workspace, s.solution_id, s.cu_count);
+        }));
+    }
+    result.select_us = bench::percentile(select, 50);
+    if(result.plan->solution == nullptr)
+        return result;
+
+    // A call from the plan cache up to the kernel arguments
+    miopentensile::gemm_args args;
+    args.alpha = s.alpha;
+    args.beta  = s.beta;
+    std::vector<double> call;
+    auto& arena = miopentensile::thread_launch_arena();
+    for(std::size_t i = 0; i < runs; i++)
+    {
+        call.push_back(bench::time_us([&] {
+            auto p = miopentensile::get_gemm_plan(
+                s.x.a, s.x.b, s.x.c, s.beta, device, s.max_workspace, s.solution_id, s.cu_count);
+            p->solve(args, arena);
+        }));
+    }
+    result.call_us = bench::percentile(call, 50);
+
+    if(launch)
+    {
+        const auto& k = result.plan->key;
+        auto ms       = miopentensile::hip_solution_timer()->time(*result.plan, s.x);
+        result.measured_gflops = 2.0 * k.m * k.n * k.k * k.batch / (ms * 1.0e6);
+    }
+    return result;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string arch;
+    int cu_count     = 0;
+    std::size_t runs = 20;
+    std::vector<std::string> files;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--arch" and i + 1 < argc)
+            arch = argv[++i];
+        else if(arg == "--cu" and i + 1 < argc)
+            cu_count = std::stoi(argv[++i]);
+        else if(arg == "--runs" and i + 1 < argc)
+            runs = std::max<std::size_t>(std::stoul(argv[++i]), 1);
+        else
+            files.push_back(arg);
+    }
+    if(files.empty())
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--arch gfx908] [--cu 120] [--runs 20] <trace.jsonl>..." << std::endl;
+        return 1;
+    }
+    bool launch = arch.empty();
+    if(not launch)
+    {
+        if(cu_count == 0)
+            cu_count = bench::arch_cu_counts().count(arch) > 0 ? bench::arch_cu_counts().at(arch)
+                                                               : 64;
+        miopentensile::set_hardware_provider(
+            miopentensile::fake_hardware_provider(arch, cu_count));
+        miopentensile::set_kernel_launcher(std::make_shared<null_launcher>());
+        // Tuning would time candidates on the device
+        auto options       = miopentensile::default_tuning_options();
+        options.candidates = 0;
+        miopentensile::set_tuning_options(options);
+    }
+    auto device = miopentensile::current_device();
+    const auto& hw = *miopentensile::hardware().get(device);
+    std::cout << miopentensile::hardware_arch(hw) << ", " << miopentensile::hardware_cu_count(hw)
+              << " CUs, " << (launch ? "running on the device" : "host only") << std::endl;
+
+    auto shapes = read_capture(files);
+    std::size_t calls          = 0;
+    std::size_t unsolved       = 0;
+    std::size_t changed_shapes = 0;
+    std::size_t changed_calls  = 0;
+    double call_us             = 0;
+    double select_us           = 0;
+    double ratio_sum           = 0;
+    std::size_t ratio_calls    = 0;
+    std::map<std::string, std::size_t> sources;
+
+    std::cout << std::setw(8) << "calls" << std::setw(8) << "m" << std::setw(8) << "n"
+              << std::setw(8) << "k" << std::setw(6) << "batch" << std::setw(10) << "type"
+              << std::setw(7) << "beta" << std::setw(11) << "select_us" << std::setw(9)
+              << "call_us" << std::setw(14) << "source" << std::setw(11) << "predicted";
+    if(launch)
+        std::cout << std::setw(10) << "measured" << std::setw(7) << "ratio";
+    std::cout << "  solution" << std::endl;
+    for(auto&& s : shapes)
+    {
+        auto r        = replay(s, device, runs, launch);
+        const auto& k = r.plan->key;
+        calls += s.calls;
+        select_us += r.select_us;
+        call_us += r.call_us * s.calls;
+        std::string solution = "none";
+        if(r.plan->solution == nullptr)
+            unsolved++;
+        else
+            solution = r.plan->solution->kernelName;
+        sources[miopentensile::source_name(r.plan->source)] += s.calls;
+        bool changed = not s.solution.empty() and s.solution != solution;
+        if(changed)
+        {
+            changed_shapes++;
+            changed_calls += s.calls;
+        }
+
+        std::cout << std::setw(8) << s.calls << std::setw(8) << k.m << std::setw(8) << k.n
+                  << std::setw(8) << k.k << std::setw(6) << k.batch << std::setw(10)
+                  << miopentensile::type_name(k.type_a) << std::setw(7)
+                  << miopentensile::beta_name(k.beta) << std::setw(11) << std::fixed
+                  << std::setprecision(1) << r.select_us << std::setw(9) << r.call_us
+                  << std::setw(14) << miopentensile::source_name(r.plan->source) << std::setw(11)
+                  << r.plan->expected_gflops;
+        if(launch)
+        {
+            auto ratio = r.plan->expected_gflops > 0 ? r.measured_gflops / r.plan->expected_gflops
+                                                     : 0.0;
+            if(ratio > 0)
+            {
+                ratio_sum += ratio * s.calls;
+                ratio_calls += s.calls;
+            }
+            std::cout << std::setw(10) << r.measured_gflops << std::setw(7)
+                      << std::setprecision(2) << ratio;
+        }
+        std::cout << "  " << solution;
+        if(changed)
+            std::cout << " (captured " << s.solution << ")";
+        std::cout << std::endl;
+    }
+
+    std::cout << std::endl << calls << " calls, " << shapes.size() << " shapes, " << unsolved
+              << " without a solution" << std::endl;
+    if(calls == 0)
+        return 0;
+    std::cout << std::setprecision(2) << "host overhead " << call_us / calls
+              << " us/call from the plan cache, " << select_us / 1000.0
+              << " ms to select every shape once" << std::endl;
+    for(auto&& p : sources)
+        std::cout << "    " << p.first << ": " << 100.0 * p.second / calls << "% of calls"
+                  << std::endl;
+    std::cout << changed_shapes << " shapes (" << 100.0 * changed_calls / calls
+              << "% of calls) select a different solution than when captured" << std::endl;
+    if(ratio_calls > 0)
+        std::cout << "measured/predicted gflops " << ratio_sum / ratio_calls
+                  << " over calls with a prediction" << std::endl;
+}
@@ -0,0 +1,102 @@
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/logic_problem.hpp>
+#include <miopentensile/problem.hpp>
+#include <iostream>
+#include <set>
+#include "benchmark.hpp"
+
+// Replays the exact sizes of every logic file of an architecture through
+// create_tensile_problem and findBestSolution against a fake device, and
+// reports the library load cost and the selection latency. The same sizes
+// moved off the table time the nearest size lookup of the index. No gpu is
+// needed.
+//
+//     bench_selection [arch]...
+//
+// Each architecture runs in its own process so the load time and resident
+// memory are those of a cold start.
+
+void run_arch(const std::string& arch)
+{
+    auto baseline = bench::resident_memory_mb();
+    auto hw       = miopentensile::fake_hardware_provider(arch, bench::arch_cu_counts().at(arch))
+                  ->create_hardware(0);
+
+    const miopentensile::logic_index* index = nullptr;
+    auto index_ms = bench::time_ms([&] { index = miopentensile::library_index(arch); });
+    if(index == nullptr)
+    {
+        std::cout << arch << ": no logic index installed" << std::endl;
+        return;
+    }
+    const miopentensile::library_type* library = nullptr;
+    auto load_ms = bench::time_ms([&] { library = &miopentensile::library(arch); });
+    auto loaded  = bench::resident_memory_mb();
+
+    std::size_t nfiles  = 0;
+    std::size_t missing = 0;
+    std::vector<double> samples;
+    std::vector<double> nearest_samples;
+    for(std::size_t i = 0; i < index->type_count(); i++)
+    {
+        const auto& t = index->type(i);
+        miopen_tensile_type type;
+        if(t.cu_efficiency or arch != index->string(t.arch) or
+           not miopentensile::logic_input_type(t, type))
+            continue;
+        nfiles++;
+        for(auto&& e : index->entries_of(t))
+        {
+            auto x = miopentensile::logic_operands(t, e);
+            bool found = true;
+            samples.push_back(bench::time_us([&] {
+                auto problem = miopentensile::create_tensile_problem(x.a, x.b, x.c, 1.0);
+                found        = library->findBestSolution(problem, *hw) != nullptr;
+            }));
+            if(not found)
+                missing++;
+            nearest_samples.push_back(bench::time_us(
+                [&] { index->find_nearest(i, e.m + 1, e.n + 1, e.batch, e.k + 1); }));
+        }
+    }
+    std::cout << arch << ": " << nfiles << " logic files, " << samples.size() << " sizes, "
+              << missing << " without a solution" << std::endl;
+    std::cout << "    index open " << index_ms << " ms, library load " << load_ms << " ms, "
+              << loaded - baseline << " MiB resident after load" << std::endl;
+    std::cout << "    selection p50 " << bench::percentile(samples, 50) << " us, p99 "
+              << bench::percentile(samples, 99) << " us" << std::endl;
+    std::cout << "    nearest size p50 " << bench::percentile(nearest_samples, 50) << " us, p99 "
+              << bench::percentile(nearest_samples, 99) << " us" << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::set<std::string> archs;
+    for(int i = 1; i < argc; i++)
+        archs.insert(argv[i]);
+    if(archs.empty())
+    {
+        for(auto&& p : bench::arch_cu_counts())
+            archs.insert(p.first);
+    }
+    for(auto&& arch : archs)
+    {
+        if(bench::arch_cu_counts().count(arch) == 0)
+        {
+            std::cerr << "Unknown architecture: " << arch << std::endl;
+            continue;
+        }
+        bench::run_child([&] {
+            try
+            {
+                run_arch(arch);
+            }
+            catch(const std::exception& e)
+            {
+                std::cout << arch << ": " << e.what() << std::endl;
+            }
+        });
+    }
+}
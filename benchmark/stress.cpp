@@ -0,0 +1,189 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "benchmark.hpp"
+#include "fixtures.hpp"
+
+// Calls miopen_tensile_gemm_hip from many threads at once, each on its own
+// stream and cycling through differently shaped gemms, and reports how the
+// call rate scales with the threads. The device is faked and kernels are
+// dropped by a stub launcher, so only the host side runs.
+//
+//     bench_stress [arch] [max threads] [calls per thread]
+//
+// Threads double from one up to max threads, 64 by default. Half of the
+// streams are limited to fewer compute units, so two sets of plans are hit,
+// and while the threads run another one keeps changing the count of a stream
+// no thread uses. Cache misses after the first pass mean plans were created
+// again.
+
+struct null_launcher : miopentensile::kernel_launcher
+{
+    void load_code_object(const std::string&) override {}
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>&, hipStream_t) override
+    {
+        return hipSuccess;
+    }
+};
+
+struct gemm_shape
+{
+    miopen_tensile_matrix a;
+    miopen_tensile_matrix b;
+    miopen_tensile_matrix c;
+    double beta;
+};
+
+std::vector<gemm_shape> make_shapes()
+{
+    static const std::size_t sizes[] = {64, 128, 256, 512, 1024};
+    std::vector<gemm_shape> result;
+    for(auto type : {miopen_tensile_type_float, miopen_tensile_type_half})
+    {
+        for(std::size_t i = 0; i < 10; i++)
+        {
+            auto m = sizes[i % 5];
+            auto n = sizes[(i + 2) % 5];
+            auto k = sizes[(i * 3) % 5];
+            result.push_back({mitensile::make_matrix(m, k, type),
+                              mitensile::make_matrix(k, n, type),
+                              mitensile::make_matrix(m, n, type),
+                              i % 2 == 0 ? 0.0 : 1.0});
+        }
+    }
+    return result;
+}
+
+hipStream_t fake_stream(std::size_t i) { return reinterpret_cast<hipStream_t>(i + 1); }
+
+miopen_tensile_cache_stats cache_stats()
+{
+    miopen_tensile_cache_stats result{};
+    miopen_tensile_get_solution_cache_stats(&result);
+    return result;
+}
+
+struct run_result
+{
+    double ms            = 0;
+    std::size_t calls    = 0;
+    std::size_t failures = 0;
+    std::vector<double> latencies;
+};
+
+run_result run(const std::vector<gemm_shape>& shapes, std::size_t threads, std::size_t calls)
+{
+    std::vector<std::vector<double>> latencies(threads, std::vector<double>(calls));
+    std::vector<std::size_t> failures(threads);
+    std::atomic<std::size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> done{false};
+
+    // Changes the count of a stream no worker uses, so every worker refreshes
+    // its copy of the counts
+    std::thread churn([&] {
+        auto stream = fake_stream(threads);
+        for(std::size_t i = 0; not done; i++)
+        {
+            miopen_tensile_set_stream_cu_count(stream, i % 2 == 0 ? 32 : 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::vector<std::thread> workers;
+    for(std::size_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t] {
+            auto stream = fake_stream(t);
+            auto& out   = latencies[t];
+            ready++;
+            while(not go)
+                std::this_thread::yield();
+            for(std::size_t i = 0; i < calls; i++)
+            {
+                auto g     = shapes[(i + t) % shapes.size()];
+                auto start = bench::clock::now();
+                if(miopen_tensile_gemm_hip(stream, &g.a, &g.b, &g.c, 1.0, g.beta) !=
+                   miopen_tensile_status_success)
+                    failures[t]++;
+                out[i] = std::chrono::duration<double, std::micro>(bench::clock::now() - start)
+                             .count();
+            }
+        });
+    }
+    while(ready < threads)
+        std::this_thread::yield();
+    run_result result;
+    result.ms = bench::time_ms([&] {
+        go = true;
+        for(auto&& w : workers)
+            w.join();
+    });
+    done = true;
+    churn.join();
+    for(std::size_t t = 0; t < threads; t++)
+    {
+        result.calls += calls;
+        result.failures += failures[t];
+        result.latencies.insert(result.latencies.end(), latencies[t].begin(), latencies[t].end());
+    }
+    return result;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string arch        = argc > 1 ? argv[1] : "gfx908";
+    std::size_t max_threads = argc > 2 ? std::stoul(argv[2]) : 64;
+    std::size_t calls       = argc > 3 ? std::stoul(argv[3]) : 20000;
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 120));
+    miopentensile::set_kernel_launcher(std::make_shared<null_launcher>());
+
+    auto shapes = make_shapes();
+    for(std::size_t t = 0; t < max_threads; t++)
+    {
+        if(t % 2 == 1)
+            miopen_tensile_set_stream_cu_count(fake_stream(t), 60);
+    }
+    // Creates the plans of both compute unit counts
+    for(auto&& g : shapes)
+    {
+        for(std::size_t t = 0; t < std::min<std::size_t>(max_threads, 2); t++)
+        {
+            if(miopen_tensile_gemm_hip(fake_stream(t), &g.a, &g.b, &g.c, 1.0, g.beta) !=
+               miopen_tensile_status_success)
+            {
+                std::cerr << "No solution for every shape on " << arch << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::cout << arch << ", " << shapes.size() << " shapes, " << calls
+              << " calls per thread, " << std::thread::hardware_concurrency()
+              << " hardware threads" << std::endl;
+    double single = 0;
+    for(std::size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        auto before = cache_stats();
+        auto r      = run(shapes, threads, calls);
+        auto after  = cache_stats();
+        auto rate   = double(r.calls) / r.ms * 1000.0;
+        if(threads == 1)
+            single = rate;
+        auto p50 = bench::percentile(r.latencies, 50);
+        auto p99 = bench::percentile(r.latencies, 99);
+        std::cout << threads << " threads: " << rate << " calls/s, " << rate / single
+                  << "x of one thread, p50 " << p50 << " us, p99 " << p99 << " us, p99/p50 "
+                  << p99 / p50 << ", " << (after.misses - before.misses) << " misses";
+        if(r.failures > 0)
+            std::cout << ", " << r.failures << " failed";
+        std::cout << std::endl;
+        if(threads < max_threads and threads * 2 > max_threads)
+            threads = max_threads / 2;
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <hip/hip_runtime_api.h>
 
@@ -49,6 +50,231 @@ miopen_tensile_status miopen_tensile_gemm_hip(hipStream_t stream,
                                               double alpha, 
                                               double beta);
 
+/* Bytes of workspace needed by the fastest solution for the gemm, or zero if
+ * it needs none. The data pointers of a, b and c are ignored. */
+miopen_tensile_status miopen_tensile_gemm_get_workspace_size(miopen_tensile_matrix* a,
+                                                             miopen_tensile_matrix* b,
+                                                             miopen_tensile_matrix* c,
+                                                             double beta,
+                                                             size_t* workspace_size);
+
+/* Same as miopen_tensile_gemm_hip, but solutions may use up to workspace_size
+ * bytes of the device memory at workspace as scratch, which allows split-k
+ * solutions that accumulate into separate buffers. Only solutions that fit are
+ * selected. The workspace must not be used by other work until the gemm has
+ * completed on stream. */
+miopen_tensile_status miopen_tensile_gemm_workspace_hip(hipStream_t stream,
+                                                        miopen_tensile_matrix* a,
+                                                        miopen_tensile_matrix* b,
+                                                        miopen_tensile_matrix* c,
+                                                        double alpha,
+                                                        double beta,
+                                                        void* workspace,
+                                                        size_t workspace_size);
+
+typedef struct
+{
+    /* Hash of the kernel name, stable across processes and library builds */
+    uint64_t id;
+    /* Owned by the library and valid until the process exits */
+    const char* kernel_name;
+    /* Gflops measured when tuning the solution at the closest size it was
+     * tuned for, or zero if it was not tuned for this kind of gemm */
+    double predicted_gflops;
+    size_t workspace_size;
+} miopen_tensile_solution_info;
+
+/* Lists the solutions that can run the gemm, most promising first. At most
+ * max_count entries are written to solutions and count receives the number
+ * written. When solutions is null count receives the number available. The
+ * data pointers of a, b and c are ignored. */
+miopen_tensile_status miopen_tensile_gemm_find_solutions(miopen_tensile_matrix* a,
+                                                         miopen_tensile_matrix* b,
+                                                         miopen_tensile_matrix* c,
+                                                         double beta,
+                                                         miopen_tensile_solution_info* solutions,
+                                                         size_t max_count,
+                                                         size_t* count);
+
+/* Runs the gemm with the solution of the given id instead of selecting one.
+ * Returns miopen_tensile_status_no_solution if that solution cannot run the
+ * gemm or needs more than workspace_size bytes of workspace. */
+miopen_tensile_status miopen_tensile_gemm_solution_hip(hipStream_t stream,
+                                                       miopen_tensile_matrix* a,
+                                                       miopen_tensile_matrix* b,
+                                                       miopen_tensile_matrix* c,
+                                                       double alpha,
+                                                       double beta,
+                                                       uint64_t solution_id,
+                                                       void* workspace,
+                                                       size_t workspace_size);
+
+/* Gemm over batch_count items whose matrices are not evenly spaced. a, b and
+ * c describe a single item; their batch and data fields are ignored. a_ptrs,
+ * b_ptrs and c_ptrs are device arrays of batch_count pointers.
+ *
+ * When the library has no solution taking pointer arrays for the shape, the
+ * items run one gemm each instead. The pointer arrays are then copied to the
+ * host on stream, and the call waits for the stream to finish the work
+ * queued before it. Such calls are counted in pointer_batched_fallbacks of
+ * miopen_tensile_get_solution_cache_stats. */
+miopen_tensile_status miopen_tensile_gemm_batched_hip(hipStream_t stream,
+                                                      miopen_tensile_matrix* a,
+                                                      miopen_tensile_matrix* b,
+                                                      miopen_tensile_matrix* c,
+                                                      const void* const* a_ptrs,
+                                                      const void* const* b_ptrs,
+                                                      void* const* c_ptrs,
+                                                      size_t batch_count,
+                                                      double alpha,
+                                                      double beta);
+
+typedef struct
+{
+    miopen_tensile_matrix a;
+    miopen_tensile_matrix b;
+    miopen_tensile_matrix c;
+    double alpha;
+    double beta;
+} miopen_tensile_gemm_desc;
+
+/* Runs count independent gemms of possibly different shapes. Solutions are
+ * selected for the whole group before anything is launched, and the launch
+ * order follows the solutions rather than the array order, so no gemm of the
+ * group may read the output of another. */
+miopen_tensile_status miopen_tensile_gemm_grouped_hip(hipStream_t stream,
+                                                      miopen_tensile_gemm_desc* gemms,
+                                                      size_t count);
+
+/* A gemm of fixed shape and types with its solution and kernel arguments
+ * resolved up front. It executes on the device that was current when it was
+ * created and can be executed concurrently from several threads. */
+typedef struct miopen_tensile_gemm_plan_t* miopen_tensile_gemm_plan;
+
+/* The data pointers of a, b and c are ignored. The solution is selected to
+ * work with any beta, so it never uses kernels specialized for a beta of
+ * zero the way miopen_tensile_gemm_hip can, see
+ * miopen_tensile_gemm_plan_create_for_beta. */
+miopen_tensile_status miopen_tensile_gemm_plan_create(miopen_tensile_gemm_plan* plan,
+                                                      miopen_tensile_matrix* a,
+                                                      miopen_tensile_matrix* b,
+                                                      miopen_tensile_matrix* c);
+
+/* Same as miopen_tensile_gemm_plan_create, but the solution is selected for
+ * cu_count compute units of the device, as for a stream limited to them. */
+miopen_tensile_status miopen_tensile_gemm_plan_create_with_cu_count(miopen_tensile_gemm_plan* plan,
+                                                                    miopen_tensile_matrix* a,
+                                                                    miopen_tensile_matrix* b,
+                                                                    miopen_tensile_matrix* c,
+                                                                    size_t cu_count);
+
+/* Same as miopen_tensile_gemm_plan_create_with_cu_count, but the solution is
+ * selected for beta, so a beta of zero or one may get kernels specialized for
+ * it. Such a plan can then only be executed with that same beta, while a plan
+ * created for any other beta works with every beta. A cu_count of zero
+ * selects for the whole device. */
+miopen_tensile_status miopen_tensile_gemm_plan_create_for_beta(miopen_tensile_gemm_plan* plan,
+                                                               miopen_tensile_matrix* a,
+                                                               miopen_tensile_matrix* b,
+                                                               miopen_tensile_matrix* c,
+                                                               double beta,
+                                                               size_t cu_count);
+
+miopen_tensile_status miopen_tensile_gemm_plan_execute(miopen_tensile_gemm_plan plan,
+                                                       hipStream_t stream,
+                                                       const void* a,
+                                                       const void* b,
+                                                       void* c,
+                                                       double alpha,
+                                                       double beta);
+
+miopen_tensile_status miopen_tensile_gemm_plan_destroy(miopen_tensile_gemm_plan plan);
+
+/* The gflops measured when tuning the size the plan's solution was selected
+ * for. For sizes not in the tuning tables this is the closest tuned size.
+ * Zero when the selection did not come from a tuning table. */
+miopen_tensile_status miopen_tensile_gemm_plan_get_expected_gflops(miopen_tensile_gemm_plan plan,
+                                                                   double* gflops);
+
+/* Gemms launched on stream select solutions for cu_count compute units,
+ * for streams that share a device with other work. By default they select
+ * for the whole device, and a cu_count of zero restores that.
+ *
+ * Counts are kept by the value of the stream handle until they are cleared.
+ * Clear the count before destroying the stream, or a stream created later at
+ * the same address inherits it. */
+miopen_tensile_status miopen_tensile_set_stream_cu_count(hipStream_t stream, size_t cu_count);
+
+/* Sets the count of stream to the number of compute units enabled in its cu
+ * mask, which is queried once here rather than on every gemm. Clear it with
+ * miopen_tensile_set_stream_cu_count like any other count. */
+miopen_tensile_status miopen_tensile_set_stream_cu_count_from_mask(hipStream_t stream);
+
+typedef struct
+{
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t size;
+    /* Pointer batched gemms run item by item, see
+     * miopen_tensile_gemm_batched_hip */
+    size_t pointer_batched_fallbacks;
+} miopen_tensile_cache_stats;
+
+/* Starts loading the tensile library of the current device in the
+ * background and returns. Gemm calls made while it loads wait for it rather
+ * than loading it again. Without this the library is loaded by the first
+ * gemm call. */
+miopen_tensile_status miopen_tensile_initialize(void);
+
+/* Selects the solutions of count gemms expected later and loads their code
+ * objects, so that the first call of each shape does neither. The
+ * solutions are those of gemms on the current device and on streams that
+ * may use all of its compute units. Only the shapes, types and beta of the
+ * descriptors are used. Returns miopen_tensile_status_no_solution when a
+ * gemm has no solution, after warming the others. */
+miopen_tensile_status miopen_tensile_warmup(const miopen_tensile_gemm_desc* gemms, size_t count);
+
+typedef struct miopen_tensile_warmup_t* miopen_tensile_warmup_handle;
+
+/* Same as miopen_tensile_warmup, but runs on a background thread. The
+ * descriptors are copied, so the array may be freed once this returns. */
+miopen_tensile_status miopen_tensile_warmup_async(const miopen_tensile_gemm_desc* gemms,
+                                                  size_t count,
+                                                  miopen_tensile_warmup_handle* handle);
+
+/* Sets done to 1 when the warmup has finished, and then returns its status */
+miopen_tensile_status miopen_tensile_warmup_query(miopen_tensile_warmup_handle handle, int* done);
+
+/* Waits for the warmup to finish and returns its status */
+miopen_tensile_status miopen_tensile_warmup_wait(miopen_tensile_warmup_handle handle);
+
+/* Waits for the warmup to finish */
+miopen_tensile_status miopen_tensile_warmup_destroy(miopen_tensile_warmup_handle handle);
+
+/* Counters of the solution cache shared by all gemm calls in the process */
+miopen_tensile_status miopen_tensile_get_solution_cache_stats(miopen_tensile_cache_stats* stats);
+
+miopen_tensile_status miopen_tensile_clear_solution_cache(void);
+
+typedef enum {
+    miopen_tensile_backend_hip = 0, /*!< Tensile kernels on the current device */
+    miopen_tensile_backend_cpu = 1, /*!< Threads of the host */
+} miopen_tensile_backend;
+
+/* Selects where the gemms of the process run. The default is the hip
+ * backend, or the cpu backend when the library is built with
+ * MIOPEN_TENSILE_CPU_BACKEND, and the MIOPEN_TENSILE_BACKEND environment
+ * variable set to "cpu" or "hip" overrides it. On the cpu backend every
+ * pointer passed to the gemm functions, including the pointer arrays of
+ * batched gemms, is host memory, streams are ignored and each call has
+ * completed when it returns. It lists a single solution, needs no workspace
+ * and selects nothing, so plans and warmups only check the shapes. Not safe
+ * to call while other threads are running gemms. */
+miopen_tensile_status miopen_tensile_set_backend(miopen_tensile_backend backend);
+
+miopen_tensile_status miopen_tensile_get_backend(miopen_tensile_backend* backend);
+
 #ifdef __cplusplus
 }
 #endif
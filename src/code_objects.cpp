@@ -0,0 +1,160 @@
+#include <miopentensile/code_objects.hpp>
+#include <miopentensile/library.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <stdexcept>
+
+namespace miopentensile {
+
+// AMDGPU code object v2 kernel symbol type
+const unsigned char stt_amdgpu_hsa_kernel = 10;
+
+template <class T>
+T read_at(std::ifstream& is, std::size_t offset)
+{
+    T result;
+    is.seekg(offset);
+    is.read(reinterpret_cast<char*>(&result), sizeof(T));
+    if(not is)
+        throw std::runtime_error("Truncated ELF file");
+    return result;
+}
+
+std::vector<char> read_bytes(std::ifstream& is, std::size_t offset, std::size_t size)
+{
+    std::vector<char> result(size);
+    is.seekg(offset);
+    is.read(result.data(), size);
+    if(not is)
+        throw std::runtime_error("Truncated ELF file");
+    return result;
+}
+
+std::vector<std::string> code_object_kernels(const std::string& path)
+{
+    std::ifstream is(path, std::ios::binary);
+    if(not is)
+        throw std::runtime_error("Failed to open code object: " + path);
+    auto header = read_at<Elf64_Ehdr>(is, 0);
+    if(std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 or header.e_ident[EI_CLASS] != ELFCLASS64)
+        throw std::runtime_error("Not an ELF64 code object: " + path);
+
+    std::vector<Elf64_Shdr> sections(header.e_shnum);
+    for(std::size_t i = 0; i < sections.size(); i++)
+        sections[i] = read_at<Elf64_Shdr>(is, header.e_shoff + i * header.e_shentsize);
+
+    std::vector<std::string> result;
+    for(auto&& section : sections)
+    {
+        if(section.sh_type != SHT_SYMTAB and section.sh_type != SHT_DYNSYM)
+            continue;
+        if(section.sh_link >= sections.size() or section.sh_entsize == 0)
+            continue;
+        const auto& strtab = sections[section.sh_link];
+        auto names         = read_bytes(is, strtab.sh_offset, strtab.sh_size);
+        auto nsymbols      = section.sh_size / section.sh_entsize;
+        for(std::size_t i = 0; i < nsymbols; i++)
+        {
+            auto symbol = read_at<Elf64_Sym>(is, section.sh_offset + i * section.sh_entsize);
+            if(symbol.st_name >= names.size())
+                continue;
+            std::string name = names.data() + symbol.st_name;
+            auto type        = ELF64_ST_TYPE(symbol.st_info);
+            // Code object v3 describes each kernel with a name.kd object
+            const std::string kd = ".kd";
+            if(type == STT_OBJECT and name.size() > kd.size() and
+               name.compare(name.size() - kd.size(), kd.size(), kd) == 0)
+                result.push_back(name.substr(0, name.size() - kd.size()));
+            else if(type == stt_amdgpu_hsa_kernel)
+                result.push_back(name);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+bool code_object_matches_arch(const std::string& path, const std::string& arch)
+{
+    auto name     = path.substr(path.rfind('/') + 1);
+    auto is_alnum = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) != 0; };
+    auto target   = arch.substr(0, arch.find(':'));
+    bool any      = false;
+    for(auto i = name.find("gfx"); i != std::string::npos; i = name.find("gfx", i + 1))
+    {
+        any      = true;
+        auto end = i + 3;
+        while(end < name.size() and is_alnum(name[end]))
+            end++;
+        if(name.compare(i, end - i, target) == 0 and end - i == target.size())
+            return true;
+    }
+    return not any;
+}
+
+code_object_loader::code_object_loader(std::vector<std::string> code_objects, load_function f)
+    : files(std::move(code_objects)), load(std::move(f)), file_flags(new std::once_flag[files.size()])
+{
+}
+
+void code_object_loader::index_files()
+{
+    for(std::size_t i = 0; i < files.size(); i++)
+    {
+        for(auto&& name : code_object_kernels(files[i]))
+            kernels.emplace(name, i);
+    }
+}
+
+void code_object_loader::build_index()
+{
+    std::call_once(index_flag, [&] { index_files(); });
+}
+
+std::size_t code_object_loader::kernel_file(const std::string& name)
+{
+    build_index();
+    auto it = kernels.find(name);
+    if(it == kernels.end())
+        return npos;
+    return it->second;
+}
+
+bool code_object_loader::load_kernel(const std::string& name)
+{
+    auto i = kernel_file(name);
+    if(i == npos)
+        return false;
+    std::call_once(file_flags[i], [&] {
+        load(files[i]);
+        loads.fetch_add(1, std::memory_order_relaxed);
+    });
+    return true;
+}
+
+code_object_loader& code_objects(const std::string& arch)
+{
+    static std::mutex m;
+    static std::unordered_map<std::string, std::unique_ptr<code_object_loader>> loaders;
+    std::lock_guard<std::mutex> lock(m);
+    auto& loader = loaders[arch];
+    if(loader == nullptr)
+    {
+        auto files = library_code_objects(library_path(arch));
+        files.erase(std::remove_if(files.begin(),
+                                   files.end(),
+                                   [&](auto&& f) {
+                                       return not arch.empty() and
+                                              not code_object_matches_arch(f, arch);
+                                   }),
+                    files.end());
+        loader = std::make_unique<code_object_loader>(
+            std::move(files), [](const std::string& f) { launcher().load_code_object(f); });
+    }
+    return *loader;
+}
+
+} // namespace miopentensile
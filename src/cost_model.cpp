@@ -0,0 +1,222 @@
+#include <miopentensile/cost_model.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace miopentensile {
+
+device_params default_device_params(const std::string& arch)
+{
+    static const std::pair<const char*, device_params> devices[] = {
+        {"gfx803", {64, 1050}},
+        {"gfx900", {64, 1500}},
+        {"gfx906", {60, 1800}},
+        {"gfx908", {120, 1502}},
+        {"gfx90a", {104, 1700}},
+        {"gfx1010", {40, 1905}},
+        {"gfx1011", {36, 1725}},
+        {"gfx1012", {22, 1845}},
+        {"gfx1030", {80, 2250}},
+    };
+    auto name = arch.substr(0, arch.find(':'));
+    for(auto&& d : devices)
+    {
+        if(name == d.first)
+            return d.second;
+    }
+    return {};
+}
+
+std::size_t logic_type_size(int data_type)
+{
+    switch(data_type)
+    {
+    case 1:
+    case 2: return 8;
+    case 3: return 16;
+    case 4:
+    case 7: return 2;
+    default: return 4;
+    }
+}
+
+double ceil_div(double x, double y) { return std::ceil(x / y); }
+
+cost_estimate predict_cost(const logic_index::solution_record& s,
+                           const cost_problem& x,
+                           const device_params& device,
+                           const cost_params& params)
+{
+    cost_estimate r;
+    double m     = std::max<std::uint64_t>(x.m, 1);
+    double n     = std::max<std::uint64_t>(x.n, 1);
+    double batch = std::max<std::uint64_t>(x.batch, 1);
+    double k     = std::max<std::uint64_t>(x.k, 1);
+    double mt0   = std::max(s.macro_tile0, 1);
+    double mt1   = std::max(s.macro_tile1, 1);
+    double du    = std::max(s.depth_u, 1);
+    double gsu   = std::max(s.global_split_u, 1);
+    double cus   = std::max<std::size_t>(device.cu_count, 1);
+
+    auto tiles0       = ceil_div(m, mt0);
+    auto tiles1       = ceil_div(n, mt1);
+    auto workgroups   = tiles0 * tiles1 * batch * gsu;
+    r.waves           = ceil_div(workgroups, cus);
+    r.tile_efficiency = m * n / (tiles0 * mt0 * tiles1 * mt1);
+    // Each split runs whole iterations of the unrolled loop over its part of k
+    auto k_split = ceil_div(ceil_div(k, gsu), du) * du;
+    double vw    = std::max(s.vector_width, 1);
+    auto compute = r.waves * mt0 * mt1 * k_split * 2 /
+                   (params.flops_per_cycle / (1 + params.vector_cost / vw));
+
+    // The workgroups of a wave run over bands of tiles as wide as the
+    // workgroup mapping, and tiles of a batch and split in the same row or
+    // column share their reads
+    auto wave  = std::min(tiles0 * tiles1, cus);
+    auto band  = std::min<double>(std::max(std::abs(s.workgroup_mapping), 1), tiles1);
+    auto rows  = std::min(tiles0, ceil_div(wave, band));
+    auto cols  = std::min(tiles1, band * ceil_div(wave, tiles0 * band));
+    auto reads = workgroups / wave * (rows * mt0 + cols * mt1) * k_split * x.input_bytes;
+    // Split k writes partial results and reads them back to reduce them
+    auto writes = m * n * batch * x.output_bytes * (gsu > 1 ? 2 * gsu : 1);
+    r.bytes     = reads + writes;
+    // The read cost is relative to reads of 4 bytes per thread
+    double read_width = std::max(s.global_read_vector_width, 1) * x.input_bytes;
+    auto memory = r.bytes / (params.bytes_per_cycle / (1 + params.read_cost * 4 / read_width));
+
+    auto cycles = std::max(compute, memory) + r.waves * params.wave_cycles;
+    r.seconds   = cycles / (std::max(device.clock_mhz, 1.0) * 1e6);
+    r.gflops    = 2 * m * n * k * batch / r.seconds / 1e9;
+    return r;
+}
+
+cost_problem entry_problem(const logic_index::type_record& t, const logic_index::entry_record& e)
+{
+    cost_problem result;
+    result.m            = e.m;
+    result.n            = e.n;
+    result.batch        = e.batch;
+    result.k            = e.k;
+    result.input_bytes  = logic_type_size(t.data_type);
+    result.output_bytes = logic_type_size(t.dest_data_type);
+    return result;
+}
+
+// The parameters are searched in log space since their scales differ widely
+std::array<double, 5> to_logs(const cost_params& p)
+{
+    return {{std::log(p.flops_per_cycle),
+             std::log(p.bytes_per_cycle),
+             std::log(p.wave_cycles),
+             std::log(p.vector_cost),
+             std::log(p.read_cost)}};
+}
+
+cost_params from_logs(const std::array<double, 5>& x)
+{
+    cost_params result;
+    result.flops_per_cycle = std::exp(x[0]);
+    result.bytes_per_cycle = std::exp(x[1]);
+    result.wave_cycles     = std::exp(x[2]);
+    result.vector_cost     = std::exp(x[3]);
+    result.read_cost       = std::exp(x[4]);
+    return result;
+}
+
+cost_params calibrate_cost_model(const logic_index& index,
+                                 std::size_t type,
+                                 const device_params& device,
+                                 const std::function<bool(const logic_index::entry_record&)>& use)
+{
+    // Large tables are sampled evenly to bound the time of the fit
+    const std::size_t max_samples = 4096;
+    const auto& t                 = index.type(type);
+    std::vector<const logic_index::entry_record*> used;
+    for(auto&& e : index.entries_of(t))
+    {
+        if(e.gflops > 0 and use(e))
+            used.push_back(&e);
+    }
+    if(used.empty())
+        return {};
+    std::vector<std::pair<const logic_index::solution_record*, cost_problem>> samples;
+    std::vector<double> measured;
+    auto step = std::max<std::size_t>(used.size() / max_samples, 1);
+    for(std::size_t i = 0; i < used.size(); i += step)
+    {
+        samples.emplace_back(&index.solution(used[i]->solution), entry_problem(t, *used[i]));
+        measured.push_back(std::log(used[i]->gflops));
+    }
+
+    // Squared error of the log of the gflops, minimized one parameter at a
+    // time with steps that shrink when no parameter improves
+    auto error = [&](const std::array<double, 5>& logs) {
+        auto params   = from_logs(logs);
+        double result = 0;
+        for(std::size_t i = 0; i < samples.size(); i++)
+        {
+            auto e = predict_cost(*samples[i].first, samples[i].second, device, params);
+            auto d = std::log(e.gflops) - measured[i];
+            result += d * d;
+        }
+        return result;
+    };
+    auto logs   = to_logs(cost_params{});
+    auto best   = error(logs);
+    double jump = 2.0;
+    for(int round = 0; round < 200 and jump > 1e-3; round++)
+    {
+        bool improved = false;
+        for(auto& x : logs)
+        {
+            for(double direction : {1.0, -1.0})
+            {
+                auto previous = x;
+                x += direction * jump;
+                auto e = error(logs);
+                if(e < best)
+                {
+                    best     = e;
+                    improved = true;
+                    break;
+                }
+                x = previous;
+            }
+        }
+        if(not improved)
+            jump /= 2;
+    }
+    return from_logs(logs);
+}
+
+std::vector<logic_index_format::cost_record> calibrate_logic_index(const logic_index& index)
+{
+    // Too few measurements to fit the parameters to
+    const std::size_t min_entries = 16;
+    std::vector<logic_index_format::cost_record> result(index.type_count());
+    for(std::size_t type = 0; type < index.type_count(); type++)
+    {
+        if(index.type(type).entry_count < min_entries)
+            continue;
+        auto device  = default_device_params(index.string(index.type(type).arch));
+        auto p       = calibrate_cost_model(index, type, device, [](auto&&) { return true; });
+        result[type] = {
+            p.flops_per_cycle, p.bytes_per_cycle, p.wave_cycles, p.vector_cost, p.read_cost};
+    }
+    return result;
+}
+
+bool logic_cost_params(const logic_index& index, std::size_t type, cost_params& result)
+{
+    const auto& c = index.type(type).cost;
+    if(c.flops_per_cycle <= 0 or c.bytes_per_cycle <= 0)
+        return false;
+    result.flops_per_cycle = c.flops_per_cycle;
+    result.bytes_per_cycle = c.bytes_per_cycle;
+    result.wave_cycles     = c.wave_cycles;
+    result.vector_cost     = c.vector_cost;
+    result.read_cost       = c.read_cost;
+    return true;
+}
+
+} // namespace miopentensile
@@ -0,0 +1,503 @@
+#include <miopentensile/cpu_gemm.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <Tensile/Tensile.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace miopentensile {
+
+miopen_tensile_backend default_backend()
+{
+    const char* value = std::getenv("MIOPEN_TENSILE_BACKEND");
+    if(value != nullptr and std::strcmp(value, "cpu") == 0)
+        return miopen_tensile_backend_cpu;
+    if(value != nullptr and std::strcmp(value, "hip") == 0)
+        return miopen_tensile_backend_hip;
+#ifdef MIOPEN_TENSILE_CPU_BACKEND
+    return miopen_tensile_backend_cpu;
+#else
+    return miopen_tensile_backend_hip;
+#endif
+}
+
+std::atomic<miopen_tensile_backend>& backend()
+{
+    static std::atomic<miopen_tensile_backend> result{default_backend()};
+    return result;
+}
+
+miopen_tensile_backend current_backend() { return backend().load(std::memory_order_relaxed); }
+
+void set_backend(miopen_tensile_backend b) { backend().store(b, std::memory_order_relaxed); }
+
+std::size_t cpu_threads()
+{
+    static const auto result =
+        env_size("MIOPEN_TENSILE_CPU_THREADS", std::thread::hardware_concurrency());
+    return std::max<std::size_t>(result, 1);
+}
+
+const std::string& cpu_solution_name()
+{
+    static const std::string result = "MIOpenTensile_CPU_Gemm";
+    return result;
+}
+
+std::uint64_t cpu_solution_id()
+{
+    return fnv1a(cpu_solution_name().data(), cpu_solution_name().size());
+}
+
+// Offsets of the elements of a or b by batch, row or column across k, and
+// k. Int8x4 matrices are described in bytes, with four consecutive values of
+// k packed together; their offsets are in bytes of the packed layout, where
+// the strides larger than the one of k count packed elements.
+struct operand_layout
+{
+    std::size_t batch_stride = 0;
+    std::size_t outer_stride = 0;
+    std::size_t k_stride     = 0;
+    std::size_t lanes        = 1;
+
+    std::size_t offset(std::size_t batch, std::size_t outer, std::size_t k) const
+    {
+        return lanes * (batch * batch_stride + outer * outer_stride + k / lanes * k_stride) +
+               k % lanes;
+    }
+};
+
+operand_layout make_layout(const miopen_tensile_matrix& m, std::size_t k_axis)
+{
+    operand_layout result;
+    result.batch_stride = m.batch.stride;
+    result.outer_stride = m.strides[1 - k_axis];
+    result.k_stride     = m.strides[k_axis];
+    if(m.type == miopen_tensile_type_int8x4)
+    {
+        result.lanes = 4;
+        if(result.outer_stride > result.k_stride)
+            result.outer_stride /= 4;
+        result.batch_stride /= 4;
+    }
+    return result;
+}
+
+bool packs_int8x4(const miopen_tensile_matrix& m, std::size_t k_axis, bool batched)
+{
+    auto outer = m.strides[1 - k_axis];
+    if(outer > m.strides[k_axis] and outer % 4 != 0)
+        return false;
+    return not batched or m.batch.stride % 4 == 0;
+}
+
+miopen_tensile_status cpu_gemm_supported(const miopen_tensile_matrix& a,
+                                         const miopen_tensile_matrix& b,
+                                         const miopen_tensile_matrix& c)
+{
+    if(a.lens[1] != b.lens[0])
+        throw std::runtime_error("K dimensions do not match");
+    if(a.lens[0] != c.lens[0])
+        throw std::runtime_error("M dimensions do not match");
+    if(b.lens[1] != c.lens[1])
+        throw std::runtime_error("N dimensions do not match");
+    auto out = a.type == miopen_tensile_type_int8x4 ? miopen_tensile_type_int32 : a.type;
+    if(a.type == miopen_tensile_type_int32 or b.type != a.type or c.type != out)
+    {
+        std::cerr << "No solution found." << std::endl;
+        return miopen_tensile_status_no_solution;
+    }
+    if(a.type == miopen_tensile_type_int8x4)
+    {
+        auto batched = c.batch.num > 1;
+        if(a.lens[1] % 4 != 0 or not packs_int8x4(a, 1, batched) or
+           not packs_int8x4(b, 0, batched))
+        {
+            std::cerr << "Invalid int8 problem size." << std::endl;
+            return miopen_tensile_status_no_solution;
+        }
+    }
+    return miopen_tensile_status_success;
+}
+
+float load(float x) { return x; }
+float load(Tensile::Half x) { return static_cast<float>(x); }
+float load(Tensile::BFloat16 x) { return static_cast<float>(x); }
+std::int32_t load(std::int8_t x) { return x; }
+double load(std::int32_t x) { return x; }
+
+// Threads kept for the cpu gemms, so a call only wakes them instead of
+// starting threads. The calling thread takes tasks too. A gemm that finds the
+// pool running another one runs its tasks alone, as the cores are busy then.
+class cpu_pool
+{
+    public:
+    explicit cpu_pool(std::size_t threads)
+    {
+        for(std::size_t t = 0; t < threads; t++)
+            workers.emplace_back([this] { work(); });
+    }
+
+    ~cpu_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for(auto&& w : workers)
+            w.join();
+    }
+
+    // Runs f(x, i) for each i below n and rethrows the first exception thrown
+    void run(std::size_t n, void (*f)(const void*, std::size_t), const void* x)
+    {
+        std::unique_lock<std::mutex> busy(running, std::try_to_lock);
+        if(n < 2 or workers.empty() or not busy.owns_lock())
+        {
+            for(std::size_t i = 0; i < n; i++)
+                f(x, i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task       = f;
+            task_arg   = x;
+            task_count = n;
+            next       = 0;
+            error      = nullptr;
+            active     = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        take();
+        std::unique_lock<std::mutex> lock(mutex);
+        // Every worker has seen this generation before the next one starts
+        done.wait(lock, [&] { return active == 0; });
+        if(error != nullptr)
+            std::rethrow_exception(error);
+    }
+
+    private:
+    void take()
+    {
+        for(auto i = next++; i < task_count; i = next++)
+        {
+            try
+            {
+                task(task_arg, i);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(error == nullptr)
+                    error = std::current_exception();
+            }
+        }
+    }
+
+    void work()
+    {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;)
+        {
+            wake.wait(lock, [&] { return stop or generation != seen; });
+            if(stop)
+                return;
+            seen = generation;
+            lock.unlock();
+            take();
+            lock.lock();
+            if(--active == 0)
+                done.notify_all();
+        }
+    }
+
+    std::mutex running;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    void (*task)(const void*, std::size_t) = nullptr;
+    const void* task_arg                   = nullptr;
+    std::size_t task_count                 = 0;
+    std::atomic<std::size_t> next{0};
+    std::size_t active       = 0;
+    std::uint64_t generation = 0;
+    bool stop                = false;
+    std::exception_ptr error = nullptr;
+    std::vector<std::thread> workers;
+};
+
+cpu_pool& thread_pool()
+{
+    static cpu_pool result{cpu_threads() - 1};
+    return result;
+}
+
+// Rows and columns of the panels, and the sizes of the blocks of c and of k
+// a task works on. A 6 x 8 block of float accumulators fits in the 16 vector
+// registers of sse. The blocks are whole numbers of panels.
+const std::size_t cpu_mr = 6;
+const std::size_t cpu_nr = 8;
+const std::size_t cpu_mc = 96;
+const std::size_t cpu_nc = 256;
+const std::size_t cpu_kc = 256;
+
+// Packed panel gemm in the style of the BLAS libraries. Each task computes
+// one block of c of one batch item: for each block of k it copies the rows of
+// a and columns of b it needs, converted to the accumulation type, into
+// panels stored along k, and multiplies every pair of panels with the micro
+// kernel, which keeps a cpu_mr x cpu_nr block of c in registers. The inner
+// loop of the micro kernel runs over contiguous values so the compiler
+// vectorizes it.
+template <class T, class Acc, class Out, class Scalar>
+struct cpu_engine
+{
+    const T* a;
+    const T* b;
+    Out* c;
+    operand_layout la;
+    operand_layout lb;
+    std::size_t m;
+    std::size_t n;
+    std::size_t k;
+    std::size_t batch;
+    std::size_t ldc;
+    std::size_t c_col_stride;
+    std::size_t c_batch_stride;
+    double alpha;
+    double beta;
+
+    // Panels of a block are zero past the edge of the matrix, so the micro
+    // kernel always runs on whole panels
+    void pack_a(Acc* out, std::size_t bi, std::size_t i0, std::size_t rows, std::size_t k0,
+                std::size_t depth) const
+    {
+        for(std::size_t p = 0; p < rows; p += cpu_mr)
+        {
+            for(std::size_t kk = 0; kk < depth; kk++)
+            {
+                for(std::size_t r = 0; r < cpu_mr; r++)
+                    out[r] = p + r < rows ? load(a[la.offset(bi, i0 + p + r, k0 + kk)]) : Acc(0);
+                out += cpu_mr;
+            }
+        }
+    }
+
+    void pack_b(Acc* out, std::size_t bi, std::size_t j0, std::size_t cols, std::size_t k0,
+                std::size_t depth) const
+    {
+        for(std::size_t q = 0; q < cols; q += cpu_nr)
+        {
+            for(std::size_t kk = 0; kk < depth; kk++)
+            {
+                for(std::size_t j = 0; j < cpu_nr; j++)
+                    out[j] = q + j < cols ? load(b[lb.offset(bi, j0 + q + j, k0 + kk)]) : Acc(0);
+                out += cpu_nr;
+            }
+        }
+    }
+
+    static void micro_kernel(const Acc* pa, const Acc* pb, std::size_t depth, Acc* tile)
+    {
+        Acc acc[cpu_mr][cpu_nr] = {};
+        for(std::size_t kk = 0; kk < depth; kk++)
+        {
+            for(std::size_t r = 0; r < cpu_mr; r++)
+            {
+                for(std::size_t j = 0; j < cpu_nr; j++)
+                    acc[r][j] += pa[r] * pb[j];
+            }
+            pa += cpu_mr;
+            pb += cpu_nr;
+        }
+        for(std::size_t r = 0; r < cpu_mr; r++)
+        {
+            for(std::size_t j = 0; j < cpu_nr; j++)
+                tile[r * cpu_nc + j] += acc[r][j];
+        }
+    }
+
+    void run_block(std::size_t bi, std::size_t i0, std::size_t j0) const
+    {
+        // Reused by the blocks a thread runs, and the threads are kept by the
+        // pool, so steady state calls do not allocate
+        thread_local std::vector<Acc> pa;
+        thread_local std::vector<Acc> pb;
+        thread_local std::vector<Acc> tile;
+        pa.resize(cpu_mc * cpu_kc);
+        pb.resize(cpu_nc * cpu_kc);
+        tile.assign(cpu_mc * cpu_nc, Acc(0));
+        auto rows = std::min(cpu_mc, m - i0);
+        auto cols = std::min(cpu_nc, n - j0);
+        for(std::size_t k0 = 0; k0 < k; k0 += cpu_kc)
+        {
+            auto depth = std::min(cpu_kc, k - k0);
+            pack_a(pa.data(), bi, i0, rows, k0, depth);
+            pack_b(pb.data(), bi, j0, cols, k0, depth);
+            for(std::size_t p = 0; p < rows; p += cpu_mr)
+            {
+                for(std::size_t q = 0; q < cols; q += cpu_nr)
+                    micro_kernel(&pa[p * depth], &pb[q * depth], depth, &tile[p * cpu_nc + q]);
+            }
+        }
+        auto scalar_alpha = load(Scalar(alpha));
+        auto scalar_beta  = load(Scalar(beta));
+        for(std::size_t i = 0; i < rows; i++)
+        {
+            for(std::size_t j = 0; j < cols; j++)
+            {
+                auto& x = c[bi * c_batch_stride + (i0 + i) * ldc + (j0 + j) * c_col_stride];
+                auto d  = double(scalar_alpha) * double(tile[i * cpu_nc + j]);
+                // A beta of zero does not read c, which may be uninitialized
+                if(beta != 0)
+                    d += double(scalar_beta) * double(load(x));
+                x = Out(d);
+            }
+        }
+    }
+
+    static void run_task(const void* engine, std::size_t x)
+    {
+        const auto& e   = *static_cast<const cpu_engine*>(engine);
+        auto row_blocks = (e.m + cpu_mc - 1) / cpu_mc;
+        auto col_blocks = (e.n + cpu_nc - 1) / cpu_nc;
+        auto bi         = x / (row_blocks * col_blocks);
+        auto i          = x / col_blocks % row_blocks;
+        auto j          = x % col_blocks;
+        e.run_block(bi, i * cpu_mc, j * cpu_nc);
+    }
+
+    void run() const
+    {
+        auto row_blocks = (m + cpu_mc - 1) / cpu_mc;
+        auto col_blocks = (n + cpu_nc - 1) / cpu_nc;
+        thread_pool().run(batch * row_blocks * col_blocks, &run_task, this);
+    }
+};
+
+template <class T, class Acc, class Out, class Scalar = Out>
+void run_cpu_gemm(const miopen_tensile_matrix& a,
+                  const miopen_tensile_matrix& b,
+                  const miopen_tensile_matrix& c,
+                  const void* a_data,
+                  const void* b_data,
+                  void* c_data,
+                  double alpha,
+                  double beta)
+{
+    cpu_engine<T, Acc, Out, Scalar> e;
+    e.a              = static_cast<const T*>(a_data);
+    e.b              = static_cast<const T*>(b_data);
+    e.c              = static_cast<Out*>(c_data);
+    e.la             = make_layout(a, 1);
+    e.lb             = make_layout(b, 0);
+    e.m              = c.lens[0];
+    e.n              = c.lens[1];
+    e.k              = a.lens[1];
+    e.batch          = std::max({a.batch.num, b.batch.num, c.batch.num, std::size_t{1}});
+    e.ldc            = c.strides[0];
+    e.c_col_stride   = c.strides[1];
+    e.c_batch_stride = c.batch.stride;
+    e.alpha          = alpha;
+    e.beta           = beta;
+    if(e.m == 0 or e.n == 0)
+        return;
+    e.run();
+}
+
+miopen_tensile_status cpu_gemm(const miopen_tensile_matrix& a,
+                               const miopen_tensile_matrix& b,
+                               const miopen_tensile_matrix& c,
+                               const void* a_data,
+                               const void* b_data,
+                               void* c_data,
+                               double alpha,
+                               double beta)
+{
+    auto status = cpu_gemm_supported(a, b, c);
+    if(status != miopen_tensile_status_success)
+        return status;
+    switch(a.type)
+    {
+    case miopen_tensile_type_float:
+        run_cpu_gemm<float, float, float>(a, b, c, a_data, b_data, c_data, alpha, beta);
+        break;
+    case miopen_tensile_type_half:
+        run_cpu_gemm<Tensile::Half, float, Tensile::Half>(
+            a, b, c, a_data, b_data, c_data, alpha, beta);
+        break;
+    case miopen_tensile_type_bfloat16:
+        run_cpu_gemm<Tensile::BFloat16, float, Tensile::BFloat16, float>(
+            a, b, c, a_data, b_data, c_data, alpha, beta);
+        break;
+    case miopen_tensile_type_int8x4:
+        run_cpu_gemm<std::int8_t, std::int32_t, std::int32_t>(
+            a, b, c, a_data, b_data, c_data, alpha, beta);
+        break;
+    case miopen_tensile_type_int32: break;
+    }
+    return miopen_tensile_status_success;
+}
+
+miopen_tensile_status cpu_gemm_pointer_batched(const miopen_tensile_matrix& a,
+                                               const miopen_tensile_matrix& b,
+                                               const miopen_tensile_matrix& c,
+                                               const void* const* a_ptrs,
+                                               const void* const* b_ptrs,
+                                               void* const* c_ptrs,
+                                               std::size_t batch_count,
+                                               double alpha,
+                                               double beta)
+{
+    auto single = [](miopen_tensile_matrix m) {
+        m.batch = miopen_tensile_batch{1, 0};
+        return m;
+    };
+    auto sa     = single(a);
+    auto sb     = single(b);
+    auto sc     = single(c);
+    auto status = cpu_gemm_supported(sa, sb, sc);
+    for(std::size_t i = 0; i < batch_count and status == miopen_tensile_status_success; i++)
+        status = cpu_gemm(sa, sb, sc, a_ptrs[i], b_ptrs[i], c_ptrs[i], alpha, beta);
+    return status;
+}
+
+miopen_tensile_status cpu_gemm_supported(const miopen_tensile_gemm_desc* gemms, std::size_t count)
+{
+    auto result = miopen_tensile_status_success;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const auto& g = gemms[i];
+        if(cpu_gemm_supported(g.a, g.b, g.c) != miopen_tensile_status_success)
+            result = miopen_tensile_status_no_solution;
+    }
+    return result;
+}
+
+miopen_tensile_status cpu_gemm_grouped(const miopen_tensile_gemm_desc* gemms, std::size_t count)
+{
+    auto status = cpu_gemm_supported(gemms, count);
+    if(status != miopen_tensile_status_success)
+        return status;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const auto& g = gemms[i];
+        auto status   = cpu_gemm(g.a, g.b, g.c, g.a.data, g.b.data, g.c.data, g.alpha, g.beta);
+        if(status != miopen_tensile_status_success)
+            return status;
+    }
+    return miopen_tensile_status_success;
+}
+
+} // namespace miopentensile
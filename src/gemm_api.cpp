@@ -1,28 +1,18 @@
 #include <miopentensile/gemm.h>
-#include <Tensile/Tensile.hpp>
-#include <Tensile/Contractions.hpp>
-#include <Tensile/EmbeddedLibrary.hpp>
-#include <Tensile/hip/HipHardware.hpp>
-#include <Tensile/hip/HipSolutionAdapter.hpp>
-#include <dlfcn.h>
-#include <glob.h>
-
-#define MIOT_DEBUG_PRINTOUTS 0
-
-std::vector<std::string> glob_files(const std::string& s)
-{
-    std::vector<std::string> result;
-    glob_t raw_glob_result;
-    int e = glob(s.c_str(), GLOB_TILDE_CHECK | GLOB_NOSORT, nullptr, &raw_glob_result);
-    std::shared_ptr<std::remove_pointer_t<glob_t>> glob_result(&raw_glob_result, &globfree);
-
-    if (e != 0)
-        throw std::runtime_error("Glob failed: " + s);
-
-    for(std::size_t i = 0; i < glob_result->gl_pathc; ++i)
-        result.push_back(glob_result->gl_pathv[i]);
-    return result;
-}
+#include <miopentensile/cpu_gemm.hpp>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/problem.hpp>
+#include <miopentensile/solution_list.hpp>
+#include <miopentensile/trace.hpp>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 
 template<class T>
 auto& deref(T* x)
@@ -32,271 +22,474 @@ auto& deref(T* x)
     return *x;
 }
 
-std::string library_path()
+template<class F>
+miopen_tensile_status try_(F f)
 {
-    std::string path = "";
-    Dl_info info;
-
-    // Find the location of .so
-    if(dladdr((void*)miopen_tensile_gemm_hip, &info))
+    try
     {
-        path = info.dli_fname;
-        auto i = path.rfind('/');
-        if (i != std::string::npos)
-            path = path.substr(0, i);
-        else
-            path = "";
+        return f();
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "MIOpenTensile error: " << e.what() << std::endl;
+        return miopen_tensile_status_unknown;
+    }
+    catch(...)
+    {
+        return miopen_tensile_status_unknown;
     }
-    return path + "/miopentensile/library/";
 }
 
-auto create_library()
+// Gemm with the matrices in gemm api operand order on the cpu backend
+miopen_tensile_status cpu_gemm(miopen_tensile_matrix* a,
+                               miopen_tensile_matrix* b,
+                               miopen_tensile_matrix* c,
+                               double alpha,
+                               double beta)
 {
-    return Tensile::LoadLibraryFile<Tensile::ContractionProblem>(library_path() +
-#if TENSILE_USE_LLVM && !TENSILE_USE_MSGPACK
-        "TensileLibrary.yaml"
-#else
-        "TensileLibrary.dat"
-#endif
-        );
-    // return Tensile::EmbeddedLibrary<Tensile::ContractionProblem>::NewLibrary("miopen_tensile_kernels");
+    return try_([&] {
+        const auto& x = deref(a);
+        const auto& y = deref(b);
+        const auto& z = deref(c);
+        return miopentensile::cpu_gemm(x, y, z, x.data, y.data, z.data, alpha, beta);
+    });
 }
 
-const auto& library()
+// The cpu backend selects nothing, so warming up only checks the shapes
+miopen_tensile_status warmup(const miopen_tensile_gemm_desc* gemms, std::size_t count, int device)
 {
-    static auto result = create_library();
-    assert(result != nullptr);
-    return *result;
+    if (miopentensile::use_cpu_backend())
+        return miopentensile::cpu_gemm_supported(gemms, count);
+    return miopentensile::warmup_gemms(gemms, count, device);
 }
 
-auto create_adaptor() {
-    // Workaround: The Tensile::hip::SolutionAdapter is not a regular type, so heap allocate it instead
-    auto a = std::make_shared<Tensile::hip::SolutionAdapter>();
-    for(auto&& f:glob_files(library_path() + "*co"))
-        a->loadCodeObjectFile(f);
-    return a;
+int warmup_device()
+{
+    return miopentensile::use_cpu_backend() ? 0 : miopentensile::current_device();
 }
 
-auto& adaptor()
+struct miopen_tensile_gemm_plan_t
+{
+    miopentensile::gemm_plan_ptr plan;
+    // Plans of the cpu backend keep the matrices instead
+    bool cpu = false;
+    miopen_tensile_matrix a{};
+    miopen_tensile_matrix b{};
+    miopen_tensile_matrix c{};
+    miopentensile::beta_class beta = miopentensile::beta_other;
+};
+
+struct miopen_tensile_warmup_t
 {
-    static auto result = create_adaptor();
-    return *result;
+    std::vector<miopen_tensile_gemm_desc> gemms;
+    std::shared_future<miopen_tensile_status> status;
+};
+
+extern "C" {
+
+miopen_tensile_status miopen_tensile_gemm_hip(hipStream_t stream, 
+                                              miopen_tensile_matrix* a, 
+                                              miopen_tensile_matrix* b, 
+                                              miopen_tensile_matrix* c, 
+                                              double alpha, 
+                                              double beta)
+{
+    miopentensile::trace_call trace{"gemm"};
+    trace.scalars(alpha, beta);
+    if (miopentensile::use_cpu_backend())
+        return trace.finish(cpu_gemm(a, b, c, alpha, beta));
+    return trace.finish(try_([&] {
+        auto plan = miopentensile::get_gemm_plan(deref(b),
+                                                 deref(a),
+                                                 deref(c),
+                                                 beta,
+                                                 miopentensile::current_device(),
+                                                 0,
+                                                 0,
+                                                 miopentensile::stream_cu_count(stream));
+        trace.planned(plan);
+        return plan->execute(stream, {b->data, a->data, c->data, alpha, beta});
+    }));
 }
 
+miopen_tensile_status miopen_tensile_gemm_get_workspace_size(miopen_tensile_matrix* a,
+                                                             miopen_tensile_matrix* b,
+                                                             miopen_tensile_matrix* c,
+                                                             double beta,
+                                                             size_t* workspace_size)
+{
+    return try_([&] {
+        if (miopentensile::use_cpu_backend())
+        {
+            auto status = miopentensile::cpu_gemm_supported(deref(a), deref(b), deref(c));
+            if (status == miopen_tensile_status_success)
+                deref(workspace_size) = 0;
+            return status;
+        }
+        auto plan = miopentensile::get_gemm_plan(deref(b),
+                                                 deref(a),
+                                                 deref(c),
+                                                 beta,
+                                                 miopentensile::current_device(),
+                                                 std::numeric_limits<size_t>::max());
+        if (plan->solution == nullptr)
+        {
+            std::cerr << "No solution found." << std::endl;
+            return miopen_tensile_status_no_solution;
+        }
+        deref(workspace_size) = plan->workspace_size;
+        return miopen_tensile_status_success;
+    });
+}
 
-bool is_transposed(const miopen_tensile_matrix& a)
+miopen_tensile_status miopen_tensile_gemm_workspace_hip(hipStream_t stream,
+                                                        miopen_tensile_matrix* a,
+                                                        miopen_tensile_matrix* b,
+                                                        miopen_tensile_matrix* c,
+                                                        double alpha,
+                                                        double beta,
+                                                        void* workspace,
+                                                        size_t workspace_size)
 {
-    return a.strides[1] > a.strides[0];
+    miopentensile::trace_call trace{"gemm_workspace"};
+    trace.scalars(alpha, beta);
+    if (miopentensile::use_cpu_backend())
+        return trace.finish(cpu_gemm(a, b, c, alpha, beta));
+    return trace.finish(try_([&] {
+        if (workspace == nullptr)
+            workspace_size = 0;
+        auto plan = miopentensile::get_gemm_plan(deref(b),
+                                                 deref(a),
+                                                 deref(c),
+                                                 beta,
+                                                 miopentensile::current_device(),
+                                                 workspace_size,
+                                                 0,
+                                                 miopentensile::stream_cu_count(stream));
+        trace.planned(plan);
+        return plan->execute(stream, {b->data, a->data, c->data, alpha, beta, workspace});
+    }));
 }
 
-size_t get_idx(const miopen_tensile_matrix& a, size_t n)
+miopen_tensile_status miopen_tensile_gemm_find_solutions(miopen_tensile_matrix* a,
+                                                         miopen_tensile_matrix* b,
+                                                         miopen_tensile_matrix* c,
+                                                         double beta,
+                                                         miopen_tensile_solution_info* solutions,
+                                                         size_t max_count,
+                                                         size_t* count)
 {
-    return (n + (is_transposed(a) ? 1 : 0)) % 2;
+    return try_([&] {
+        if (miopentensile::use_cpu_backend())
+        {
+            auto status = miopentensile::cpu_gemm_supported(deref(a), deref(b), deref(c));
+            std::size_t n = status == miopen_tensile_status_success ? 1 : 0;
+            if (solutions != nullptr)
+            {
+                n = std::min<std::size_t>(n, max_count);
+                if (n > 0)
+                    solutions[0] = miopen_tensile_solution_info{
+                        miopentensile::cpu_solution_id(),
+                        miopentensile::cpu_solution_name().c_str(),
+                        0,
+                        0};
+            }
+            deref(count) = n;
+            return miopen_tensile_status_success;
+        }
+        auto found = miopentensile::find_solutions(
+            deref(b), deref(a), deref(c), beta, miopentensile::current_device());
+        if (solutions == nullptr)
+        {
+            deref(count) = found.size();
+            return miopen_tensile_status_success;
+        }
+        auto n = std::min(max_count, found.size());
+        for (std::size_t i = 0; i < n; i++)
+        {
+            solutions[i] = miopen_tensile_solution_info{found[i].id,
+                                                        found[i].solution->kernelName.c_str(),
+                                                        found[i].predicted_gflops,
+                                                        found[i].workspace_size};
+        }
+        deref(count) = n;
+        return miopen_tensile_status_success;
+    });
 }
 
-size_t get_ld(const miopen_tensile_matrix& a)
+miopen_tensile_status miopen_tensile_gemm_solution_hip(hipStream_t stream,
+                                                       miopen_tensile_matrix* a,
+                                                       miopen_tensile_matrix* b,
+                                                       miopen_tensile_matrix* c,
+                                                       double alpha,
+                                                       double beta,
+                                                       uint64_t solution_id,
+                                                       void* workspace,
+                                                       size_t workspace_size)
 {
-    return a.strides[get_idx(a, 0)];
+    miopentensile::trace_call trace{"gemm_solution"};
+    trace.scalars(alpha, beta);
+    return trace.finish(try_([&] {
+        if (solution_id == 0)
+            return miopen_tensile_status_no_solution;
+        if (miopentensile::use_cpu_backend())
+        {
+            if (solution_id != miopentensile::cpu_solution_id())
+                return miopen_tensile_status_no_solution;
+            return cpu_gemm(a, b, c, alpha, beta);
+        }
+        if (workspace == nullptr)
+            workspace_size = 0;
+        auto plan = miopentensile::get_gemm_plan(deref(b),
+                                                 deref(a),
+                                                 deref(c),
+                                                 beta,
+                                                 miopentensile::current_device(),
+                                                 workspace_size,
+                                                 solution_id,
+                                                 miopentensile::stream_cu_count(stream));
+        trace.planned(plan);
+        return plan->execute(stream, {b->data, a->data, c->data, alpha, beta, workspace});
+    }));
 }
 
-Tensile::DataType get_data_type(const miopen_tensile_matrix& a)
+miopen_tensile_status miopen_tensile_gemm_batched_hip(hipStream_t stream,
+                                                      miopen_tensile_matrix* a,
+                                                      miopen_tensile_matrix* b,
+                                                      miopen_tensile_matrix* c,
+                                                      const void* const* a_ptrs,
+                                                      const void* const* b_ptrs,
+                                                      void* const* c_ptrs,
+                                                      size_t batch_count,
+                                                      double alpha,
+                                                      double beta)
 {
-    switch(a.type)
-    {
-    case miopen_tensile_type_float: return Tensile::DataType::Float;
-    case miopen_tensile_type_half: return Tensile::DataType::Half;
-    case miopen_tensile_type_int8x4: return Tensile::DataType::Int8x4;
-    case miopen_tensile_type_int32: return Tensile::DataType::Int32;
-    case miopen_tensile_type_bfloat16: return Tensile::DataType::BFloat16;
-    }
+    miopentensile::trace_call trace{"gemm_batched"};
+    return trace.finish(try_([&] {
+        if (miopentensile::use_cpu_backend())
+            return miopentensile::cpu_gemm_pointer_batched(
+                deref(a), deref(b), deref(c), a_ptrs, b_ptrs, c_ptrs, batch_count, alpha, beta);
+        return miopentensile::gemm_pointer_batched(
+            stream, deref(b), deref(a), deref(c), b_ptrs, a_ptrs, c_ptrs, batch_count, alpha, beta);
+    }));
 }
 
-miopen_tensile_matrix transpose(const miopen_tensile_matrix& a)
+miopen_tensile_status miopen_tensile_gemm_grouped_hip(hipStream_t stream,
+                                                      miopen_tensile_gemm_desc* gemms,
+                                                      size_t count)
 {
-    return miopen_tensile_matrix{{a.lens[1], a.lens[0]}, {a.strides[1], a.strides[0]}};
+    miopentensile::trace_call trace{"gemm_grouped"};
+    return trace.finish(try_([&] {
+        if (count > 0 and gemms == nullptr)
+            throw std::runtime_error("Dereference null pointer");
+        if (miopentensile::use_cpu_backend())
+            return miopentensile::cpu_gemm_grouped(gemms, count);
+        return miopentensile::gemm_grouped(stream, gemms, count);
+    }));
 }
 
-Tensile::ContractionProblem create_tensile_problem(const miopen_tensile_matrix& a, const miopen_tensile_matrix& b, const miopen_tensile_matrix& c)
+miopen_tensile_status miopen_tensile_gemm_plan_create(miopen_tensile_gemm_plan* plan,
+                                                      miopen_tensile_matrix* a,
+                                                      miopen_tensile_matrix* b,
+                                                      miopen_tensile_matrix* c)
 {
-    if (a.lens[0] != b.lens[1])
-      throw std::runtime_error("K dimensions do not match");
-    if (a.lens[1] != c.lens[1])
-      throw std::runtime_error("M dimensions do not match");
-    if (b.lens[0] != c.lens[0])
-      throw std::runtime_error("N dimensions do not match");
+    return miopen_tensile_gemm_plan_create_with_cu_count(plan, a, b, c, 0);
+}
 
-    if (a.batch.num > 1 or b.batch.num > 1 or c.batch.num > 1 or a.type != miopen_tensile_type_float or b.type != miopen_tensile_type_float or c.type != miopen_tensile_type_float)
-    {
-        auto batch = std::max({a.batch.num, b.batch.num, c.batch.num, std::size_t{1}});
-        auto k = a.lens[0];
-        auto lda = get_ld(a);
-        auto ldb = get_ld(b);
-        auto stride_a = a.batch.stride;
-        auto stride_b = b.batch.stride;
-        if(a.type == miopen_tensile_type_int8x4)
+miopen_tensile_status miopen_tensile_gemm_plan_create_with_cu_count(miopen_tensile_gemm_plan* plan,
+                                                                    miopen_tensile_matrix* a,
+                                                                    miopen_tensile_matrix* b,
+                                                                    miopen_tensile_matrix* c,
+                                                                    size_t cu_count)
+{
+    return miopen_tensile_gemm_plan_create_for_beta(
+        plan, a, b, c, miopentensile::generic_beta, cu_count);
+}
+
+miopen_tensile_status miopen_tensile_gemm_plan_create_for_beta(miopen_tensile_gemm_plan* plan,
+                                                               miopen_tensile_matrix* a,
+                                                               miopen_tensile_matrix* b,
+                                                               miopen_tensile_matrix* c,
+                                                               double beta,
+                                                               size_t cu_count)
+{
+    miopentensile::trace_call trace{"plan_create"};
+    return trace.finish(try_([&] {
+        if (miopentensile::use_cpu_backend())
         {
-            if(k % 4 != 0 || (is_transposed(a) && (lda % 4 != 0))|| (!is_transposed(b) && (ldb % 4 != 0))|| (c.batch.num > 1 && (a.batch.stride % 4 != 0 || b.batch.stride % 4 != 0)))
-            {
-                std::cerr << "Invalid int8 problem size." << std::endl;
-                return Tensile::ContractionProblem{};
-            }
-            else
-            {
-                k /= 4;
-                lda = !is_transposed(a) ? lda : lda / 4;
-                ldb = !is_transposed(b) ? ldb / 4 : ldb;
-                stride_a /= 4;
-                stride_b /= 4;
-            }
+            auto status = miopentensile::cpu_gemm_supported(deref(a), deref(b), deref(c));
+            if (status == miopen_tensile_status_success)
+                deref(plan) = new miopen_tensile_gemm_plan_t{
+                    nullptr, true, *a, *b, *c, miopentensile::get_beta_class(beta)};
+            return status;
         }
-#if MIOT_DEBUG_PRINTOUTS
-	printf("\n");
-        printf("tensile gemm_strides\n");
-        printf("is_transposed(a)  %d\n", int(is_transposed(a)));
-        printf("is_transposed(b)  %d\n", int(is_transposed(b)));
-        printf("is_transposed(c)  %d\n", int(is_transposed(c)));
-        printf("a.lens[0]  %zu\n", a.lens[0]);
-        printf("a.lens[1]  %zu\n", a.lens[1]);
-        printf("b.lens[0]  %zu\n", b.lens[0]);
-        printf("b.lens[1]  %zu\n", b.lens[1]);
-        printf("batch  %zu\n", batch);
-        printf("get_ld(a)  %zu\n", get_ld(a));
-        printf("lda  %zu\n", lda);
-        printf("a.batch.stride  %zu\n", a.batch.stride);
-        printf("get_ld(b)  %zu\n", get_ld(b));
-        printf("ldb  %zu\n", ldb);
-        printf("b.batch.stride  %zu\n", b.batch.stride);
-        printf("get_ld(c)  %zu\n", get_ld(c));
-        printf("c.batch.stride  %zu\n", c.batch.stride);
-        printf("\n"); 
-	printf("c.lens[0]  %zu\n", c.lens[0]);
-        printf("c.lens[1]  %zu\n", c.lens[1]);
-        printf("M  %zu\n", a.lens[1]);
-        printf("N  %zu\n", b.lens[0]);
-        printf("K  %zu\n", a.lens[0]);
-        printf("\n");
-#endif
-
-        auto problem = Tensile::ContractionProblem::GEMM_Strides(is_transposed(a), 
-                                                                 is_transposed(b), 
-                                                                 get_data_type(a), 
-                                                                 get_data_type(b), 
-                                                                 get_data_type(c), 
-                                                                 get_data_type(c), 
-                                                                 a.lens[1],
-                                                                 b.lens[0],
-                                                                 k,
-                                                                 batch,
-                                                                 lda,
-                                                                 stride_a,
-                                                                 ldb,
-                                                                 stride_b,
-                                                                 get_ld(c),
-                                                                 c.batch.stride,
-                                                                 get_ld(c),
-                                                                 c.batch.stride,
-                                                                 1.0);
-
-        if (a.type == miopen_tensile_type_half || a.type == miopen_tensile_type_bfloat16 || a.type == miopen_tensile_type_int8x4)
-            problem.setHighPrecisionAccumulate(true);
-
-        return problem;
-    }
-    else
-    {
-#if MIOT_DEBUG_PRINTOUTS
-        printf("\n");
-        printf("tensile gemm\n");
-        printf("is_transposed(a)  %d\n", int(is_transposed(a)));
-        printf("is_transposed(b)  %d\n", int(is_transposed(b)));
-        printf("is_transposed(c)  %d\n", int(is_transposed(c)));
-        printf("a.lens[0]  %zu\n", a.lens[0]);
-        printf("a.lens[1]  %zu\n", a.lens[1]);
-        printf("b.lens[0]  %zu\n", b.lens[0]);
-        printf("b.lens[1]  %zu\n", b.lens[1]);
-        printf("get_ld(a)  %zu\n", get_ld(a));
-        printf("a.batch.stride  %zu\n", a.batch.stride);
-        printf("get_ld(b)  %zu\n", get_ld(b));
-        printf("b.batch.stride  %zu\n", b.batch.stride);
-        printf("get_ld(c)  %zu\n", get_ld(c));
-        printf("c.batch.stride  %zu\n", c.batch.stride);
-        printf("\n");
-        printf("c.lens[0]  %zu\n", c.lens[0]);
-        printf("c.lens[1]  %zu\n", c.lens[1]);
-        printf("M  %zu\n", a.lens[1]);
-        printf("N  %zu\n", b.lens[0]);
-        printf("K  %zu\n", a.lens[0]);
-
-        printf("\n");
-#endif
-
-        return Tensile::ContractionProblem::GEMM(is_transposed(a),
-                                                 is_transposed(b), 
-                                                 a.lens[1],
-                                                 b.lens[0],
-                                                 a.lens[0],
-                                                 get_ld(a), 
-                                                 get_ld(b), 
-                                                 get_ld(c), 
-                                                 1.0, 
-                                                 false, 
-                                                 1);
-    }
+        auto p = miopentensile::get_gemm_plan(deref(b),
+                                              deref(a),
+                                              deref(c),
+                                              beta,
+                                              miopentensile::current_device(),
+                                              0,
+                                              0,
+                                              cu_count);
+        trace.planned(p);
+        if (p->solution == nullptr)
+        {
+            std::cerr << "No solution found." << std::endl;
+            return miopen_tensile_status_no_solution;
+        }
+        deref(plan) = new miopen_tensile_gemm_plan_t{p, false, {}, {}, {}, p->key.beta};
+        return miopen_tensile_status_success;
+    }));
 }
 
-template <typename A, typename B = A, typename C = A, typename D = C, typename Alpha = C, typename Beta = C>
-miopen_tensile_status launch_kernels(hipStream_t& stream, 
-                                     Tensile::ContractionProblem& problem, 
-                                     std::shared_ptr<Tensile::Hardware>& hardware, 
-                                     std::shared_ptr<Tensile::ContractionProblem::Solution>& solution, 
-                                     miopen_tensile_matrix* a, 
-                                     miopen_tensile_matrix* b, 
-                                     miopen_tensile_matrix* c,
-                                     double alpha, 
-                                     double beta)
-{
-    Tensile::TypedContractionInputs<A, B, C, D, Alpha, Beta> inputs;
-    inputs.a = reinterpret_cast<const A*>(b->data);
-    inputs.b = reinterpret_cast<const B*>(a->data);
-    inputs.c = reinterpret_cast<const C*>(c->data);
-    inputs.d = reinterpret_cast<D*>(c->data);
-    inputs.alpha = Alpha(alpha);
-    inputs.beta = Beta(beta);
-    auto kernels = solution->solve(problem, inputs, *hardware);
-    adaptor().launchKernels(kernels, stream, nullptr, nullptr);
+miopen_tensile_status miopen_tensile_gemm_plan_execute(miopen_tensile_gemm_plan plan,
+                                                       hipStream_t stream,
+                                                       const void* a,
+                                                       const void* b,
+                                                       void* c,
+                                                       double alpha,
+                                                       double beta)
+{
+    miopentensile::trace_call trace{"plan_execute"};
+    trace.scalars(alpha, beta);
+    return trace.finish(try_([&] {
+        if (deref(plan).beta != miopentensile::beta_other and
+            miopentensile::get_beta_class(beta) != plan->beta)
+            throw std::runtime_error("Plan was created for a different beta");
+        if (plan->cpu)
+            return miopentensile::cpu_gemm(plan->a, plan->b, plan->c, a, b, c, alpha, beta);
+        trace.planned(plan->plan);
+        return plan->plan->execute(stream, {b, a, c, alpha, beta});
+    }));
+}
+
+miopen_tensile_status miopen_tensile_gemm_plan_destroy(miopen_tensile_gemm_plan plan)
+{
+    delete plan;
     return miopen_tensile_status_success;
 }
 
-extern "C" {
+miopen_tensile_status miopen_tensile_gemm_plan_get_expected_gflops(miopen_tensile_gemm_plan plan,
+                                                                   double* gflops)
+{
+    return try_([&] {
+        const auto& p = deref(plan).plan;
+        deref(gflops) = p == nullptr ? 0 : p->expected_gflops;
+        return miopen_tensile_status_success;
+    });
+}
 
-miopen_tensile_status miopen_tensile_gemm_hip(hipStream_t stream, 
-                                              miopen_tensile_matrix* a, 
-                                              miopen_tensile_matrix* b, 
-                                              miopen_tensile_matrix* c, 
-                                              double alpha, 
-                                              double beta)
+miopen_tensile_status miopen_tensile_set_stream_cu_count(hipStream_t stream, size_t cu_count)
 {
-    auto problem = create_tensile_problem(deref(b), deref(a), deref(c));
-    auto hardware = Tensile::hip::GetCurrentDevice();
-    auto solution = library().findBestSolution(problem, *hardware);
-    if (not solution)
-    {
-        std::cerr << "No solution found." << std::endl;
-        return miopen_tensile_status_no_solution;
-    }
-    switch(a->type)
-    {
-    case miopen_tensile_type_float:
-        return launch_kernels<float>(stream, problem, hardware, solution, a, b, c, alpha, beta);
-    case miopen_tensile_type_half:
-        return launch_kernels<Tensile::Half>(stream, problem, hardware, solution, a, b, c, alpha, beta);
-    case miopen_tensile_type_int8x4:
-        return launch_kernels<Tensile::Int8x4, Tensile::Int8x4, int32_t>(stream, problem, hardware, solution, a, b, c, alpha, beta);
-    case miopen_tensile_type_int32:
-        return miopen_tensile_status_no_solution;
-    case miopen_tensile_type_bfloat16:
-        return launch_kernels<Tensile::BFloat16, Tensile::BFloat16, Tensile::BFloat16, Tensile::BFloat16, float, float>(stream, problem, hardware, solution, a, b, c, alpha, beta);
-    }
+    return try_([&] {
+        miopentensile::set_stream_cu_count(stream, cu_count);
+        return miopen_tensile_status_success;
+    });
+}
+
+miopen_tensile_status miopen_tensile_set_stream_cu_count_from_mask(hipStream_t stream)
+{
+    return try_([&] {
+        miopentensile::set_stream_cu_count_from_mask(stream);
+        return miopen_tensile_status_success;
+    });
+}
+
+miopen_tensile_status miopen_tensile_initialize()
+{
+    return try_([&] {
+        if (miopentensile::use_cpu_backend())
+            return miopen_tensile_status_success;
+        miopentensile::initialize_library(
+            miopentensile::hardware_arch(*miopentensile::hardware().current()));
+        return miopen_tensile_status_success;
+    });
+}
+
+miopen_tensile_status miopen_tensile_warmup(const miopen_tensile_gemm_desc* gemms, size_t count)
+{
+    return try_([&] {
+        if (count > 0 and gemms == nullptr)
+            throw std::runtime_error("Dereference null pointer");
+        return warmup(gemms, count, warmup_device());
+    });
+}
+
+miopen_tensile_status miopen_tensile_warmup_async(const miopen_tensile_gemm_desc* gemms,
+                                                  size_t count,
+                                                  miopen_tensile_warmup_handle* handle)
+{
+    return try_([&] {
+        if (count > 0 and gemms == nullptr)
+            throw std::runtime_error("Dereference null pointer");
+        auto& result = deref(handle);
+        auto w       = std::make_unique<miopen_tensile_warmup_t>();
+        w->gemms     = {gemms, gemms + count};
+        // The device is that of the calling thread, not the background one
+        auto device = warmup_device();
+        auto* g     = w.get();
+        w->status   = std::async(std::launch::async, [=] {
+                        return try_([&] {
+                            return warmup(g->gemms.data(), g->gemms.size(), device);
+                        });
+                    }).share();
+        result = w.release();
+        return miopen_tensile_status_success;
+    });
+}
+
+miopen_tensile_status miopen_tensile_warmup_query(miopen_tensile_warmup_handle handle, int* done)
+{
+    return try_([&] {
+        const auto& status = deref(handle).status;
+        deref(done) = status.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+        return *done ? status.get() : miopen_tensile_status_success;
+    });
+}
+
+miopen_tensile_status miopen_tensile_warmup_wait(miopen_tensile_warmup_handle handle)
+{
+    return try_([&] { return deref(handle).status.get(); });
+}
+
+miopen_tensile_status miopen_tensile_warmup_destroy(miopen_tensile_warmup_handle handle)
+{
+    if (handle != nullptr)
+        handle->status.wait();
+    delete handle;
+    return miopen_tensile_status_success;
+}
+
+miopen_tensile_status miopen_tensile_get_solution_cache_stats(miopen_tensile_cache_stats* stats)
+{
+    return try_([&] {
+        auto s       = miopentensile::plan_cache_stats();
+        deref(stats) = miopen_tensile_cache_stats{
+            s.hits, s.misses, s.evictions, s.size, miopentensile::pointer_batched_fallbacks()};
+        return miopen_tensile_status_success;
+    });
+}
+
+miopen_tensile_status miopen_tensile_clear_solution_cache()
+{
+    miopentensile::clear_plan_cache();
+    return miopen_tensile_status_success;
+}
+
+miopen_tensile_status miopen_tensile_set_backend(miopen_tensile_backend backend)
+{
+    if (backend != miopen_tensile_backend_hip and backend != miopen_tensile_backend_cpu)
+        return miopen_tensile_status_unknown;
+    miopentensile::set_backend(backend);
+    return miopen_tensile_status_success;
+}
+
+miopen_tensile_status miopen_tensile_get_backend(miopen_tensile_backend* backend)
+{
+    return try_([&] {
+        deref(backend) = miopentensile::current_backend();
+        return miopen_tensile_status_success;
+    });
 }
 
 }
@@ -0,0 +1,712 @@
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_problem.hpp>
+#include <miopentensile/problem.hpp>
+#include <miopentensile/solution_list.hpp>
+#include <miopentensile/trace.hpp>
+#include <miopentensile/tuning.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <unordered_map>
+
+namespace miopentensile {
+
+template <class T>
+double sentinel(unsigned char byte)
+{
+    unsigned char bytes[sizeof(T)];
+    std::memset(bytes, byte, sizeof(T));
+    T x;
+    std::memcpy(&x, bytes, sizeof(T));
+    return static_cast<double>(x);
+}
+
+template <class T>
+void encode(double x, unsigned char* out)
+{
+    T y = T(x);
+    std::memcpy(out, &y, sizeof(T));
+}
+
+template <class A,
+          class B     = A,
+          class C     = A,
+          class D     = C,
+          class Alpha = C,
+          class Beta  = C>
+struct typed_solver
+{
+    static std::vector<Tensile::KernelInvocation> solve(const gemm_plan& p, const gemm_args& args)
+    {
+        Tensile::TypedContractionInputs<A, B, C, D, Alpha, Beta> inputs;
+        if(p.pointer_batched)
+        {
+            inputs.batchA = reinterpret_cast<const A* const*>(args.a);
+            inputs.batchB = reinterpret_cast<const B* const*>(args.b);
+            inputs.batchC = reinterpret_cast<const C* const*>(args.c);
+            inputs.batchD = reinterpret_cast<D* const*>(args.c);
+        }
+        else
+        {
+            inputs.a = reinterpret_cast<const A*>(args.a);
+            inputs.b = reinterpret_cast<const B*>(args.b);
+            inputs.c = reinterpret_cast<const C*>(args.c);
+            inputs.d = reinterpret_cast<D*>(args.c);
+        }
+        inputs.alpha = Alpha(args.alpha);
+        inputs.beta  = Beta(args.beta);
+        inputs.ws    = args.workspace;
+        return p.solution->solve(p.problem, inputs, *p.hardware);
+    }
+
+    static void encode_scalars(const gemm_args& args, scalar_bytes& out)
+    {
+        encode<Alpha>(args.alpha, out.alpha);
+        encode<Beta>(args.beta, out.beta);
+    }
+
+    // Arguments whose bytes are all equal to byte, so two sets built from
+    // different bytes differ in every byte of every field
+    static gemm_args sentinel_args(unsigned char byte)
+    {
+        gemm_args result;
+        std::memset(&result.a, byte, sizeof(result.a));
+        std::memset(&result.b, byte, sizeof(result.b));
+        std::memset(&result.c, byte, sizeof(result.c));
+        std::memset(&result.workspace, byte, sizeof(result.workspace));
+        result.alpha = sentinel<Alpha>(byte);
+        result.beta  = sentinel<Beta>(byte);
+        return result;
+    }
+
+    static std::size_t field_size(arg_patch::field_type f)
+    {
+        switch(f)
+        {
+        case arg_patch::alpha: return sizeof(Alpha);
+        case arg_patch::beta: return sizeof(Beta);
+        case arg_patch::a:
+        case arg_patch::b:
+        case arg_patch::c:
+        case arg_patch::workspace: break;
+        }
+        return sizeof(void*);
+    }
+};
+
+void set_field(gemm_args& x, const gemm_args& y, arg_patch::field_type f)
+{
+    switch(f)
+    {
+    case arg_patch::a: x.a = y.a; return;
+    case arg_patch::b: x.b = y.b; return;
+    case arg_patch::c: x.c = y.c; return;
+    case arg_patch::alpha: x.alpha = y.alpha; return;
+    case arg_patch::beta: x.beta = y.beta; return;
+    case arg_patch::workspace: x.workspace = y.workspace; return;
+    }
+}
+
+// Find where each argument lands in the packed kernel arguments by solving
+// once per argument with only that argument changed. Returns false if the
+// changes do not map to whole fields, in which case the plan has to solve on
+// every call.
+template <class Solver>
+bool pack_kernels(gemm_plan& p)
+{
+    auto base    = Solver::sentinel_args(0x3e);
+    auto changed = Solver::sentinel_args(0x3f);
+    // Plans for a beta of zero or one may have kernels specialized for that
+    // value, so it is solved with the value itself and never patched
+    bool fixed_beta = p.key.beta != beta_other;
+    if(fixed_beta)
+    {
+        base.beta    = p.key.beta == beta_zero ? 0 : 1;
+        changed.beta = base.beta;
+    }
+    auto kernels = Solver::solve(p, base);
+    std::vector<kernel_template> result;
+    std::transform(kernels.begin(), kernels.end(), std::back_inserter(result), [](auto& k) {
+        return kernel_template{k, {}};
+    });
+    for(auto field : {arg_patch::a,
+                      arg_patch::b,
+                      arg_patch::c,
+                      arg_patch::alpha,
+                      arg_patch::beta,
+                      arg_patch::workspace})
+    {
+        if(field == arg_patch::beta and fixed_beta)
+            continue;
+        auto args = base;
+        set_field(args, changed, field);
+        auto other = Solver::solve(p, args);
+        if(other.size() != kernels.size())
+            return false;
+        auto size = Solver::field_size(field);
+        for(std::size_t i = 0; i < kernels.size(); i++)
+        {
+            const auto& x = kernels[i];
+            const auto& y = other[i];
+            if(x.kernelName != y.kernelName or x.args.size() != y.args.size())
+                return false;
+            const auto* xd = static_cast<const unsigned char*>(x.args.data());
+            const auto* yd = static_cast<const unsigned char*>(y.args.data());
+            std::size_t j  = 0;
+            while(j < x.args.size())
+            {
+                if(xd[j] == yd[j])
+                {
+                    j++;
+                    continue;
+                }
+                auto start = j;
+                while(j < x.args.size() and xd[j] != yd[j])
+                    j++;
+                // Adjacent copies of the same argument show up as one run
+                if((j - start) % size != 0)
+                    return false;
+                for(auto offset = start; offset < j; offset += size)
+                    result[i].patches.push_back(arg_patch{field, offset, size});
+            }
+        }
+    }
+    p.kernels = std::move(result);
+    return true;
+}
+
+template <class Solver>
+void set_solver(gemm_plan& p)
+{
+    p.solver  = &Solver::solve;
+    p.encoder = &Solver::encode_scalars;
+    if(p.solution != nullptr)
+        p.packed = pack_kernels<Solver>(p);
+}
+
+void set_solver(gemm_plan& p, miopen_tensile_type type)
+{
+    switch(type)
+    {
+    case miopen_tensile_type_float: set_solver<typed_solver<float>>(p); break;
+    case miopen_tensile_type_half: set_solver<typed_solver<Tensile::Half>>(p); break;
+    case miopen_tensile_type_int8x4:
+        set_solver<typed_solver<Tensile::Int8x4, Tensile::Int8x4, int32_t>>(p);
+        break;
+    case miopen_tensile_type_int32: p.solution = nullptr; break;
+    case miopen_tensile_type_bfloat16:
+        set_solver<typed_solver<Tensile::BFloat16,
+                                Tensile::BFloat16,
+                                Tensile::BFloat16,
+                                Tensile::BFloat16,
+                                float,
+                                float>>(p);
+        break;
+    }
+    if(p.solution != nullptr)
+    {
+        p.loader = &code_objects(hardware_arch(*p.hardware));
+        for(auto&& k : p.kernels)
+            p.loader->load_kernel(k.invocation.kernelName);
+        if(not p.kernels.empty())
+            p.code_object = p.loader->kernel_file(p.kernels.front().invocation.kernelName);
+        // Plans that solve on every call launch the same kernels, so their
+        // code objects are loaded up front as well
+        if(not p.packed)
+        {
+            gemm_args args;
+            args.beta = p.key.beta == beta_zero ? 0 : p.key.beta == beta_one ? 1 : generic_beta;
+            for(auto&& k : p.solver(p, args))
+                p.loader->load_kernel(k.kernelName);
+        }
+    }
+}
+
+bool accepts(const Tensile::ContractionSolution& s,
+             const Tensile::ContractionProblem& problem,
+             const Tensile::Hardware& hw)
+{
+    return s.problemPredicate != nullptr and (*s.problemPredicate)(problem) and
+           s.hardwarePredicate != nullptr and (*s.hardwarePredicate)(hw);
+}
+
+// Solutions of the library that accept the problem and fit the workspace, by
+// kernel name
+std::unordered_map<std::string, solution_ptr> accepted_solutions(const gemm_plan& p,
+                                                                 const std::string& arch)
+{
+    std::unordered_map<std::string, solution_ptr> result;
+    for(auto&& s : library(arch).findAllSolutions(p.problem, *p.hardware))
+    {
+        if(s->requiredWorkspaceSize(p.problem) <= p.problem.workspaceSize())
+            result.emplace(s->kernelName, s);
+    }
+    return result;
+}
+
+// The best entry for the size in the logic file tuned for efficiency per cu
+bool select_cu_efficiency(gemm_plan& p, const logic_index& index, const std::string& arch)
+{
+    auto operation = logic_operation(p.key);
+    if(operation.empty())
+        return false;
+    auto type = index.find_type(arch, operation, true);
+    if(type == logic_index::npos)
+        return false;
+    auto size    = logic_size(p.key);
+    auto entries = index.find_exact(type, size[0], size[1], size[2], size[3]);
+    if(entries.empty())
+        return false;
+    auto accepted = accepted_solutions(p, arch);
+    for(auto&& e : entries)
+    {
+        auto it = accepted.find(index.string(index.solution(e.solution).name));
+        if(it == accepted.end())
+            continue;
+        p.solution        = it->second;
+        p.expected_gflops = e.gflops;
+        p.source          = gemm_plan::from_exact_size;
+        return true;
+    }
+    return false;
+}
+
+// A size missing from the exact table of its logic file is solved like the
+// closest benchmarked size, provided that solution also accepts the real
+// problem. Otherwise selection is left to the library.
+//
+// The tables were measured on whole devices, so on part of one the logic
+// tuned for efficiency per cu is tried first for sizes it has.
+void select_solution(gemm_plan& p)
+{
+    auto arch         = hardware_arch(*p.hardware);
+    const auto& lib   = library(arch);
+    const auto* index = library_index(arch);
+    if(index != nullptr and p.key.cu_count > 0 and select_cu_efficiency(p, *index, arch))
+        return;
+    logic_index::nearest_entry nearest;
+    if(index != nullptr)
+        nearest = find_nearest_entry(*index, arch, p.key);
+    if(nearest.entry != nullptr and nearest.distance > 0)
+    {
+        auto x = logic_operands(index->type(nearest.entry->type), *nearest.entry);
+        auto problem = create_tensile_problem(x.a, x.b, x.c, p.problem.beta());
+        problem.setWorkspaceSize(p.problem.workspaceSize());
+        auto s = lib.findBestSolution(problem, *p.hardware);
+        if(s != nullptr and accepts(*s, p.problem, *p.hardware))
+        {
+            p.solution        = s;
+            p.expected_gflops = nearest.entry->gflops;
+            p.source          = gemm_plan::from_nearest_size;
+            return;
+        }
+    }
+    p.solution = lib.findBestSolution(p.problem, *p.hardware);
+    if(p.solution != nullptr and nearest.entry != nullptr and nearest.distance == 0)
+    {
+        p.expected_gflops = nearest.entry->gflops;
+        p.source          = gemm_plan::from_exact_size;
+    }
+}
+
+// The solution that fits the workspace and comes first in the order of
+// find_solutions, by the distance to its closest benchmarked size and then
+// by its gflops there
+void select_fitting(gemm_plan& p)
+{
+    auto arch = hardware_arch(*p.hardware);
+    std::unordered_map<std::string, logic_estimate> estimates;
+    if(const auto* index = library_index(arch))
+        estimates = logic_solution_estimates(*index, arch, p.key);
+    p.solution = nullptr;
+    auto best  = std::make_tuple(0.0, 0.0, std::uint64_t{0});
+    for(auto&& x : accepted_solutions(p, arch))
+    {
+        logic_estimate e{0, std::numeric_limits<double>::infinity()};
+        auto it = estimates.find(x.first);
+        if(it != estimates.end())
+            e = it->second;
+        auto rank = std::make_tuple(e.distance, -e.gflops, solution_id(*x.second));
+        if(p.solution != nullptr and rank >= best)
+            continue;
+        best              = rank;
+        p.solution        = x.second;
+        p.expected_gflops = e.gflops;
+        if(it == estimates.end())
+            p.source = gemm_plan::from_library;
+        else
+            p.source = e.distance == 0 ? gemm_plan::from_exact_size : gemm_plan::from_nearest_size;
+    }
+}
+
+// A selected solution that needs more workspace than the problem allows is
+// replaced by the best one that fits, unless it was asked for by id
+void fit_workspace(gemm_plan& p)
+{
+    auto limit = p.problem.workspaceSize();
+    if(p.solution != nullptr and p.source != gemm_plan::from_solution_id and
+       p.solution->requiredWorkspaceSize(p.problem) > limit)
+        select_fitting(p);
+    if(p.solution != nullptr)
+        p.workspace_size = p.solution->requiredWorkspaceSize(p.problem);
+    if(p.workspace_size > limit)
+    {
+        p.solution       = nullptr;
+        p.workspace_size = 0;
+    }
+}
+
+// Zero when the count covers the whole device, so that such plans are shared
+std::size_t partial_cu_count(int device, std::size_t cu_count)
+{
+    return cu_count < hardware_cu_count(*hardware().get(device)) ? cu_count : 0;
+}
+
+gemm_plan_ptr create_gemm_plan(const miopen_tensile_matrix& a,
+                               const miopen_tensile_matrix& b,
+                               const miopen_tensile_matrix& c,
+                               double beta,
+                               int device,
+                               std::size_t max_workspace,
+                               std::uint64_t solution_id,
+                               std::size_t cu_count)
+{
+    auto g               = canonicalize(a, b, c);
+    auto p               = std::make_shared<gemm_plan>();
+    p->key               = create_problem_key(g.a, g.b, g.c, beta, device);
+    p->key.max_workspace = max_workspace;
+    p->key.solution_id   = solution_id;
+    p->key.cu_count      = partial_cu_count(device, cu_count);
+    p->key.swap_operands = g.swapped;
+    p->problem           = create_tensile_problem(g.a, g.b, g.c, beta);
+    p->problem.setWorkspaceSize(max_workspace);
+    p->hardware = with_cu_count(hardware().get(device), p->key.cu_count);
+    auto* trace = current_trace();
+    auto start  = trace == nullptr ? 0 : trace_clock();
+    if(solution_id == 0)
+    {
+        p->solution = tuned_solution(*p, {a, b, c}, beta);
+        p->source   = gemm_plan::from_tuning_db;
+        if(p->solution == nullptr)
+        {
+            p->source = gemm_plan::from_library;
+            select_solution(*p);
+        }
+    }
+    else
+    {
+        p->solution = find_solution(
+            library(hardware_arch(*p->hardware)), p->problem, *p->hardware, solution_id);
+        p->source = gemm_plan::from_solution_id;
+    }
+    if(trace != nullptr)
+        trace->select += trace_clock() - start;
+    fit_workspace(*p);
+    set_solver(*p, a.type);
+    return p;
+}
+
+miopen_tensile_matrix with_batch(miopen_tensile_matrix m, std::size_t n)
+{
+    m.batch = miopen_tensile_batch{n, 0};
+    return m;
+}
+
+launch_arena& thread_launch_arena()
+{
+    thread_local launch_arena result;
+    return result;
+}
+
+std::uint64_t next_plan_serial()
+{
+    static std::atomic<std::uint64_t> counter{0};
+    return ++counter;
+}
+
+launch_slot& launch_arena::slot(std::uint64_t plan)
+{
+    auto* result = &slots.front();
+    for(auto&& x : slots)
+    {
+        if(plan != 0 and x.plan == plan)
+        {
+            result = &x;
+            break;
+        }
+        if(x.used < result->used)
+            result = &x;
+    }
+    if(result->plan != plan)
+        result->plan = 0;
+    result->used = ++clock;
+    return *result;
+}
+
+const std::vector<Tensile::KernelInvocation>& gemm_plan::solve(const gemm_args& call,
+                                                                launch_arena& arena) const
+{
+    auto args = call;
+    if(key.swap_operands)
+        std::swap(args.a, args.b);
+    if(not packed)
+    {
+        auto& s   = arena.slot(0);
+        s.kernels = solver(*this, args);
+        return s.kernels;
+    }
+    auto& s = arena.slot(serial);
+    if(s.plan != serial)
+    {
+        s.kernels.resize(kernels.size());
+        for(std::size_t i = 0; i < kernels.size(); i++)
+            s.kernels[i] = kernels[i].invocation;
+        s.plan = serial;
+    }
+    scalar_bytes scalars;
+    encoder(args, scalars);
+    for(std::size_t i = 0; i < kernels.size(); i++)
+    {
+        // KernelArguments has no mutable view of its buffer, but the arena
+        // owns its copy
+        auto* data = static_cast<unsigned char*>(const_cast<void*>(s.kernels[i].args.data()));
+        for(auto&& patch : kernels[i].patches)
+        {
+            const void* src = nullptr;
+            switch(patch.field)
+            {
+            case arg_patch::a: src = &args.a; break;
+            case arg_patch::b: src = &args.b; break;
+            case arg_patch::c: src = &args.c; break;
+            case arg_patch::alpha: src = scalars.alpha; break;
+            case arg_patch::beta: src = scalars.beta; break;
+            case arg_patch::workspace: src = &args.workspace; break;
+            }
+            std::memcpy(data + patch.offset, src, patch.size);
+        }
+    }
+    return s.kernels;
+}
+
+miopen_tensile_status gemm_plan::execute(hipStream_t stream, const gemm_args& args) const
+{
+    if(solution == nullptr)
+    {
+        std::cerr << "No solution found." << std::endl;
+        return miopen_tensile_status_no_solution;
+    }
+    if(workspace_size > 0 and args.workspace == nullptr)
+    {
+        std::cerr << "Solution needs a workspace." << std::endl;
+        return miopen_tensile_status_unknown;
+    }
+    const auto& invocations = solve(args, thread_launch_arena());
+    if(not packed)
+    {
+        for(auto&& k : invocations)
+            loader->load_kernel(k.kernelName);
+    }
+    if(launcher().launch(invocations, stream) != hipSuccess)
+        return miopen_tensile_status_unknown;
+    return miopen_tensile_status_success;
+}
+
+auto& plan_cache()
+{
+    static sharded_cache<problem_key, gemm_plan_ptr, problem_key_hash> result{
+        env_size("MIOPEN_TENSILE_SOLUTION_CACHE_SIZE", 1024)};
+    return result;
+}
+
+gemm_plan_ptr get_gemm_plan(const miopen_tensile_matrix& a,
+                            const miopen_tensile_matrix& b,
+                            const miopen_tensile_matrix& c,
+                            double beta,
+                            int device,
+                            std::size_t max_workspace,
+                            std::uint64_t solution_id,
+                            std::size_t cu_count)
+{
+    auto g            = canonicalize(a, b, c);
+    auto key          = create_problem_key(g.a, g.b, g.c, beta, device);
+    key.max_workspace = max_workspace;
+    key.solution_id   = solution_id;
+    key.cu_count      = partial_cu_count(device, cu_count);
+    key.swap_operands = g.swapped;
+    return plan_cache().get(key, [&] {
+        trace_miss();
+        // The gemm in normal form selects once for both operand orders
+        if(g.swapped)
+        {
+            auto p = std::make_shared<gemm_plan>(*get_gemm_plan(
+                g.a, g.b, g.c, beta, device, max_workspace, solution_id, key.cu_count));
+            p->key.swap_operands = true;
+            return gemm_plan_ptr{p};
+        }
+        return create_gemm_plan(
+            g.a, g.b, g.c, beta, device, max_workspace, solution_id, key.cu_count);
+    });
+}
+
+gemm_plan_ptr get_gemm_plan(const miopen_tensile_matrix& a,
+                            const miopen_tensile_matrix& b,
+                            const miopen_tensile_matrix& c,
+                            double beta)
+{
+    return get_gemm_plan(a, b, c, beta, current_device());
+}
+
+gemm_plan_ptr get_pointer_batched_gemm_plan(const miopen_tensile_matrix& a,
+                                            const miopen_tensile_matrix& b,
+                                            const miopen_tensile_matrix& c,
+                                            std::size_t batch_count,
+                                            double beta,
+                                            std::size_t cu_count)
+{
+    // Only the layout of a single item is put in normal form, as the items
+    // can be anywhere
+    auto g              = canonicalize(with_batch(a, 1), with_batch(b, 1), with_batch(c, 1));
+    auto ba             = with_batch(g.a, batch_count);
+    auto bb             = with_batch(g.b, batch_count);
+    auto bc             = with_batch(g.c, batch_count);
+    auto device         = current_device();
+    auto key            = create_problem_key(ba, bb, bc, beta, device);
+    key.pointer_batched = true;
+    key.cu_count        = partial_cu_count(device, cu_count);
+    key.swap_operands   = g.swapped;
+    return plan_cache().get(key, [&] {
+        trace_miss();
+        auto p             = std::make_shared<gemm_plan>();
+        p->key             = key;
+        p->pointer_batched = true;
+        p->problem         = create_tensile_problem(ba, bb, bc, beta);
+        p->problem.setStridedBatched(false);
+        // There is no workspace argument for pointer arrays
+        p->problem.setWorkspaceSize(0);
+        p->hardware = with_cu_count(hardware().get(device), key.cu_count);
+        p->solution =
+            library(hardware_arch(*p->hardware)).findBestSolution(p->problem, *p->hardware);
+        fit_workspace(*p);
+        set_solver(*p, a.type);
+        return gemm_plan_ptr{p};
+    });
+}
+
+std::atomic<std::size_t> pointer_batched_fallback_count{0};
+
+std::size_t pointer_batched_fallbacks()
+{
+    return pointer_batched_fallback_count.load(std::memory_order_relaxed);
+}
+
+template <class T>
+std::vector<T> pointers_to_host(hipStream_t stream, const T* ptrs, std::size_t n)
+{
+    std::vector<T> result(n);
+    if(hipMemcpyAsync(result.data(), ptrs, n * sizeof(T), hipMemcpyDeviceToHost, stream) !=
+           hipSuccess or
+       hipStreamSynchronize(stream) != hipSuccess)
+        throw std::runtime_error("Failed to copy batch pointers to host");
+    return result;
+}
+
+miopen_tensile_status gemm_pointer_batched(hipStream_t stream,
+                                           const miopen_tensile_matrix& a,
+                                           const miopen_tensile_matrix& b,
+                                           const miopen_tensile_matrix& c,
+                                           const void* const* a_ptrs,
+                                           const void* const* b_ptrs,
+                                           void* const* c_ptrs,
+                                           std::size_t batch_count,
+                                           double alpha,
+                                           double beta)
+{
+    if(batch_count == 0)
+        return miopen_tensile_status_success;
+    auto cu_count = stream_cu_count(stream);
+    auto plan     = get_pointer_batched_gemm_plan(a, b, c, batch_count, beta, cu_count);
+    if(plan->solution != nullptr)
+        return plan->execute(stream, {a_ptrs, b_ptrs, const_cast<void**>(c_ptrs), alpha, beta});
+
+    auto single = get_gemm_plan(with_batch(a, 1),
+                                with_batch(b, 1),
+                                with_batch(c, 1),
+                                beta,
+                                current_device(),
+                                0,
+                                0,
+                                cu_count);
+    if(single->solution == nullptr)
+        return single->execute(stream, {});
+    pointer_batched_fallback_count.fetch_add(1, std::memory_order_relaxed);
+    auto as = pointers_to_host(stream, a_ptrs, batch_count);
+    auto bs = pointers_to_host(stream, b_ptrs, batch_count);
+    auto cs = pointers_to_host(stream, c_ptrs, batch_count);
+    for(std::size_t i = 0; i < batch_count; i++)
+    {
+        auto status = single->execute(stream, {as[i], bs[i], cs[i], alpha, beta});
+        if(status != miopen_tensile_status_success)
+            return status;
+    }
+    return miopen_tensile_status_success;
+}
+
+miopen_tensile_status
+gemm_grouped(hipStream_t stream, const miopen_tensile_gemm_desc* gemms, std::size_t count)
+{
+    // Reused between calls so steady state grouping does not allocate
+    thread_local std::vector<std::pair<gemm_plan_ptr, std::size_t>> items;
+    items.clear();
+    auto device   = current_device();
+    auto cu_count = stream_cu_count(stream);
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const auto& g = gemms[i];
+        auto plan     = get_gemm_plan(g.b, g.a, g.c, g.beta, device, 0, 0, cu_count);
+        if(plan->solution == nullptr)
+        {
+            items.clear();
+            std::cerr << "No solution found for gemm " << i << " of the group." << std::endl;
+            return miopen_tensile_status_no_solution;
+        }
+        items.emplace_back(std::move(plan), i);
+    }
+    std::stable_sort(items.begin(), items.end(), [](auto&& x, auto&& y) {
+        return std::make_pair(x.first->code_object, x.first->solution.get()) <
+               std::make_pair(y.first->code_object, y.first->solution.get());
+    });
+    auto result = miopen_tensile_status_success;
+    for(auto&& item : items)
+    {
+        const auto& g = gemms[item.second];
+        result        = item.first->execute(stream, {g.b.data, g.a.data, g.c.data, g.alpha, g.beta});
+        if(result != miopen_tensile_status_success)
+            break;
+    }
+    items.clear();
+    return result;
+}
+
+miopen_tensile_status
+warmup_gemms(const miopen_tensile_gemm_desc* gemms, std::size_t count, int device)
+{
+    auto result = miopen_tensile_status_success;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const auto& g = gemms[i];
+        if(get_gemm_plan(g.b, g.a, g.c, g.beta, device)->solution == nullptr)
+            result = miopen_tensile_status_no_solution;
+    }
+    return result;
+}
+
+cache_stats plan_cache_stats() { return plan_cache().stats(); }
+
+void clear_plan_cache() { plan_cache().clear(); }
+
+} // namespace miopentensile
@@ -0,0 +1,234 @@
+#include <miopentensile/hardware.hpp>
+#include <Tensile/AMDGPU.hpp>
+#include <Tensile/hip/HipHardware.hpp>
+#include <hip/hip_runtime_api.h>
+#include <algorithm>
+#include <bitset>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace miopentensile {
+
+using processor = Tensile::AMDGPU::Processor;
+
+static const std::pair<const char*, processor> processors[] = {
+    {"gfx803", processor::gfx803},
+    {"gfx900", processor::gfx900},
+    {"gfx906", processor::gfx906},
+    {"gfx908", processor::gfx908},
+    {"gfx90a", processor::gfx90a},
+    {"gfx1010", processor::gfx1010},
+    {"gfx1011", processor::gfx1011},
+    {"gfx1012", processor::gfx1012},
+    {"gfx1030", processor::gfx1030},
+};
+
+processor get_processor(const std::string& arch)
+{
+    // Ignore target features such as gfx908:xnack-
+    auto name = arch.substr(0, arch.find(':'));
+    auto it   = std::find_if(std::begin(processors), std::end(processors), [&](auto&& p) {
+        return name == p.first;
+    });
+    if(it == std::end(processors))
+        throw std::runtime_error("Unknown architecture: " + arch);
+    return it->second;
+}
+
+std::string hardware_arch(const Tensile::Hardware& h)
+{
+    const auto* gpu = dynamic_cast<const Tensile::AMDGPU*>(&h);
+    if(gpu == nullptr)
+        return "";
+    auto it = std::find_if(std::begin(processors), std::end(processors), [&](auto&& p) {
+        return gpu->processor == p.second;
+    });
+    if(it == std::end(processors))
+        return "";
+    return it->first;
+}
+
+std::size_t hardware_cu_count(const Tensile::Hardware& h)
+{
+    const auto* gpu = dynamic_cast<const Tensile::AMDGPU*>(&h);
+    if(gpu == nullptr)
+        return 0;
+    return gpu->computeUnitCount;
+}
+
+hardware_ptr with_cu_count(const hardware_ptr& h, std::size_t cu_count)
+{
+    const auto* gpu = dynamic_cast<const Tensile::AMDGPU*>(h.get());
+    if(gpu == nullptr or cu_count == 0 or cu_count >= std::size_t(gpu->computeUnitCount))
+        return h;
+    return std::make_shared<Tensile::AMDGPU>(gpu->processor, int(cu_count), gpu->deviceName);
+}
+
+struct hip_provider : hardware_provider
+{
+    int current_device() const override
+    {
+        int device = 0;
+        if(hipGetDevice(&device) != hipSuccess)
+            throw std::runtime_error("Failed to get current device");
+        return device;
+    }
+    hardware_ptr create_hardware(int device) const override
+    {
+        return Tensile::hip::GetDevice(device);
+    }
+    std::size_t stream_cu_count(hipStream_t stream) const override
+    {
+        std::array<std::uint32_t, 32> mask{};
+        if(hipExtStreamGetCUMask(stream, mask.size(), mask.data()) != hipSuccess)
+            return 0;
+        std::size_t result = 0;
+        for(auto m : mask)
+            result += std::bitset<32>(m).count();
+        return result;
+    }
+};
+
+struct fake_provider : hardware_provider
+{
+    processor proc;
+    int cu_count;
+    std::string name;
+
+    int current_device() const override { return 0; }
+    hardware_ptr create_hardware(int) const override
+    {
+        return std::make_shared<Tensile::AMDGPU>(proc, cu_count, name);
+    }
+};
+
+std::shared_ptr<hardware_provider> hip_hardware_provider()
+{
+    return std::make_shared<hip_provider>();
+}
+
+std::shared_ptr<hardware_provider>
+fake_hardware_provider(const std::string& arch, int cu_count, const std::string& device_name)
+{
+    auto p      = std::make_shared<fake_provider>();
+    p->proc     = get_processor(arch);
+    p->cu_count = cu_count;
+    p->name     = device_name.empty() ? arch : device_name;
+    return p;
+}
+
+hardware_registry::generation::generation(std::shared_ptr<hardware_provider> p)
+    : provider(std::move(p))
+{
+    for(auto&& r : ready)
+        r.store(false, std::memory_order_relaxed);
+}
+
+hardware_registry::hardware_registry(std::shared_ptr<hardware_provider> p) { reset(std::move(p)); }
+
+int hardware_registry::current_device() const
+{
+    return active.load(std::memory_order_acquire)->provider->current_device();
+}
+
+std::size_t hardware_registry::stream_cu_count(hipStream_t stream) const
+{
+    return active.load(std::memory_order_acquire)->provider->stream_cu_count(stream);
+}
+
+const hardware_ptr& hardware_registry::get(int device)
+{
+    if(device < 0 or device >= max_devices)
+        throw std::runtime_error("Invalid device ordinal: " + std::to_string(device));
+    auto* g = active.load(std::memory_order_acquire);
+    if(g->ready[device].load(std::memory_order_acquire))
+        return g->slots[device];
+    std::lock_guard<std::mutex> lock(mutex);
+    if(not g->ready[device].load(std::memory_order_relaxed))
+    {
+        auto h = g->provider->create_hardware(device);
+        if(h == nullptr)
+            throw std::runtime_error("No hardware for device " + std::to_string(device));
+        g->slots[device] = std::move(h);
+        creations.fetch_add(1, std::memory_order_relaxed);
+        g->ready[device].store(true, std::memory_order_release);
+    }
+    return g->slots[device];
+}
+
+void hardware_registry::reset(std::shared_ptr<hardware_provider> p)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    generations.push_back(std::make_unique<generation>(std::move(p)));
+    creations.store(0, std::memory_order_relaxed);
+    active.store(generations.back().get(), std::memory_order_release);
+}
+
+hardware_registry& hardware()
+{
+    static hardware_registry result{hip_hardware_provider()};
+    return result;
+}
+
+void set_hardware_provider(std::shared_ptr<hardware_provider> p) { hardware().reset(std::move(p)); }
+
+int current_device() { return hardware().current_device(); }
+
+// Counts set through the api. Most processes set none, so readers only look
+// at the map when it has entries, and then at a copy of their own thread that
+// is refreshed when the version changes.
+struct stream_cu_counts
+{
+    std::mutex mutex;
+    std::unordered_map<hipStream_t, std::size_t> counts;
+    std::atomic<std::size_t> size{0};
+    std::atomic<std::uint64_t> version{0};
+};
+
+stream_cu_counts& cu_counts()
+{
+    static stream_cu_counts result;
+    return result;
+}
+
+std::size_t stream_cu_count(hipStream_t stream)
+{
+    auto& s = cu_counts();
+    if(s.size.load(std::memory_order_acquire) > 0)
+    {
+        thread_local std::uint64_t version = 0;
+        thread_local std::unordered_map<hipStream_t, std::size_t> counts;
+        auto current = s.version.load(std::memory_order_acquire);
+        if(version != current)
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            counts  = s.counts;
+            version = s.version.load(std::memory_order_relaxed);
+        }
+        auto it = counts.find(stream);
+        if(it != counts.end())
+            return it->second;
+    }
+    return 0;
+}
+
+void set_stream_cu_count(hipStream_t stream, std::size_t cu_count)
+{
+    auto& s = cu_counts();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if(cu_count == 0)
+        s.counts.erase(stream);
+    else
+        s.counts[stream] = cu_count;
+    s.version.fetch_add(1, std::memory_order_release);
+    s.size.store(s.counts.size(), std::memory_order_release);
+}
+
+std::size_t set_stream_cu_count_from_mask(hipStream_t stream)
+{
+    auto result = hardware().stream_cu_count(stream);
+    set_stream_cu_count(stream, result);
+    return result;
+}
+
+} // namespace miopentensile
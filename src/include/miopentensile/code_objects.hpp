@@ -0,0 +1,63 @@
+#ifndef MIOPENTENSILE_GUARD_CODE_OBJECTS_HPP
+#define MIOPENTENSILE_GUARD_CODE_OBJECTS_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace miopentensile {
+
+// Names of the kernels defined in a code object, read from its ELF symbol
+// table without loading it
+std::vector<std::string> code_object_kernels(const std::string& path);
+
+// Whether the code object file name is for the architecture, ie
+// TensileLibrary_gfx906.co for gfx906. Files without a target in their name
+// match every architecture.
+bool code_object_matches_arch(const std::string& path, const std::string& arch);
+
+// Loads code objects the first time one of their kernels is needed. The index
+// from kernel name to file is built on first use, and each file is loaded at
+// most once even when several threads need it at the same time.
+struct code_object_loader
+{
+    using load_function = std::function<void(const std::string&)>;
+
+    static const std::size_t npos = -1;
+
+    code_object_loader(std::vector<std::string> code_objects, load_function f);
+
+    // Builds the index from kernel name to file if it is not built yet
+    void build_index();
+
+    // Index of the file defining the kernel, or npos
+    std::size_t kernel_file(const std::string& name);
+
+    // Returns false if no code object defines the kernel
+    bool load_kernel(const std::string& name);
+
+    std::size_t loaded_files() const { return loads.load(std::memory_order_relaxed); }
+    std::size_t indexed_files() const { return files.size(); }
+
+    private:
+    void index_files();
+
+    std::vector<std::string> files;
+    load_function load;
+    std::once_flag index_flag;
+    std::unordered_map<std::string, std::size_t> kernels;
+    std::unique_ptr<std::once_flag[]> file_flags;
+    std::atomic<std::size_t> loads{0};
+};
+
+// Loader for the code objects of an architecture in the installed library, an
+// empty architecture loads from every code object
+code_object_loader& code_objects(const std::string& arch);
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MIOPENTENSILE_GUARD_COST_MODEL_HPP
+#define MIOPENTENSILE_GUARD_COST_MODEL_HPP
+
+#include <miopentensile/logic_index.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace miopentensile {
+
+// An analytic model of the time of the solutions of a logic file, fitted to
+// its tables. Selection does not use it: on held out sizes of the installed
+// tables it ranks the table winner first far less often than the winner of
+// the closest tuned size is the right one, see installed_ranking in
+// test/cost_model.cpp.
+
+struct device_params
+{
+    std::size_t cu_count = 0;
+    double clock_mhz     = 0;
+};
+
+// The device the tables of arch were measured on, zero for an unknown arch
+device_params default_device_params(const std::string& arch);
+
+// Rates of a kind of kernel in cycles, so that they carry over to devices of
+// the same arch with other cu counts and clocks. Fitted to the measured
+// gflops of a logic file.
+struct cost_params
+{
+    double flops_per_cycle = 256; // per cu
+    double bytes_per_cycle = 512; // for the whole device
+    double wave_cycles     = 2000;
+    // How much narrow thread tiles and global reads slow a kernel down
+    double vector_cost = 1;
+    double read_cost   = 1;
+};
+
+// A problem in the units of the logic tables
+struct cost_problem
+{
+    std::uint64_t m     = 0;
+    std::uint64_t n     = 0;
+    std::uint64_t batch = 1;
+    std::uint64_t k     = 0;
+    std::size_t input_bytes  = 4;
+    std::size_t output_bytes = 4;
+};
+
+struct cost_estimate
+{
+    double seconds = 0;
+    double gflops  = 0;
+    double waves   = 0;
+    // Fraction of the macro tiles that is inside the result
+    double tile_efficiency = 0;
+    double bytes           = 0;
+};
+
+// Predicts the time of a solution as the larger of its compute and memory
+// time plus a fixed cost per wave of workgroups. Partial waves, padding of the
+// macro tiles and of the unrolled k loop, reads shared between the workgroups
+// of a wave through the workgroup mapping, and the extra writes of split k
+// are all accounted for.
+cost_estimate predict_cost(const logic_index::solution_record& s,
+                           const cost_problem& x,
+                           const device_params& device,
+                           const cost_params& params);
+
+// Bytes of an element of a Tensile::DataType, counting int8x4 as one element
+std::size_t logic_type_size(int data_type);
+
+// The problem of a table entry of the type
+cost_problem entry_problem(const logic_index::type_record& t, const logic_index::entry_record& e);
+
+// Fits the parameters to the table entries of the type accepted by use,
+// measured on device. Returns the defaults when no entry is used.
+cost_params calibrate_cost_model(const logic_index& index,
+                                 std::size_t type,
+                                 const device_params& device,
+                                 const std::function<bool(const logic_index::entry_record&)>& use);
+
+// Parameters fitted to every entry of each type of the index on the default
+// device of its arch, in type order. Types with too few entries are left
+// zero. Run when the index is compiled, see write_logic_costs.
+std::vector<logic_index_format::cost_record> calibrate_logic_index(const logic_index& index);
+
+// The parameters of the type stored in the index, false if it has none
+bool logic_cost_params(const logic_index& index, std::size_t type, cost_params& result);
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef MIOPENTENSILE_GUARD_CPU_GEMM_HPP
+#define MIOPENTENSILE_GUARD_CPU_GEMM_HPP
+
+#include <miopentensile/gemm.h>
+#include <cstdint>
+#include <string>
+
+namespace miopentensile {
+
+// The backend gemm calls run on. It defaults to the cpu when the library is
+// built with MIOPEN_TENSILE_CPU_BACKEND, and MIOPEN_TENSILE_BACKEND set to cpu
+// or hip overrides the build.
+miopen_tensile_backend current_backend();
+
+// Not safe to call while other threads are running gemms
+void set_backend(miopen_tensile_backend backend);
+
+inline bool use_cpu_backend() { return current_backend() == miopen_tensile_backend_cpu; }
+
+// Threads a cpu gemm runs on, MIOPEN_TENSILE_CPU_THREADS or else every
+// hardware thread
+std::size_t cpu_threads();
+
+// Kernel name and id of the one solution the cpu backend lists
+const std::string& cpu_solution_name();
+
+std::uint64_t cpu_solution_id();
+
+// Whether the cpu backend runs the gemm: no_solution for types the gpu
+// libraries do not run either or int8x4 sizes that cannot be packed. Throws
+// when the sizes of the matrices do not match. The matrices are in gemm api
+// operand order.
+miopen_tensile_status cpu_gemm_supported(const miopen_tensile_matrix& a,
+                                         const miopen_tensile_matrix& b,
+                                         const miopen_tensile_matrix& c);
+
+// Checks every gemm, returning no_solution if one of them cannot run
+miopen_tensile_status cpu_gemm_supported(const miopen_tensile_gemm_desc* gemms, std::size_t count);
+
+// Runs the gemm on the host threads with a, b and c in host memory at
+// a_data, b_data and c_data, ignoring the data fields of the matrices. Half
+// and bfloat16 accumulate in float and int8x4 in int32, as on the gpu.
+miopen_tensile_status cpu_gemm(const miopen_tensile_matrix& a,
+                               const miopen_tensile_matrix& b,
+                               const miopen_tensile_matrix& c,
+                               const void* a_data,
+                               const void* b_data,
+                               void* c_data,
+                               double alpha,
+                               double beta);
+
+// Batch items given by host arrays of pointers
+miopen_tensile_status cpu_gemm_pointer_batched(const miopen_tensile_matrix& a,
+                                               const miopen_tensile_matrix& b,
+                                               const miopen_tensile_matrix& c,
+                                               const void* const* a_ptrs,
+                                               const void* const* b_ptrs,
+                                               void* const* c_ptrs,
+                                               std::size_t batch_count,
+                                               double alpha,
+                                               double beta);
+
+// Checks every gemm of the group before running any, like gemm_grouped
+miopen_tensile_status cpu_gemm_grouped(const miopen_tensile_gemm_desc* gemms, std::size_t count);
+
+} // namespace miopentensile
+
+#endif
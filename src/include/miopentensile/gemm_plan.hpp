@@ -0,0 +1,224 @@
+#ifndef MIOPENTENSILE_GUARD_GEMM_PLAN_HPP
+#define MIOPENTENSILE_GUARD_GEMM_PLAN_HPP
+
+#include <miopentensile/gemm.h>
+#include <miopentensile/code_objects.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/problem_key.hpp>
+#include <miopentensile/solution_cache.hpp>
+#include <Tensile/Contractions.hpp>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace miopentensile {
+
+using solution_ptr = std::shared_ptr<Tensile::ContractionProblem::Solution>;
+
+// Pointers and scalars of one gemm call in tensile operand order. For pointer
+// batched plans a, b and c point to device arrays of pointers.
+struct gemm_args
+{
+    const void* a   = nullptr;
+    const void* b   = nullptr;
+    void* c         = nullptr;
+    double alpha    = 1.0;
+    double beta     = 0.0;
+    void* workspace = nullptr;
+};
+
+// Location of a gemm argument inside the packed kernel arguments
+struct arg_patch
+{
+    enum field_type
+    {
+        a,
+        b,
+        c,
+        alpha,
+        beta,
+        workspace
+    };
+    field_type field;
+    std::size_t offset;
+    std::size_t size;
+};
+
+struct kernel_template
+{
+    Tensile::KernelInvocation invocation;
+    std::vector<arg_patch> patches;
+};
+
+// Alpha and beta converted to the scalar types the kernels take
+struct scalar_bytes
+{
+    unsigned char alpha[8];
+    unsigned char beta[8];
+};
+
+// Kernels of one plan in a launch arena, plan being zero when they are not
+// reused
+struct launch_slot
+{
+    std::uint64_t plan = 0;
+    std::uint64_t used = 0;
+    std::vector<Tensile::KernelInvocation> kernels;
+};
+
+// Kernel invocations reused by the calls of one thread. The arena keeps the
+// kernels of the last few plans solved into it, and a plan found there only
+// has its arguments patched. Otherwise it replaces the least recently used
+// slot, whose copies keep the capacity of the buffers already there. So
+// steady state calls of packed plans do not allocate, also when a thread
+// alternates between a few shapes.
+struct launch_arena
+{
+    std::array<launch_slot, 8> slots;
+    std::uint64_t clock = 0;
+
+    // The slot holding the kernels of plan, or the one to fill with them,
+    // which then has a plan of zero
+    launch_slot& slot(std::uint64_t plan);
+};
+
+launch_arena& thread_launch_arena();
+
+// Nonzero and different for every plan created by the process
+std::uint64_t next_plan_serial();
+
+// Everything needed to launch a gemm of one shape, resolved once and then
+// executed with new pointers and scalars
+struct gemm_plan
+{
+    using solve_function  = std::vector<Tensile::KernelInvocation> (*)(const gemm_plan&,
+                                                                      const gemm_args&);
+    using encode_function = void (*)(const gemm_args&, scalar_bytes&);
+
+    // Where the solution came from
+    enum source_type
+    {
+        from_library,
+        from_exact_size,
+        from_nearest_size,
+        from_tuning_db,
+        from_solution_id
+    };
+
+    problem_key key;
+    Tensile::ContractionProblem problem;
+    hardware_ptr hardware;
+    solution_ptr solution;
+    code_object_loader* loader = nullptr;
+    // File holding the first kernel, used to keep launches from the same
+    // code object together
+    std::size_t code_object = code_object_loader::npos;
+    bool pointer_batched    = false;
+    // Measured gflops of the logic table entry the solution was taken from,
+    // zero when the size did not match an entry
+    double expected_gflops = 0;
+    source_type source     = from_library;
+    // Bytes of workspace the solution needs, at most key.max_workspace
+    std::size_t workspace_size = 0;
+    solve_function solver      = nullptr;
+    encode_function encoder    = nullptr;
+    // Kernels packed with placeholder arguments. When the arguments could not
+    // be located in the packed buffer the kernels are solved on every call.
+    std::vector<kernel_template> kernels;
+    bool packed = false;
+    // Identifies the kernels of the plan in the launch arenas
+    std::uint64_t serial = next_plan_serial();
+
+    // The kernels to launch for the arguments, held by the arena until the
+    // next solve into it. The arguments are those of the gemm the plan was
+    // asked for: a and b are swapped here when its normal form swapped them.
+    const std::vector<Tensile::KernelInvocation>& solve(const gemm_args& args,
+                                                       launch_arena& arena) const;
+    // Launches from the arena of the calling thread
+    miopen_tensile_status execute(hipStream_t stream, const gemm_args& args) const;
+};
+
+using gemm_plan_ptr = std::shared_ptr<const gemm_plan>;
+
+// The matrices are in tensile operand order, ie b, a, c of the gemm api. The
+// plan may only be executed with a beta of the same beta_class, and
+// generic_beta gives a plan for any beta. Only solutions that need at most
+// max_workspace bytes of workspace are used, and one selected that needs more
+// is replaced by the best that fits. A solution recorded in the
+// tuning database is used before selection. A nonzero solution_id skips both
+// and uses that solution, if it can run the problem. A nonzero cu_count
+// selects for that many compute units of the device, such as under a cu mask.
+// Solutions are selected for the normal form of the gemm, see canonicalize().
+gemm_plan_ptr create_gemm_plan(const miopen_tensile_matrix& a,
+                               const miopen_tensile_matrix& b,
+                               const miopen_tensile_matrix& c,
+                               double beta,
+                               int device,
+                               std::size_t max_workspace = 0,
+                               std::uint64_t solution_id = 0,
+                               std::size_t cu_count      = 0);
+
+// Plan shared through the process-wide cache
+gemm_plan_ptr get_gemm_plan(const miopen_tensile_matrix& a,
+                            const miopen_tensile_matrix& b,
+                            const miopen_tensile_matrix& c,
+                            double beta,
+                            int device,
+                            std::size_t max_workspace = 0,
+                            std::uint64_t solution_id = 0,
+                            std::size_t cu_count      = 0);
+
+// Plan for the current device
+gemm_plan_ptr get_gemm_plan(const miopen_tensile_matrix& a,
+                            const miopen_tensile_matrix& b,
+                            const miopen_tensile_matrix& c,
+                            double beta);
+
+// Plan for a batch of batch_count items given by arrays of pointers. There is
+// no workspace, so only solutions that need none are used. It has no solution
+// when the library cannot solve pointer batched problems of the shape.
+gemm_plan_ptr get_pointer_batched_gemm_plan(const miopen_tensile_matrix& a,
+                                            const miopen_tensile_matrix& b,
+                                            const miopen_tensile_matrix& c,
+                                            std::size_t batch_count,
+                                            double beta,
+                                            std::size_t cu_count = 0);
+
+// Runs a pointer batched gemm, falling back to one launch per item with a
+// single selection when there is no pointer batched solution. Both select for
+// the compute units of the stream.
+miopen_tensile_status gemm_pointer_batched(hipStream_t stream,
+                                           const miopen_tensile_matrix& a,
+                                           const miopen_tensile_matrix& b,
+                                           const miopen_tensile_matrix& c,
+                                           const void* const* a_ptrs,
+                                           const void* const* b_ptrs,
+                                           void* const* c_ptrs,
+                                           std::size_t batch_count,
+                                           double alpha,
+                                           double beta);
+
+// Runs independent gemms given in gemm api operand order. Plans are resolved
+// for the whole group first, for the compute units of the stream, and
+// launches are ordered by code object and solution.
+miopen_tensile_status
+gemm_grouped(hipStream_t stream, const miopen_tensile_gemm_desc* gemms, std::size_t count);
+
+// Creates the plans gemm calls of the whole device would use for the gemms,
+// given in gemm api operand order, and loads their code objects, so that the
+// calls neither select nor read files. Every gemm is warmed even when one of
+// them has no solution.
+miopen_tensile_status
+warmup_gemms(const miopen_tensile_gemm_desc* gemms, std::size_t count, int device);
+
+cache_stats plan_cache_stats();
+
+// Number of pointer batched gemms run item by item for lack of a solution
+// taking pointer arrays, each of which synchronized its stream
+std::size_t pointer_batched_fallbacks();
+
+void clear_plan_cache();
+
+} // namespace miopentensile
+
+#endif
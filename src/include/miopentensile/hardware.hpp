@@ -0,0 +1,98 @@
+#ifndef MIOPENTENSILE_GUARD_HARDWARE_HPP
+#define MIOPENTENSILE_GUARD_HARDWARE_HPP
+
+#include <Tensile/Tensile.hpp>
+#include <hip/hip_runtime_api.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace miopentensile {
+
+using hardware_ptr = std::shared_ptr<Tensile::Hardware>;
+
+// Source of device ordinals and their hardware descriptions. The default
+// provider queries hip, a fake one lets selection run on hosts without a gpu.
+struct hardware_provider
+{
+    virtual ~hardware_provider() = default;
+    virtual int current_device() const                 = 0;
+    virtual hardware_ptr create_hardware(int device) const = 0;
+    // Compute units enabled for the stream, or zero when that is unknown
+    virtual std::size_t stream_cu_count(hipStream_t) const { return 0; }
+};
+
+std::shared_ptr<hardware_provider> hip_hardware_provider();
+
+// Reports every device as an AMDGPU of the given architecture, ie "gfx908"
+std::shared_ptr<hardware_provider>
+fake_hardware_provider(const std::string& arch, int cu_count, const std::string& device_name = "");
+
+// Hardware descriptions indexed by device ordinal. Each slot is filled once
+// and then read without locking. Resetting the provider starts a new set of
+// slots and keeps the old ones alive, so readers racing with a reset see
+// either provider and references returned by get() stay valid.
+struct hardware_registry
+{
+    static const int max_devices = 64;
+
+    explicit hardware_registry(std::shared_ptr<hardware_provider> p);
+
+    int current_device() const;
+    const hardware_ptr& get(int device);
+    const hardware_ptr& current() { return get(current_device()); }
+    std::size_t stream_cu_count(hipStream_t stream) const;
+
+    void reset(std::shared_ptr<hardware_provider> p);
+
+    std::size_t created() const { return creations.load(std::memory_order_relaxed); }
+
+    private:
+    struct generation
+    {
+        explicit generation(std::shared_ptr<hardware_provider> p);
+        std::shared_ptr<hardware_provider> provider;
+        std::array<hardware_ptr, max_devices> slots;
+        std::array<std::atomic<bool>, max_devices> ready;
+    };
+    std::vector<std::unique_ptr<generation>> generations;
+    std::atomic<generation*> active{nullptr};
+    std::atomic<std::size_t> creations{0};
+    std::mutex mutex;
+};
+
+hardware_registry& hardware();
+
+// Replace the provider used by the process-wide registry
+void set_hardware_provider(std::shared_ptr<hardware_provider> p);
+
+int current_device();
+
+// Architecture name such as "gfx906", or an empty string if the hardware is not
+// an AMDGPU
+std::string hardware_arch(const Tensile::Hardware& h);
+
+std::size_t hardware_cu_count(const Tensile::Hardware& h);
+
+// The hardware limited to cu_count compute units, or h itself when cu_count
+// is zero or not less than its own count
+hardware_ptr with_cu_count(const hardware_ptr& h, std::size_t cu_count);
+
+// Compute units that gemms launched on the stream select solutions for, as
+// set for the stream. Zero means the whole device. The cu mask of the stream
+// is not queried here, as that would cost a runtime call per gemm.
+std::size_t stream_cu_count(hipStream_t stream);
+
+// Zero clears the count set for the stream. Counts are keyed by the handle, so
+// they outlive the stream unless cleared.
+void set_stream_cu_count(hipStream_t stream, std::size_t cu_count);
+
+// Sets the count of the stream to the one its cu mask enables and returns it
+std::size_t set_stream_cu_count_from_mask(hipStream_t stream);
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef MIOPENTENSILE_GUARD_LIBRARY_HPP
+#define MIOPENTENSILE_GUARD_LIBRARY_HPP
+
+#include <Tensile/Tensile.hpp>
+#include <Tensile/hip/HipSolutionAdapter.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace miopentensile {
+
+using library_type = Tensile::SolutionLibrary<Tensile::ContractionProblem>;
+
+std::vector<std::string> glob_files(const std::string& s);
+
+std::size_t env_size(const char* name, std::size_t default_value);
+
+// Directory of the tensile library files installed next to the shared library
+std::string library_path();
+
+// Directory of the library shard for arch when the build produced one shard
+// per architecture, otherwise library_path()
+std::string library_path(const std::string& arch);
+
+// Directories of the libraries making up the shard in path, one for each
+// group of data types when the build split it, otherwise path itself
+std::vector<std::string> library_parts(const std::string& path);
+
+// Code objects of every part of the shard in path
+std::vector<std::string> library_code_objects(const std::string& path);
+
+// Runs f for each index below n on at most threads threads, and rethrows the
+// first exception thrown
+void parallel_for(std::size_t n, std::size_t threads, const std::function<void(std::size_t)>& f);
+
+// The group of the split library holding problems of the type of problem,
+// named like the type suffix of the logic files, ie HBH for half inputs and
+// outputs with high precision accumulation. Empty for types without a name.
+std::string library_group(const Tensile::ContractionProblem& problem);
+
+// The group of the part of a split library in directory path, ie HBH for
+// .../HBH/library/
+std::string library_part_group(const std::string& path);
+
+// The parts of a split library. A problem is only given to the part of its
+// group, so parts whose solutions overlap cannot answer for each other's
+// types. Problems whose group has no part are searched for in every part, in
+// order.
+struct library_set : library_type
+{
+    explicit library_set(std::vector<std::shared_ptr<library_type>> libraries,
+                         std::vector<std::string> library_groups = {});
+
+    std::shared_ptr<Tensile::ContractionSolution>
+    findBestSolution(Tensile::ContractionProblem const& problem,
+                     Tensile::Hardware const& hardware,
+                     double* fitness = nullptr) const override;
+
+    Tensile::SolutionSet<Tensile::ContractionSolution>
+    findAllSolutions(Tensile::ContractionProblem const& problem,
+                     Tensile::Hardware const& hardware) const override;
+
+    std::string type() const override;
+    std::string description() const override;
+
+    std::vector<std::shared_ptr<library_type>> parts;
+    // Group of each part, empty when unknown
+    std::vector<std::string> groups;
+
+    private:
+    // The part of the group of the problem, or null if there is none
+    const library_type* owner(Tensile::ContractionProblem const& problem) const;
+};
+
+// Loads the libraries in the directories on at most threads threads and
+// assembles them into one, with each directory the part of its group
+std::shared_ptr<library_type> load_library(const std::vector<std::string>& parts,
+                                           std::size_t threads);
+
+// The library for arch, loaded once per shard on MIOPEN_TENSILE_LOAD_THREADS
+// threads
+const library_type& library(const std::string& arch);
+
+// The library for the current device
+const library_type& library();
+
+// Starts loading the library of arch, its logic index and the index of its
+// code objects in the background. Calls needing them wait for the load
+// instead of starting another.
+void initialize_library(const std::string& arch);
+
+Tensile::hip::SolutionAdapter& adaptor();
+
+struct logic_index;
+
+// The binary index of the logic files installed with the library shard for
+// arch, or null when it was not built
+const logic_index* library_index(const std::string& arch);
+
+const logic_index* library_index();
+
+// Loads code objects and submits kernels. The default launcher goes through
+// the hip solution adapter; a stub lets the host side run without a gpu.
+struct kernel_launcher
+{
+    virtual ~kernel_launcher()                                   = default;
+    virtual void load_code_object(const std::string& path)       = 0;
+    virtual hipError_t launch(const std::vector<Tensile::KernelInvocation>& kernels,
+                              hipStream_t stream)                = 0;
+};
+
+std::shared_ptr<kernel_launcher> hip_kernel_launcher();
+
+// Read without locking on every launch
+kernel_launcher& launcher();
+
+// Launches already started finish on the launcher they found
+void set_kernel_launcher(std::shared_ptr<kernel_launcher> l);
+
+} // namespace miopentensile
+
+#endif
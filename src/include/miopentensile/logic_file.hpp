@@ -0,0 +1,77 @@
+#ifndef MIOPENTENSILE_GUARD_LOGIC_FILE_HPP
+#define MIOPENTENSILE_GUARD_LOGIC_FILE_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace miopentensile {
+
+// The solution parameters of a logic file that are used outside of tensile
+struct logic_solution
+{
+    // Kernel name, empty for the older files that do not record it
+    std::string name;
+    int index                    = 0;
+    int macro_tile0              = 0;
+    int macro_tile1              = 0;
+    int depth_u                  = 0;
+    int global_split_u           = 1;
+    int workgroup_mapping        = 1;
+    int vector_width             = 1;
+    int global_read_vector_width = 1;
+    int num_threads              = 0;
+    int lds_num_elements         = 0;
+    int workspace_per_elem_c     = 0;
+    std::array<int, 3> workgroup = {{0, 0, 0}};
+    bool multiple_buffer         = false;
+};
+
+// One row of the exact table. The sizes are in the free0, free1, batch,
+// summation order used by the logic files; the leading dimensions are zero
+// when the file does not list them.
+struct logic_entry
+{
+    std::uint64_t m     = 0;
+    std::uint64_t n     = 0;
+    std::uint64_t batch = 0;
+    std::uint64_t k     = 0;
+    std::uint64_t ldd   = 0;
+    std::uint64_t ldc   = 0;
+    std::uint64_t lda   = 0;
+    std::uint64_t ldb   = 0;
+    // Position in the solution list of the file
+    int solution        = 0;
+    double gflops       = 0;
+};
+
+struct logic_file
+{
+    std::string path;
+    std::string schedule;
+    std::string arch;
+    // Name of the operation from the file name, e.g. Cijk_Ailk_Bjlk_HBH
+    std::string operation;
+    std::vector<std::string> devices;
+    bool transpose_a               = false;
+    bool transpose_b               = false;
+    bool high_precision_accumulate = false;
+    // False for the _GB files, whose batches are given by pointer arrays
+    bool strided_batched           = true;
+    bool cu_efficiency             = false;
+    int data_type                  = 0;
+    int dest_data_type             = 0;
+    int compute_data_type          = 0;
+    std::vector<logic_solution> solutions;
+    std::vector<logic_entry> exact;
+};
+
+// Reads the parts of a tensile logic yaml file described above. This is a
+// line based reader for the layout written by tensile, not a general yaml
+// parser.
+logic_file parse_logic_file(const std::string& path);
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef MIOPENTENSILE_GUARD_LOGIC_INDEX_HPP
+#define MIOPENTENSILE_GUARD_LOGIC_INDEX_HPP
+
+#include <miopentensile/logic_file.hpp>
+#include <miopentensile/nearest_size.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace miopentensile {
+
+// Flat binary form of a set of logic files. All records are fixed size and
+// are read in place from a read-only mapping, so the file pages are shared
+// between processes and only the pages that are searched are touched.
+//
+// Layout: header, string table, type table, solution table, entry table.
+// Types are sorted by (arch, operation, cu_efficiency). Each type owns a
+// contiguous range of solutions and entries, and its entries are sorted by
+// (m, n, batch, k) and then by decreasing gflops. The cost model parameters
+// of each type are fitted when the index is compiled.
+namespace logic_index_format {
+
+const std::uint32_t magic   = 0x494c544d; // "MTLI"
+const std::uint32_t version = 3;
+
+struct header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t file_size;
+    // FNV-1a hash of everything after the header
+    std::uint64_t content_hash;
+    std::uint64_t string_offset;
+    std::uint64_t string_size;
+    std::uint64_t type_offset;
+    std::uint64_t type_count;
+    std::uint64_t solution_offset;
+    std::uint64_t solution_count;
+    std::uint64_t entry_offset;
+    std::uint64_t entry_count;
+};
+
+// The cost_params fitted to the entries of a type, all zero when the type
+// has too few entries to fit
+struct cost_record
+{
+    double flops_per_cycle;
+    double bytes_per_cycle;
+    double wave_cycles;
+    double vector_cost;
+    double read_cost;
+};
+
+// One logic file. Strings are offsets into the string table.
+struct type_record
+{
+    std::uint32_t path;
+    std::uint32_t schedule;
+    std::uint32_t arch;
+    std::uint32_t operation;
+    // Device names separated by ';'
+    std::uint32_t devices;
+    std::int32_t data_type;
+    std::int32_t dest_data_type;
+    std::int32_t compute_data_type;
+    std::uint8_t transpose_a;
+    std::uint8_t transpose_b;
+    std::uint8_t high_precision_accumulate;
+    std::uint8_t strided_batched;
+    std::uint8_t cu_efficiency;
+    std::uint8_t reserved[3];
+    std::uint32_t first_solution;
+    std::uint32_t solution_count;
+    std::uint64_t first_entry;
+    std::uint64_t entry_count;
+    cost_record cost;
+};
+
+struct solution_record
+{
+    std::uint32_t name;
+    std::int32_t index;
+    std::int32_t macro_tile0;
+    std::int32_t macro_tile1;
+    std::int32_t depth_u;
+    std::int32_t global_split_u;
+    std::int32_t workgroup_mapping;
+    std::int32_t vector_width;
+    std::int32_t global_read_vector_width;
+    std::int32_t num_threads;
+    std::int32_t lds_num_elements;
+    std::int32_t workspace_per_elem_c;
+    std::int32_t workgroup[3];
+    std::uint32_t multiple_buffer;
+};
+
+struct entry_record
+{
+    std::uint64_t m;
+    std::uint64_t n;
+    std::uint64_t batch;
+    std::uint64_t k;
+    std::uint64_t ldd;
+    std::uint64_t ldc;
+    std::uint64_t lda;
+    std::uint64_t ldb;
+    // Position in the solution table of the whole index
+    std::uint32_t solution;
+    std::uint32_t type;
+    double gflops;
+};
+
+static_assert(sizeof(header) == 88, "Unexpected index header size");
+static_assert(sizeof(type_record) == 104, "Unexpected index type size");
+static_assert(sizeof(solution_record) == 64, "Unexpected index solution size");
+static_assert(sizeof(entry_record) == 80, "Unexpected index entry size");
+
+} // namespace logic_index_format
+
+// 64 bit FNV-1a hash of n bytes, continuing from hash
+std::uint64_t fnv1a(const void* data, std::size_t n, std::uint64_t hash = 0xcbf29ce484222325ull);
+
+// Writes the index for the files, replacing path atomically. The cost
+// parameters are left zero.
+void write_logic_index(const std::vector<logic_file>& files, const std::string& path);
+
+// Replaces the cost parameters of every type of the index at path, in type
+// order, atomically
+void write_logic_costs(const std::string& path,
+                       const std::vector<logic_index_format::cost_record>& costs);
+
+template <class T>
+struct record_range
+{
+    const T* first = nullptr;
+    const T* last  = nullptr;
+    const T* begin() const { return first; }
+    const T* end() const { return last; }
+    std::size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+};
+
+// Read-only view of an index file
+struct logic_index
+{
+    using header          = logic_index_format::header;
+    using type_record     = logic_index_format::type_record;
+    using solution_record = logic_index_format::solution_record;
+    using entry_record    = logic_index_format::entry_record;
+
+    static const std::size_t npos = -1;
+
+    // Maps the file; throws if it is not an index of the supported version
+    explicit logic_index(const std::string& path);
+    ~logic_index();
+
+    logic_index(const logic_index&) = delete;
+    logic_index& operator=(const logic_index&) = delete;
+
+    std::uint64_t content_hash() const { return get_header().content_hash; }
+    std::size_t size_bytes() const { return size; }
+
+    std::size_t type_count() const { return get_header().type_count; }
+    const type_record& type(std::size_t i) const { return types[i]; }
+    std::size_t solution_count() const { return get_header().solution_count; }
+    const solution_record& solution(std::size_t i) const { return solutions[i]; }
+    std::size_t entry_count() const { return get_header().entry_count; }
+    const entry_record& entry(std::size_t i) const { return entries[i]; }
+
+    const char* string(std::uint32_t offset) const { return strings + offset; }
+
+    record_range<solution_record> solutions_of(const type_record& t) const;
+    record_range<entry_record> entries_of(const type_record& t) const;
+
+    // The type for an operation such as Cijk_Ailk_Bjlk_HBH on arch, or npos
+    std::size_t
+    find_type(const std::string& arch, const std::string& operation, bool cu_efficiency = false) const;
+
+    // All the entries of the type with exactly this size, best first
+    record_range<entry_record> find_exact(std::size_t type,
+                                          std::uint64_t m,
+                                          std::uint64_t n,
+                                          std::uint64_t batch,
+                                          std::uint64_t k) const;
+
+    struct nearest_entry
+    {
+        // Best entry of the closest size in the table, null if it is empty
+        const entry_record* entry = nullptr;
+        // Squared distance in log2 space, zero for an exact match
+        double distance = 0;
+    };
+
+    // The closest benchmarked size of the type. The search tree of a type is
+    // built on its first query.
+    nearest_entry find_nearest(std::size_t type,
+                               std::uint64_t m,
+                               std::uint64_t n,
+                               std::uint64_t batch,
+                               std::uint64_t k) const;
+
+    private:
+    const header& get_header() const { return *reinterpret_cast<const header*>(data); }
+
+    struct size_tree
+    {
+        std::once_flag flag;
+        nearest_size_tree tree;
+        // The best entry of each distinct size, in tree id order
+        std::vector<const entry_record*> entries;
+    };
+
+    const unsigned char* data = nullptr;
+    std::size_t size          = 0;
+    const char* strings       = nullptr;
+    const type_record* types  = nullptr;
+    const solution_record* solutions = nullptr;
+    const entry_record* entries      = nullptr;
+    std::unique_ptr<size_tree[]> trees;
+};
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef MIOPENTENSILE_GUARD_LOGIC_PROBLEM_HPP
+#define MIOPENTENSILE_GUARD_LOGIC_PROBLEM_HPP
+
+#include <miopentensile/gemm.h>
+#include <miopentensile/cost_model.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/problem_key.hpp>
+#include <Tensile/Tensile.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace miopentensile {
+
+// Operands of a gemm in tensile order, ie b, a, c of the gemm api
+struct tensile_operands
+{
+    miopen_tensile_matrix a;
+    miopen_tensile_matrix b;
+    miopen_tensile_matrix c;
+};
+
+// The type of the inputs of a logic file if the gemm api can express its
+// problems, ie the file is strided batched and one of SB, HBH, BBH or 4xi8BH
+bool logic_input_type(const logic_index::type_record& t, miopen_tensile_type& result);
+
+// Operands with no data for a size from the exact table of a logic file.
+// The strides are packed unless the table lists leading dimensions.
+tensile_operands logic_operands(const logic_index::type_record& t,
+                                const logic_index::entry_record& e);
+
+// The operation of the logic files that hold problems of the key, such as
+// Cijk_Ailk_Bjlk_HBH, or an empty string if no logic file can
+std::string logic_operation(const problem_key& key);
+
+// The type of the logic file for the key on arch, or logic_index::npos
+std::size_t
+find_logic_type(const logic_index& index, const std::string& arch, const problem_key& key);
+
+// Size of the key in the m, n, batch, k units of the logic tables
+nearest_size_tree::size_type logic_size(const problem_key& key);
+
+// The closest size to the key in the exact table of its logic file for arch
+logic_index::nearest_entry
+find_nearest_entry(const logic_index& index, const std::string& arch, const problem_key& key);
+
+struct logic_estimate
+{
+    double gflops   = 0;
+    double distance = 0;
+};
+
+// For each named solution of the logic file for the key, the measured gflops
+// of its table entry closest in size to the key
+std::unordered_map<std::string, logic_estimate>
+logic_solution_estimates(const logic_index& index, const std::string& arch, const problem_key& key);
+
+struct ranked_solution
+{
+    const logic_index::solution_record* solution = nullptr;
+    cost_estimate estimate;
+};
+
+// Named solutions of the logic file for the key, fastest first on hw by the
+// cost parameters stored in the index. When the key is for part of a device
+// the logic file tuned for efficiency per cu is included.
+std::vector<ranked_solution> rank_logic_solutions(const logic_index& index,
+                                                  const std::string& arch,
+                                                  const problem_key& key,
+                                                  const Tensile::Hardware& hw);
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef MIOPENTENSILE_GUARD_NEAREST_SIZE_HPP
+#define MIOPENTENSILE_GUARD_NEAREST_SIZE_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace miopentensile {
+
+// A k-d tree over gemm sizes (m, n, batch, k). Distances are euclidean over
+// the log2 of each dimension, so a size twice as large in one dimension is
+// equally far whatever its magnitude.
+struct nearest_size_tree
+{
+    using size_type = std::array<std::uint64_t, 4>;
+
+    static const std::size_t npos = -1;
+
+    struct result
+    {
+        // Position of the size in the vector the tree was built from
+        std::size_t id = npos;
+        // Squared distance in log2 space
+        double distance = 0;
+    };
+
+    nearest_size_tree() = default;
+    explicit nearest_size_tree(const std::vector<size_type>& sizes);
+
+    result nearest(const size_type& s) const;
+
+    std::size_t size() const { return nodes.size(); }
+
+    // The squared distance the tree uses between two sizes
+    static double distance(const size_type& x, const size_type& y);
+
+    private:
+    using point = std::array<double, 4>;
+
+    struct node
+    {
+        point p;
+        std::size_t id;
+        std::size_t axis;
+    };
+
+    static point to_point(const size_type& s);
+    void build(std::size_t first, std::size_t last);
+    void search(std::size_t first, std::size_t last, const point& q, result& best) const;
+
+    std::vector<node> nodes;
+};
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef MIOPENTENSILE_GUARD_PROBLEM_HPP
+#define MIOPENTENSILE_GUARD_PROBLEM_HPP
+
+#include <miopentensile/gemm.h>
+#include <miopentensile/problem_key.hpp>
+#include <Tensile/Contractions.hpp>
+
+namespace miopentensile {
+
+bool is_transposed(const miopen_tensile_matrix& a);
+
+size_t get_ld(const miopen_tensile_matrix& a);
+
+Tensile::DataType get_data_type(const miopen_tensile_matrix& a);
+
+// The matrix with its rows and columns exchanged, over the same data
+miopen_tensile_matrix transpose(const miopen_tensile_matrix& a);
+
+// A gemm in the normal form plans are created for, in tensile operand order.
+// Equivalent gemms have the same form, so they share plans and logic table
+// entries. When swapped is set the form computes the transpose of c, and it
+// reads the data the original gemm gave as b through a and the other way round.
+struct canonical_gemm
+{
+    miopen_tensile_matrix a;
+    miopen_tensile_matrix b;
+    miopen_tensile_matrix c;
+    bool swapped = false;
+};
+
+// Takes the transpose of a c stored by columns by swapping the operands,
+// picks the unused strides of dimensions of length one, drops a batch of one
+// and merges batches whose rows follow each other in the a of the gemm api
+// and in c, when they share b, into the rows of a single gemm. The matrices
+// are in tensile operand order.
+canonical_gemm canonicalize(const miopen_tensile_matrix& a,
+                            const miopen_tensile_matrix& b,
+                            const miopen_tensile_matrix& c);
+
+// A beta of neither zero nor one, used to select solutions that work for any
+// beta
+const double generic_beta = 2.0;
+
+// The matrices are in tensile operand order, ie b, a, c of the gemm api
+problem_key create_problem_key(const miopen_tensile_matrix& a,
+                               const miopen_tensile_matrix& b,
+                               const miopen_tensile_matrix& c,
+                               double beta,
+                               int device);
+
+// Solutions are selected for the beta given, so a problem with a beta of
+// zero may get kernels that do not read c
+Tensile::ContractionProblem create_tensile_problem(const miopen_tensile_matrix& a,
+                                                   const miopen_tensile_matrix& b,
+                                                   const miopen_tensile_matrix& c,
+                                                   double beta);
+
+} // namespace miopentensile
+
+#endif
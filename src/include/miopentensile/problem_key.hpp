@@ -0,0 +1,142 @@
+#ifndef MIOPENTENSILE_GUARD_PROBLEM_KEY_HPP
+#define MIOPENTENSILE_GUARD_PROBLEM_KEY_HPP
+
+#include <miopentensile/gemm.h>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+
+namespace miopentensile {
+
+// Kernels can be specialized for a beta of zero, which skips reading c, or of
+// one. Plans for other values work with any beta.
+enum beta_class
+{
+    beta_other,
+    beta_zero,
+    beta_one
+};
+
+inline beta_class get_beta_class(double beta)
+{
+    if(beta == 0)
+        return beta_zero;
+    if(beta == 1)
+        return beta_one;
+    return beta_other;
+}
+
+// Everything that can change which solution is selected for a gemm, in the
+// operand order used for the tensile problem
+struct problem_key
+{
+    bool transpose_a               = false;
+    bool transpose_b               = false;
+    std::size_t m                  = 0;
+    std::size_t n                  = 0;
+    std::size_t k                  = 0;
+    std::size_t batch              = 0;
+    std::size_t lda                = 0;
+    std::size_t ldb                = 0;
+    std::size_t ldc                = 0;
+    std::size_t stride_a           = 0;
+    std::size_t stride_b           = 0;
+    std::size_t stride_c           = 0;
+    miopen_tensile_type type_a     = miopen_tensile_type_float;
+    miopen_tensile_type type_b     = miopen_tensile_type_float;
+    miopen_tensile_type type_c     = miopen_tensile_type_float;
+    bool high_precision_accumulate = false;
+    beta_class beta                = beta_other;
+    // Largest workspace in bytes the solution may use
+    std::size_t max_workspace = 0;
+    // Id of the solution to use, or zero to select one
+    std::uint64_t solution_id = 0;
+    // Batch items are given by arrays of pointers instead of strides
+    bool pointer_batched = false;
+    // The gemm was put in normal form by swapping a and b, see canonicalize()
+    bool swap_operands = false;
+    int device         = 0;
+    // Compute units of the device to select for, zero for all of them
+    std::size_t cu_count = 0;
+
+    auto as_tuple() const
+    {
+        return std::make_tuple(transpose_a,
+                               transpose_b,
+                               m,
+                               n,
+                               k,
+                               batch,
+                               lda,
+                               ldb,
+                               ldc,
+                               stride_a,
+                               stride_b,
+                               stride_c,
+                               type_a,
+                               type_b,
+                               type_c,
+                               high_precision_accumulate,
+                               beta,
+                               max_workspace,
+                               solution_id,
+                               pointer_batched,
+                               swap_operands,
+                               device,
+                               cu_count);
+    }
+
+    friend bool operator==(const problem_key& x, const problem_key& y)
+    {
+        return x.as_tuple() == y.as_tuple();
+    }
+    friend bool operator!=(const problem_key& x, const problem_key& y) { return !(x == y); }
+};
+
+inline void hash_combine(std::size_t& seed, std::size_t x)
+{
+    seed ^= x + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+struct problem_key_hash
+{
+    std::size_t operator()(const problem_key& x) const
+    {
+        std::size_t result = 0;
+        for(auto v : {std::size_t(x.transpose_a),
+                      std::size_t(x.transpose_b),
+                      x.m,
+                      x.n,
+                      x.k,
+                      x.batch,
+                      x.lda,
+                      x.ldb,
+                      x.ldc,
+                      x.stride_a,
+                      x.stride_b,
+                      x.stride_c,
+                      std::size_t(x.type_a),
+                      std::size_t(x.type_b),
+                      std::size_t(x.type_c),
+                      std::size_t(x.high_precision_accumulate),
+                      std::size_t(x.beta),
+                      x.max_workspace,
+                      std::size_t(x.solution_id),
+                      std::size_t(x.pointer_batched),
+                      std::size_t(x.swap_operands),
+                      std::size_t(x.device),
+                      x.cu_count})
+            hash_combine(result, v);
+        // Mix the final value so the low bits used for shard selection are
+        // well distributed
+        result ^= result >> 33;
+        result *= 0xff51afd7ed558ccdull;
+        result ^= result >> 33;
+        return result;
+    }
+};
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef MIOPENTENSILE_GUARD_SOLUTION_CACHE_HPP
+#define MIOPENTENSILE_GUARD_SOLUTION_CACHE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace miopentensile {
+
+struct cache_stats
+{
+    std::size_t hits      = 0;
+    std::size_t misses    = 0;
+    std::size_t evictions = 0;
+    std::size_t size      = 0;
+};
+
+// A bounded map from Key to Value split into independently locked shards.
+//
+// Hits are served from a small per-thread direct-mapped table that is
+// validated against the shard generation, so a hit takes no lock and does no
+// allocation. Its only shared write is the hit count, spread over counters on
+// separate cache lines. Misses and insertions go through the shard mutex.
+// Eviction is LRU at the granularity of the shard clock, which advances on
+// every insertion.
+template <class Key, class Value, class Hash = std::hash<Key>>
+struct sharded_cache
+{
+    explicit sharded_cache(std::size_t capacity, std::size_t nshards = 16)
+        : shard_count(std::max<std::size_t>(nshards, 1)),
+          shard_capacity(std::max<std::size_t>((capacity + shard_count - 1) / shard_count, 1)),
+          shards(new shard[shard_count]),
+          id(next_id())
+    {
+    }
+
+    sharded_cache(const sharded_cache&) = delete;
+    sharded_cache& operator=(const sharded_cache&) = delete;
+
+    // Return the cached value for key, calling make() to create it on a miss.
+    // make() runs without holding any lock, so concurrent misses on the same
+    // key may both call it; the first value inserted wins.
+    template <class F>
+    Value get(const Key& key, F make)
+    {
+        auto h      = Hash{}(key);
+        auto& s     = shards[h % shard_count];
+        auto& local = local_slots()[(h / shard_count) % local_size];
+        if(local.id == id and local.hash == h and
+           local.generation == s.generation.load(std::memory_order_acquire) and
+           local.entry->key == key)
+        {
+            touch(*local.entry, s);
+            count_hit();
+            return local.entry->value;
+        }
+
+        auto e = find(s, key);
+        if(e == nullptr)
+        {
+            s.misses.fetch_add(1, std::memory_order_relaxed);
+            e = insert(s, key, make());
+        }
+        else
+        {
+            count_hit();
+        }
+        local.id         = id;
+        local.hash       = h;
+        local.generation = s.generation.load(std::memory_order_acquire);
+        local.entry      = e;
+        return e->value;
+    }
+
+    cache_stats stats() const
+    {
+        cache_stats result;
+        for(auto&& c : hits)
+            result.hits += c.count.load(std::memory_order_relaxed);
+        for(std::size_t i = 0; i < shard_count; i++)
+        {
+            auto& s = shards[i];
+            result.misses += s.misses.load(std::memory_order_relaxed);
+            result.evictions += s.evictions.load(std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(s.mutex);
+            result.size += s.table.size();
+        }
+        return result;
+    }
+
+    void clear()
+    {
+        for(std::size_t i = 0; i < shard_count; i++)
+        {
+            auto& s = shards[i];
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.table.clear();
+            s.generation.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    std::size_t capacity() const { return shard_count * shard_capacity; }
+
+    private:
+    struct entry
+    {
+        entry(const Key& k, Value v, std::uint64_t t) : key(k), value(std::move(v)), last_used(t)
+        {
+        }
+        Key key;
+        Value value;
+        std::atomic<std::uint64_t> last_used;
+    };
+    using entry_ptr = std::shared_ptr<entry>;
+
+    struct shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<Key, entry_ptr, Hash> table;
+        std::atomic<std::uint64_t> generation{0};
+        std::atomic<std::uint64_t> clock{0};
+        std::atomic<std::uint64_t> misses{0};
+        std::atomic<std::uint64_t> evictions{0};
+        // Keep the counters of neighbouring shards on separate cache lines
+        char padding[64];
+    };
+
+    struct local_slot
+    {
+        std::uint64_t id         = 0;
+        std::size_t hash         = 0;
+        std::uint64_t generation = 0;
+        entry_ptr entry          = nullptr;
+    };
+
+    struct hit_counter
+    {
+        std::atomic<std::uint64_t> count{0};
+        char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    static const std::size_t local_size   = 64;
+    static const std::size_t hit_counters = 16;
+
+    // Entries are only marked when the clock moved since they were last
+    // used, so threads hitting the same entry do not keep writing to it
+    static void touch(entry& e, const shard& s)
+    {
+        auto t = s.clock.load(std::memory_order_relaxed);
+        if(e.last_used.load(std::memory_order_relaxed) != t)
+            e.last_used.store(t, std::memory_order_relaxed);
+    }
+
+    void count_hit()
+    {
+        static std::atomic<std::size_t> threads{0};
+        thread_local const std::size_t stripe = threads++;
+        hits[stripe % hit_counters].count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static local_slot* local_slots()
+    {
+        thread_local std::array<local_slot, local_size> slots;
+        return slots.data();
+    }
+
+    static std::uint64_t next_id()
+    {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+
+    entry_ptr find(shard& s, const Key& key) const
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.table.find(key);
+        if(it == s.table.end())
+            return nullptr;
+        touch(*it->second, s);
+        return it->second;
+    }
+
+    entry_ptr insert(shard& s, const Key& key, Value value)
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.table.find(key);
+        if(it != s.table.end())
+            return it->second;
+        if(s.table.size() >= shard_capacity)
+        {
+            auto oldest = std::min_element(s.table.begin(), s.table.end(), [](auto&& x, auto&& y) {
+                return x.second->last_used.load(std::memory_order_relaxed) <
+                       y.second->last_used.load(std::memory_order_relaxed);
+            });
+            s.table.erase(oldest);
+            s.evictions.fetch_add(1, std::memory_order_relaxed);
+            // Invalidate the per-thread copies of this shard
+            s.generation.fetch_add(1, std::memory_order_release);
+        }
+        auto t = s.clock.fetch_add(1, std::memory_order_relaxed) + 1;
+        auto e = std::make_shared<entry>(key, std::move(value), t);
+        s.table.emplace(key, e);
+        return e;
+    }
+
+    std::size_t shard_count;
+    std::size_t shard_capacity;
+    std::unique_ptr<shard[]> shards;
+    std::array<hit_counter, hit_counters> hits;
+    std::uint64_t id;
+};
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef MIOPENTENSILE_GUARD_SOLUTION_LIST_HPP
+#define MIOPENTENSILE_GUARD_SOLUTION_LIST_HPP
+
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/library.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace miopentensile {
+
+// Id of a solution that stays the same across processes and library builds
+// as long as the kernel does: the FNV-1a hash of its kernel name
+std::uint64_t solution_id(const Tensile::ContractionSolution& s);
+
+struct solution_info
+{
+    std::uint64_t id = 0;
+    solution_ptr solution;
+    // Measured gflops of the table entry of the solution closest in size to
+    // the problem, zero when the tables do not list the solution
+    double predicted_gflops = 0;
+    // Squared log2 distance from the problem to the size of that entry
+    double size_distance       = 0;
+    std::size_t workspace_size = 0;
+};
+
+// Every solution that can run the gemm, with any workspace. Solutions
+// measured at sizes closer to the problem come first, and faster ones first
+// among those measured at the same size. The matrices are in tensile operand
+// order.
+std::vector<solution_info> find_solutions(const miopen_tensile_matrix& a,
+                                          const miopen_tensile_matrix& b,
+                                          const miopen_tensile_matrix& c,
+                                          double beta,
+                                          int device);
+
+// The solution with the id if it can run the problem, otherwise null
+solution_ptr find_solution(const library_type& lib,
+                           const Tensile::ContractionProblem& problem,
+                           const Tensile::Hardware& hw,
+                           std::uint64_t id);
+
+} // namespace miopentensile
+
+#endif
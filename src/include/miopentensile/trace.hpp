@@ -0,0 +1,124 @@
+#ifndef MIOPENTENSILE_GUARD_TRACE_HPP
+#define MIOPENTENSILE_GUARD_TRACE_HPP
+
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace miopentensile {
+
+// One api call. Times are nanoseconds on trace_clock.
+struct trace_record
+{
+    const char* call = nullptr;
+    // The plan the call ran, null for calls that run several
+    gemm_plan_ptr plan;
+    std::int64_t start   = 0;
+    std::int64_t planned = 0;
+    std::int64_t end     = 0;
+    // Spent choosing solutions for plans created by the call
+    std::int64_t select = 0;
+    // Every plan the call used was already cached
+    bool cache_hit               = true;
+    miopen_tensile_status status = miopen_tensile_status_unknown;
+    // Scalars of calls that run a gemm
+    bool has_scalars = false;
+    double alpha     = 1.0;
+    double beta      = 0.0;
+};
+
+enum trace_format
+{
+    trace_jsonl,
+    trace_chrome
+};
+
+extern std::atomic<bool> trace_enabled;
+
+inline bool tracing() { return trace_enabled.load(std::memory_order_relaxed); }
+
+std::int64_t trace_clock();
+
+// The record of the api call running on this thread, or null when it is not
+// traced
+trace_record* current_trace();
+
+// Marks the current call as having created a plan
+inline void trace_miss()
+{
+    if(auto* t = current_trace())
+        t->cache_hit = false;
+}
+
+trace_record* begin_trace(const char* call);
+void end_trace(trace_record& r);
+void trace_plan(trace_record& r, const gemm_plan_ptr& p);
+
+// Traces an api call for its lifetime. Records go to a ring buffer owned by
+// the calling thread. A full ring is handed to a writer thread, which formats
+// and writes it while the calling thread fills a second buffer; what is left
+// is written when the thread exits and when tracing stops. Without tracing
+// the cost is one branch on a relaxed load.
+struct trace_call
+{
+    explicit trace_call(const char* call)
+    {
+        if(tracing())
+            record = begin_trace(call);
+    }
+    ~trace_call()
+    {
+        if(record != nullptr)
+            end_trace(*record);
+    }
+
+    trace_call(const trace_call&) = delete;
+    trace_call& operator=(const trace_call&) = delete;
+
+    void planned(const gemm_plan_ptr& p)
+    {
+        if(record != nullptr)
+            trace_plan(*record, p);
+    }
+
+    void scalars(double alpha, double beta)
+    {
+        if(record != nullptr)
+        {
+            record->has_scalars = true;
+            record->alpha       = alpha;
+            record->beta        = beta;
+        }
+    }
+
+    miopen_tensile_status finish(miopen_tensile_status s)
+    {
+        if(record != nullptr)
+            record->status = s;
+        return s;
+    }
+
+    trace_record* record = nullptr;
+};
+
+// Names used for the fields of a record
+const char* type_name(miopen_tensile_type t);
+const char* beta_name(beta_class b);
+const char* source_name(gemm_plan::source_type s);
+
+// Starts writing records to path, where %p is replaced by the process id.
+// Tracing starts at load when MIOPEN_TENSILE_TRACE names a file, in the format
+// given by MIOPEN_TENSILE_TRACE_FORMAT (jsonl or chrome), with
+// MIOPEN_TENSILE_TRACE_BUFFER records per thread.
+// Not safe to call while other threads are in the api.
+void start_trace(const std::string& path, trace_format format, std::size_t buffer_size = 1024);
+
+// Writes out the records of every thread and closes the file. Not safe to
+// call while other threads are in the api.
+void stop_trace();
+
+} // namespace miopentensile
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef MIOPENTENSILE_GUARD_TUNING_HPP
+#define MIOPENTENSILE_GUARD_TUNING_HPP
+
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/logic_problem.hpp>
+#include <miopentensile/problem_key.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace miopentensile {
+
+// Solutions picked by timing, kept in a text file with one record per line:
+// a key from tuning_key followed by the solution id in hex. Many processes
+// may share the file. A write holds an exclusive lock on path.lock, merges
+// with the records on disk and replaces the file by renaming, so readers
+// never see a partial file and concurrent writers do not lose records.
+struct tuning_db
+{
+    explicit tuning_db(std::string p);
+
+    const std::string& path() const { return file; }
+
+    // The solution recorded for the key, or zero. The file is read again
+    // when it changed since the last read.
+    std::uint64_t find(const std::string& key);
+
+    // Records the solution for the key; throws if the file cannot be written
+    void store(const std::string& key, std::uint64_t id);
+
+    std::size_t size();
+
+    private:
+    void refresh();
+
+    std::string file;
+    std::unordered_map<std::string, std::uint64_t> records;
+    // Version and size of the file when it was last read
+    std::int64_t read_version = -1;
+    std::int64_t read_size    = -1;
+    std::mutex mutex;
+};
+
+// The device, the content hash of the logic index of its architecture and the
+// problem, without spaces. The device ordinal, workspace capacity and pinned
+// solution do not change which solution is fastest, so they are left out.
+std::string tuning_key(const problem_key& key, const Tensile::Hardware& hw);
+
+// Times plans for tuning. The default timer runs the plan on scratch device
+// buffers; a stub lets the tuning logic run without a gpu.
+struct solution_timer
+{
+    virtual ~solution_timer() = default;
+    // Milliseconds per run of the plan for the operands, in tensile order
+    virtual double time(const gemm_plan& p, const tensile_operands& x) = 0;
+};
+
+std::shared_ptr<solution_timer> hip_solution_timer();
+
+struct tuning_options
+{
+    // The database file, or empty to not use one
+    std::string db_path;
+    // Candidates timed for a problem missing from the database, zero to not
+    // tune
+    std::size_t candidates = 0;
+};
+
+// MIOPEN_TENSILE_TUNING_DB and MIOPEN_TENSILE_TUNE. Tuning without a database
+// set records in $XDG_CACHE_HOME/miopentensile/tuning.db or
+// $HOME/.cache/miopentensile/tuning.db; with neither set there is no database.
+tuning_options default_tuning_options();
+
+// Not safe to call while other threads are creating plans
+void set_tuning_options(const tuning_options& o);
+void set_solution_timer(std::shared_ptr<solution_timer> t);
+
+// Times the first candidates of find_solutions that fit in max_workspace and
+// returns the id of the fastest, or zero if none could run
+std::uint64_t tune_solution(const tensile_operands& x,
+                            double beta,
+                            int device,
+                            std::size_t max_workspace,
+                            std::size_t candidates,
+                            solution_timer& timer);
+
+// The solution recorded in the database for the plan's problem. When there is
+// none and tuning is enabled the candidates are timed first and the fastest is
+// recorded. Null if there is no usable record.
+solution_ptr tuned_solution(const gemm_plan& p, const tensile_operands& x, double beta);
+
+} // namespace miopentensile
+
+#endif
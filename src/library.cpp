@@ -0,0 +1,469 @@
+#include <miopentensile/library.hpp>
+#include <miopentensile/code_objects.hpp>
+#include <miopentensile/gemm.h>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <Tensile/Contractions.hpp>
+#include <Tensile/EmbeddedLibrary.hpp>
+#include <dlfcn.h>
+#include <glob.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
+
+namespace miopentensile {
+
+std::vector<std::string> glob_files(const std::string& s)
+{
+    std::vector<std::string> result;
+    glob_t raw_glob_result;
+    int e = glob(s.c_str(), GLOB_TILDE_CHECK | GLOB_NOSORT, nullptr, &raw_glob_result);
+    std::shared_ptr<std::remove_pointer_t<glob_t>> glob_result(&raw_glob_result, &globfree);
+
+    if (e == GLOB_NOMATCH)
+        return result;
+    if (e != 0)
+        throw std::runtime_error("Glob failed: " + s);
+
+    for(std::size_t i = 0; i < glob_result->gl_pathc; ++i)
+        result.push_back(glob_result->gl_pathv[i]);
+    return result;
+}
+
+std::size_t env_size(const char* name, std::size_t default_value)
+{
+    const char* value = std::getenv(name);
+    if(value == nullptr or *value == '\0')
+        return default_value;
+    return std::strtoull(value, nullptr, 10);
+}
+
+std::string library_root()
+{
+    std::string path = "";
+    Dl_info info;
+
+    // Find the location of .so
+    if(dladdr((void*)miopen_tensile_gemm_hip, &info))
+    {
+        path = info.dli_fname;
+        auto i = path.rfind('/');
+        if (i != std::string::npos)
+            path = path.substr(0, i);
+        else
+            path = "";
+    }
+    return path + "/miopentensile/";
+}
+
+std::string library_path()
+{
+    return library_root() + "library/";
+}
+
+// Maps an architecture to the directory of its shard, relative to the library
+// root. Each line of the manifest is an architecture followed by a directory.
+// Without a manifest the build produced a single merged library.
+std::unordered_map<std::string, std::string> read_library_manifest()
+{
+    std::unordered_map<std::string, std::string> result;
+    std::ifstream is(library_path() + "TensileManifest.txt");
+    std::string arch;
+    std::string dir;
+    while(is >> arch >> dir)
+        result[arch] = dir;
+    return result;
+}
+
+std::string library_path(const std::string& arch)
+{
+    static const auto manifest = read_library_manifest();
+    if(manifest.empty() or arch.empty())
+        return library_path();
+    auto it = manifest.find(arch);
+    if(it == manifest.end())
+        throw std::runtime_error("No tensile library was built for " + arch);
+    return library_root() + it->second;
+}
+
+const char* library_file_name()
+{
+#if TENSILE_USE_LLVM && !TENSILE_USE_MSGPACK
+    return "TensileLibrary.yaml";
+#else
+    return "TensileLibrary.dat";
+#endif
+}
+
+// Each line of the parts file is the directory of a part, relative to the
+// shard. A part without a library file has no logic for the architectures
+// of the shard.
+std::vector<std::string> library_parts(const std::string& path)
+{
+    std::ifstream is(path + "TensileLibraryParts.txt");
+    if(not is)
+        return {path};
+    std::vector<std::string> result;
+    std::string dir;
+    while(is >> dir)
+    {
+        if(access((path + dir + library_file_name()).c_str(), R_OK) == 0)
+            result.push_back(path + dir);
+    }
+    return result;
+}
+
+std::vector<std::string> library_code_objects(const std::string& path)
+{
+    std::vector<std::string> result;
+    for(auto&& part : library_parts(path))
+    {
+        auto files = glob_files(part + "*co");
+        result.insert(result.end(), files.begin(), files.end());
+    }
+    return result;
+}
+
+void parallel_for(std::size_t n, std::size_t threads, const std::function<void(std::size_t)>& f)
+{
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto work = [&] {
+        for(auto i = next++; i < n; i = next++)
+        {
+            try
+            {
+                f(i);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if(error == nullptr)
+                    error = std::current_exception();
+            }
+        }
+    };
+    // The calling thread is one of the workers
+    std::vector<std::thread> workers;
+    for(std::size_t t = 1; t < std::min(threads, n); t++)
+        workers.emplace_back(work);
+    work();
+    for(auto&& w : workers)
+        w.join();
+    if(error != nullptr)
+        std::rethrow_exception(error);
+}
+
+std::string library_group(const Tensile::ContractionProblem& problem)
+{
+    using Tensile::DataType;
+    auto a = problem.a().dataType();
+    auto d = problem.d().dataType();
+    if(a == d)
+    {
+        switch(a)
+        {
+        case DataType::Float: return "SB";
+        case DataType::Double: return "DB";
+        case DataType::ComplexFloat: return "CB";
+        case DataType::ComplexDouble: return "ZB";
+        case DataType::Half: return problem.highPrecisionAccumulate() ? "HBH" : "HB";
+        case DataType::BFloat16: return "BBH";
+        default: return "";
+        }
+    }
+    if(a == DataType::Int8x4 and d == DataType::Int32)
+        return "4xi8BH";
+    if(a == DataType::Int8 and d == DataType::Int32)
+        return "I8II";
+    if(a == DataType::Half and d == DataType::Float)
+        return "HSS";
+    if(a == DataType::BFloat16 and d == DataType::Float)
+        return "BSS";
+    return "";
+}
+
+std::string library_part_group(const std::string& path)
+{
+    auto dir = path;
+    while(not dir.empty() and dir.back() == '/')
+        dir.pop_back();
+    const std::string library = "/library";
+    if(dir.size() > library.size() and
+       dir.compare(dir.size() - library.size(), library.size(), library) == 0)
+        dir.resize(dir.size() - library.size());
+    return dir.substr(dir.rfind('/') + 1);
+}
+
+library_set::library_set(std::vector<std::shared_ptr<library_type>> libraries,
+                         std::vector<std::string> library_groups)
+    : parts(std::move(libraries)), groups(std::move(library_groups))
+{
+    groups.resize(parts.size());
+}
+
+const library_type* library_set::owner(Tensile::ContractionProblem const& problem) const
+{
+    auto group = library_group(problem);
+    if(group.empty())
+        return nullptr;
+    for(std::size_t i = 0; i < parts.size(); i++)
+    {
+        if(groups[i] == group)
+            return parts[i].get();
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Tensile::ContractionSolution>
+library_set::findBestSolution(Tensile::ContractionProblem const& problem,
+                              Tensile::Hardware const& hardware,
+                              double* fitness) const
+{
+    if(const auto* part = owner(problem))
+        return part->findBestSolution(problem, hardware, fitness);
+    for(auto&& part : parts)
+    {
+        auto result = part->findBestSolution(problem, hardware, fitness);
+        if(result != nullptr)
+            return result;
+    }
+    return nullptr;
+}
+
+Tensile::SolutionSet<Tensile::ContractionSolution>
+library_set::findAllSolutions(Tensile::ContractionProblem const& problem,
+                              Tensile::Hardware const& hardware) const
+{
+    if(const auto* part = owner(problem))
+        return part->findAllSolutions(problem, hardware);
+    Tensile::SolutionSet<Tensile::ContractionSolution> result;
+    for(auto&& part : parts)
+    {
+        auto solutions = part->findAllSolutions(problem, hardware);
+        result.insert(solutions.begin(), solutions.end());
+    }
+    return result;
+}
+
+std::string library_set::type() const { return "MIOpenTensile library set"; }
+
+std::string library_set::description() const
+{
+    return type() + " of " + std::to_string(parts.size()) + " libraries";
+}
+
+std::shared_ptr<library_type> load_library(const std::vector<std::string>& parts,
+                                           std::size_t threads)
+{
+    std::vector<std::shared_ptr<library_type>> libraries(parts.size());
+    parallel_for(parts.size(), threads, [&](std::size_t i) {
+        libraries[i] =
+            Tensile::LoadLibraryFile<Tensile::ContractionProblem>(parts[i] + library_file_name());
+        if(libraries[i] == nullptr)
+            throw std::runtime_error("Failed to load tensile library: " + parts[i]);
+    });
+    if(libraries.size() == 1)
+        return libraries.front();
+    std::vector<std::string> groups;
+    for(auto&& part : parts)
+        groups.push_back(library_part_group(part));
+    return std::make_shared<library_set>(std::move(libraries), std::move(groups));
+}
+
+std::size_t load_threads()
+{
+    static const auto result = env_size("MIOPEN_TENSILE_LOAD_THREADS",
+                                        std::min(std::thread::hardware_concurrency(), 8u));
+    return std::max<std::size_t>(result, 1);
+}
+
+std::shared_ptr<library_type> create_library(const std::string& path)
+{
+    return load_library(library_parts(path), load_threads());
+    // return Tensile::EmbeddedLibrary<Tensile::ContractionProblem>::NewLibrary("miopen_tensile_kernels");
+}
+
+std::unique_ptr<logic_index> create_library_index(const std::string& path)
+{
+    auto file = path + "TensileLogic.idx";
+    if(access(file.c_str(), R_OK) != 0)
+        return nullptr;
+    return std::make_unique<logic_index>(file);
+}
+
+template <class T>
+struct shard_cache
+{
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<T>>> shards;
+};
+
+template <class T>
+shard_cache<T>& shards()
+{
+    static shard_cache<T> result;
+    return result;
+}
+
+// Whatever is loaded from a shard directory, kept for the life of the
+// process. The first caller loads it without holding the lock and the others
+// wait for it; a failed load is retried by the next call.
+template <class T, class F>
+const T* load_shard(const std::string& arch, F create)
+{
+    auto& cache = shards<T>();
+    auto path   = library_path(arch);
+    std::promise<std::shared_ptr<T>> loading;
+    std::shared_future<std::shared_ptr<T>> result;
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.shards.find(path);
+        if(it == cache.shards.end())
+        {
+            it    = cache.shards.emplace(path, loading.get_future().share()).first;
+            first = true;
+        }
+        result = it->second;
+    }
+    if(first)
+    {
+        try
+        {
+            loading.set_value(std::shared_ptr<T>(create(path)));
+        }
+        catch(...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(cache.mutex);
+                cache.shards.erase(path);
+            }
+            loading.set_exception(std::current_exception());
+        }
+    }
+    return result.get().get();
+}
+
+const library_type& library(const std::string& arch)
+{
+    auto result = load_shard<library_type>(arch, [](auto&& path) { return create_library(path); });
+    assert(result != nullptr);
+    return *result;
+}
+
+const library_type& library() { return library(hardware_arch(*hardware().current())); }
+
+const logic_index* library_index(const std::string& arch)
+{
+    return load_shard<logic_index>(arch,
+                                   [](auto&& path) { return create_library_index(path); });
+}
+
+const logic_index* library_index() { return library_index(hardware_arch(*hardware().current())); }
+
+struct background_loads
+{
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<std::future<void>>> loads;
+};
+
+void initialize_library(const std::string& arch)
+{
+    // What the loads use is created first, so that at exit the loads are
+    // waited for before it is destroyed
+    library_path(arch);
+    shards<library_type>();
+    shards<logic_index>();
+    auto& objects = code_objects(arch);
+    static background_loads background;
+
+    // Errors are reported again by the call that needs what failed to load
+    auto load = [](auto f) {
+        return std::async(std::launch::async, [=] {
+            try
+            {
+                f();
+            }
+            catch(...)
+            {
+            }
+        });
+    };
+    std::lock_guard<std::mutex> lock(background.mutex);
+    auto& loads = background.loads[arch];
+    if(not loads.empty())
+        return;
+    loads.push_back(load([=] { library(arch); }));
+    loads.push_back(load([=] { library_index(arch); }));
+    loads.push_back(load([&objects] { objects.build_index(); }));
+}
+
+auto create_adaptor() {
+    // Workaround: The Tensile::hip::SolutionAdapter is not a regular type, so heap allocate it instead
+    // Code objects are loaded on demand through code_objects()
+    return std::make_shared<Tensile::hip::SolutionAdapter>();
+}
+
+// The adapter guards its modules and kernels itself, so every thread shares
+// the one instance and each code object is loaded once per process
+Tensile::hip::SolutionAdapter& adaptor()
+{
+    static auto result = create_adaptor();
+    return *result;
+}
+
+struct hip_launcher : kernel_launcher
+{
+    void load_code_object(const std::string& path) override
+    {
+        if(adaptor().loadCodeObjectFile(path) != hipSuccess)
+            throw std::runtime_error("Failed to load code object: " + path);
+    }
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>& kernels,
+                      hipStream_t stream) override
+    {
+        return adaptor().launchKernels(kernels, stream, nullptr, nullptr);
+    }
+};
+
+std::shared_ptr<kernel_launcher> hip_kernel_launcher() { return std::make_shared<hip_launcher>(); }
+
+// Launchers that were installed are kept until exit, so a launch that
+// raced with set_kernel_launcher still has a live launcher to finish on
+struct launcher_storage
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<kernel_launcher>> installed;
+    std::atomic<kernel_launcher*> active{nullptr};
+
+    launcher_storage() { set(hip_kernel_launcher()); }
+
+    void set(std::shared_ptr<kernel_launcher> l)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        installed.push_back(std::move(l));
+        active.store(installed.back().get(), std::memory_order_release);
+    }
+};
+
+launcher_storage& launchers()
+{
+    static launcher_storage result;
+    return result;
+}
+
+kernel_launcher& launcher() { return *launchers().active.load(std::memory_order_acquire); }
+
+void set_kernel_launcher(std::shared_ptr<kernel_launcher> l) { launchers().set(std::move(l)); }
+
+} // namespace miopentensile
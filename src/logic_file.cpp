@@ -0,0 +1,274 @@
+#include <miopentensile/logic_file.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace miopentensile {
+
+std::string trim(const std::string& s)
+{
+    auto first = s.find_first_not_of(" \t\r");
+    if(first == std::string::npos)
+        return "";
+    auto last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last - first + 1);
+}
+
+// Elements of a flow sequence such as [64, 64, 1, 256]
+std::vector<std::string> parse_flow_list(const std::string& s)
+{
+    auto x = trim(s);
+    if(x.size() < 2 or x.front() != '[' or x.back() != ']')
+        throw std::runtime_error("Expected a list: " + s);
+    std::vector<std::string> result;
+    std::size_t start = 1;
+    while(start < x.size() - 1)
+    {
+        auto end = x.find(',', start);
+        if(end == std::string::npos)
+            end = x.size() - 1;
+        auto item = trim(x.substr(start, end - start));
+        if(not item.empty())
+            result.push_back(item);
+        start = end + 1;
+    }
+    return result;
+}
+
+std::pair<std::string, std::string> parse_key_value(const std::string& s)
+{
+    auto i = s.find(':');
+    if(i == std::string::npos)
+        return {trim(s), ""};
+    return {trim(s.substr(0, i)), trim(s.substr(i + 1))};
+}
+
+// Values may be written once with an anchor (&id001 [8, 8, 1]) and then
+// referred to by alias (*id001)
+std::string resolve_anchor(const std::string& value, std::map<std::string, std::string>& anchors)
+{
+    if(value.empty() or (value[0] != '&' and value[0] != '*'))
+        return value;
+    auto i    = value.find(' ');
+    auto name = value.substr(1, i == std::string::npos ? std::string::npos : i - 1);
+    if(value[0] == '*')
+        return anchors[name];
+    auto result   = i == std::string::npos ? "" : trim(value.substr(i + 1));
+    anchors[name] = result;
+    return result;
+}
+
+bool parse_bool(const std::string& s) { return s == "true" or s == "True"; }
+
+int parse_int(const std::string& s) { return std::atoi(s.c_str()); }
+
+void set_solution_value(logic_solution& s, const std::string& key, const std::string& value)
+{
+    if(key == "SolutionNameMin")
+        s.name = value;
+    else if(key == "SolutionIndex")
+        s.index = parse_int(value);
+    else if(key == "MacroTile0")
+        s.macro_tile0 = parse_int(value);
+    else if(key == "MacroTile1")
+        s.macro_tile1 = parse_int(value);
+    else if(key == "DepthU")
+        s.depth_u = parse_int(value);
+    else if(key == "GlobalSplitU")
+        s.global_split_u = parse_int(value);
+    else if(key == "GlobalSplitUAlgorithm")
+        s.multiple_buffer = value == "MultipleBuffer";
+    else if(key == "WorkGroupMapping")
+        s.workgroup_mapping = parse_int(value);
+    else if(key == "VectorWidth")
+        s.vector_width = parse_int(value);
+    else if(key == "GlobalReadVectorWidth")
+        s.global_read_vector_width = parse_int(value);
+    else if(key == "NumThreads")
+        s.num_threads = parse_int(value);
+    else if(key == "LdsNumElements")
+        s.lds_num_elements = parse_int(value);
+    else if(key == "_WorkspaceSizePerElemC")
+        s.workspace_per_elem_c = parse_int(value);
+    else if(key == "WorkGroup")
+    {
+        auto wg = parse_flow_list(value);
+        for(std::size_t i = 0; i < wg.size() and i < s.workgroup.size(); i++)
+            s.workgroup[i] = parse_int(wg[i]);
+    }
+}
+
+void set_problem_value(logic_file& f, const std::string& key, const std::string& value)
+{
+    if(key == "TransposeA")
+        f.transpose_a = parse_bool(value);
+    else if(key == "TransposeB")
+        f.transpose_b = parse_bool(value);
+    else if(key == "HighPrecisionAccumulate")
+        f.high_precision_accumulate = parse_bool(value);
+    else if(key == "StridedBatched")
+        f.strided_batched = parse_bool(value);
+    else if(key == "DataType")
+        f.data_type = parse_int(value);
+    else if(key == "DestDataType")
+        f.dest_data_type = parse_int(value);
+    else if(key == "ComputeDataType")
+        f.compute_data_type = parse_int(value);
+}
+
+logic_entry parse_entry_size(const std::string& s)
+{
+    auto size = parse_flow_list(s);
+    if(size.size() != 4 and size.size() != 8)
+        throw std::runtime_error("Unexpected exact size: " + s);
+    std::vector<std::uint64_t> x;
+    for(auto&& v : size)
+        x.push_back(std::strtoull(v.c_str(), nullptr, 10));
+    x.resize(8, 0);
+    logic_entry result;
+    result.m     = x[0];
+    result.n     = x[1];
+    result.batch = x[2];
+    result.k     = x[3];
+    result.ldd   = x[4];
+    result.ldc   = x[5];
+    result.lda   = x[6];
+    result.ldb   = x[7];
+    return result;
+}
+
+void parse_entry_value(logic_entry& e, const std::string& s)
+{
+    auto value = parse_flow_list(s);
+    if(value.size() != 2)
+        throw std::runtime_error("Unexpected exact value: " + s);
+    e.solution = parse_int(value[0]);
+    e.gflops   = std::strtod(value[1].c_str(), nullptr);
+}
+
+bool starts_with(const std::string& s, const std::string& prefix)
+{
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string operation_from_path(const std::string& path, const std::string& schedule)
+{
+    auto name = path.substr(path.rfind('/') + 1);
+    auto ext  = name.rfind(".yaml");
+    if(ext != std::string::npos)
+        name = name.substr(0, ext);
+    if(starts_with(name, schedule + "_"))
+        name = name.substr(schedule.size() + 1);
+    return name;
+}
+
+// Top level items of a logic file
+enum logic_item
+{
+    item_version,
+    item_schedule,
+    item_arch,
+    item_devices,
+    item_problem_type,
+    item_solutions,
+    item_index_order,
+    item_exact,
+};
+
+logic_file parse_logic_file(const std::string& path)
+{
+    std::ifstream is(path);
+    if(not is)
+        throw std::runtime_error("Failed to open logic file: " + path);
+    logic_file result;
+    result.path = path;
+    int item    = -1;
+    std::string line;
+    // The device list may be wrapped over several lines
+    std::string devices;
+    std::map<std::string, std::string> anchors;
+    while(std::getline(is, line))
+    {
+        if(line.empty() or line[0] == '#')
+            continue;
+        std::string rest;
+        // A new top level item
+        if(starts_with(line, "- "))
+        {
+            item++;
+            rest = line.substr(2);
+        }
+        switch(item)
+        {
+        case item_schedule: result.schedule = trim(rest); break;
+        case item_arch: result.arch = trim(rest); break;
+        case item_devices:
+        {
+            devices += " " + trim(line.substr(rest.empty() ? 0 : 2));
+            if(trim(devices).back() == ']')
+                result.devices = parse_flow_list(devices);
+            break;
+        }
+        case item_problem_type:
+        {
+            // Only the keys of the problem type itself, not of nested maps
+            if(rest.empty() and starts_with(line, "  ") and line[2] != ' ')
+                rest = line.substr(2);
+            if(not rest.empty())
+            {
+                auto kv = parse_key_value(rest);
+                set_problem_value(result, kv.first, kv.second);
+            }
+            break;
+        }
+        case item_solutions:
+        {
+            std::string kv_line;
+            if(starts_with(rest, "- "))
+            {
+                result.solutions.emplace_back();
+                kv_line = rest.substr(2);
+            }
+            else if(starts_with(line, "  - "))
+            {
+                result.solutions.emplace_back();
+                kv_line = line.substr(4);
+            }
+            else if(starts_with(line, "    ") and line[4] != ' ')
+            {
+                kv_line = line.substr(4);
+            }
+            if(not kv_line.empty() and not result.solutions.empty())
+            {
+                auto kv = parse_key_value(kv_line);
+                set_solution_value(
+                    result.solutions.back(), kv.first, resolve_anchor(kv.second, anchors));
+            }
+            break;
+        }
+        case item_exact:
+        {
+            if(starts_with(rest, "- - "))
+                result.exact.push_back(parse_entry_size(rest.substr(4)));
+            else if(starts_with(line, "  - - "))
+                result.exact.push_back(parse_entry_size(line.substr(6)));
+            else if(starts_with(line, "    - ") and not result.exact.empty())
+                parse_entry_value(result.exact.back(), line.substr(6));
+            break;
+        }
+        default:
+        {
+            if(item > item_exact and trim(rest) == "CUEfficiency")
+                result.cu_efficiency = true;
+            break;
+        }
+        }
+    }
+    if(item < item_exact)
+        throw std::runtime_error("Incomplete logic file: " + path);
+    result.operation = operation_from_path(path, result.schedule);
+    return result;
+}
+
+} // namespace miopentensile
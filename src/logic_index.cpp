@@ -0,0 +1,346 @@
+#include <miopentensile/logic_index.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace miopentensile {
+
+namespace fmt = logic_index_format;
+
+std::uint64_t fnv1a(const void* data, std::size_t n, std::uint64_t hash)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for(std::size_t i = 0; i < n; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+struct string_table
+{
+    std::string data = std::string(1, '\0');
+    std::unordered_map<std::string, std::uint32_t> offsets;
+
+    std::uint32_t add(const std::string& s)
+    {
+        if(s.empty())
+            return 0;
+        auto it = offsets.find(s);
+        if(it != offsets.end())
+            return it->second;
+        auto offset = std::uint32_t(data.size());
+        data += s;
+        data.push_back('\0');
+        offsets.emplace(s, offset);
+        return offset;
+    }
+};
+
+template <class T>
+void append_bytes(std::string& out, const std::vector<T>& x)
+{
+    out.append(reinterpret_cast<const char*>(x.data()), x.size() * sizeof(T));
+}
+
+std::uint64_t align_to(std::uint64_t x, std::uint64_t alignment)
+{
+    return (x + alignment - 1) / alignment * alignment;
+}
+
+void write_index_file(const std::string& path, fmt::header h, const std::string& body)
+{
+    h.content_hash = fnv1a(body.data(), body.size());
+
+    // Write next to the destination and rename so readers never map a
+    // partially written file
+    auto tmp = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream os(tmp, std::ios::binary);
+        os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        os.write(body.data(), body.size());
+        if(not os)
+            throw std::runtime_error("Failed to write logic index: " + tmp);
+    }
+    if(std::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Failed to write logic index: " + path);
+    }
+}
+
+void write_logic_index(const std::vector<logic_file>& files, const std::string& path)
+{
+    string_table strings;
+    std::vector<fmt::type_record> types;
+    std::vector<fmt::solution_record> solutions;
+    std::vector<fmt::entry_record> entries;
+    // Types are sorted so that find_type can search them
+    std::vector<std::size_t> order(files.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](auto x, auto y) {
+        return std::tie(files[x].arch, files[x].operation, files[x].cu_efficiency) <
+               std::tie(files[y].arch, files[y].operation, files[y].cu_efficiency);
+    });
+    for(auto i : order)
+    {
+        const auto& f = files[i];
+        fmt::type_record t{};
+        t.path      = strings.add(f.path.substr(f.path.rfind('/') + 1));
+        t.schedule  = strings.add(f.schedule);
+        t.arch      = strings.add(f.arch);
+        t.operation = strings.add(f.operation);
+        std::string devices;
+        for(auto&& d : f.devices)
+            devices += (devices.empty() ? "" : ";") + d;
+        t.devices                   = strings.add(devices);
+        t.data_type                 = f.data_type;
+        t.dest_data_type            = f.dest_data_type;
+        t.compute_data_type         = f.compute_data_type;
+        t.transpose_a               = f.transpose_a;
+        t.transpose_b               = f.transpose_b;
+        t.high_precision_accumulate = f.high_precision_accumulate;
+        t.strided_batched           = f.strided_batched;
+        t.cu_efficiency             = f.cu_efficiency;
+        t.first_solution            = solutions.size();
+        t.solution_count            = f.solutions.size();
+        t.first_entry               = entries.size();
+
+        for(auto&& s : f.solutions)
+        {
+            fmt::solution_record r{};
+            r.name                     = strings.add(s.name);
+            r.index                    = s.index;
+            r.macro_tile0              = s.macro_tile0;
+            r.macro_tile1              = s.macro_tile1;
+            r.depth_u                  = s.depth_u;
+            r.global_split_u           = s.global_split_u;
+            r.workgroup_mapping        = s.workgroup_mapping;
+            r.vector_width             = s.vector_width;
+            r.global_read_vector_width = s.global_read_vector_width;
+            r.num_threads              = s.num_threads;
+            r.lds_num_elements         = s.lds_num_elements;
+            r.workspace_per_elem_c     = s.workspace_per_elem_c;
+            std::copy(s.workgroup.begin(), s.workgroup.end(), r.workgroup);
+            r.multiple_buffer = s.multiple_buffer;
+            solutions.push_back(r);
+        }
+
+        std::vector<fmt::entry_record> type_entries;
+        for(auto&& e : f.exact)
+        {
+            if(e.solution < 0 or std::size_t(e.solution) >= f.solutions.size())
+                throw std::runtime_error("Invalid solution " + std::to_string(e.solution) +
+                                         " in " + f.path);
+            fmt::entry_record r{};
+            r.m        = e.m;
+            r.n        = e.n;
+            r.batch    = e.batch;
+            r.k        = e.k;
+            r.ldd      = e.ldd;
+            r.ldc      = e.ldc;
+            r.lda      = e.lda;
+            r.ldb      = e.ldb;
+            r.solution = t.first_solution + e.solution;
+            r.type     = types.size();
+            r.gflops   = e.gflops;
+            type_entries.push_back(r);
+        }
+        std::stable_sort(type_entries.begin(), type_entries.end(), [](auto&& x, auto&& y) {
+            return std::make_tuple(x.m, x.n, x.batch, x.k, -x.gflops) <
+                   std::make_tuple(y.m, y.n, y.batch, y.k, -y.gflops);
+        });
+        entries.insert(entries.end(), type_entries.begin(), type_entries.end());
+        t.entry_count = type_entries.size();
+        types.push_back(t);
+    }
+
+    fmt::header h{};
+    h.magic           = fmt::magic;
+    h.version         = fmt::version;
+    h.string_offset   = sizeof(fmt::header);
+    h.string_size     = strings.data.size();
+    h.type_offset     = align_to(h.string_offset + h.string_size, 8);
+    h.type_count      = types.size();
+    h.solution_offset = h.type_offset + types.size() * sizeof(fmt::type_record);
+    h.solution_count  = solutions.size();
+    h.entry_offset    = h.solution_offset + solutions.size() * sizeof(fmt::solution_record);
+    h.entry_count     = entries.size();
+    h.file_size       = h.entry_offset + entries.size() * sizeof(fmt::entry_record);
+
+    std::string body = strings.data;
+    body.resize(h.type_offset - h.string_offset, '\0');
+    append_bytes(body, types);
+    append_bytes(body, solutions);
+    append_bytes(body, entries);
+    write_index_file(path, h, body);
+}
+
+void write_logic_costs(const std::string& path, const std::vector<fmt::cost_record>& costs)
+{
+    std::string body;
+    fmt::header h{};
+    {
+        std::ifstream is(path, std::ios::binary);
+        if(not is.read(reinterpret_cast<char*>(&h), sizeof(h)))
+            throw std::runtime_error("Failed to read logic index: " + path);
+        body.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    if(h.magic != fmt::magic or h.version != fmt::version or
+       h.file_size != sizeof(h) + body.size() or h.type_count != costs.size() or
+       h.type_offset < sizeof(h) or
+       h.type_offset + h.type_count * sizeof(fmt::type_record) > h.file_size)
+        throw std::runtime_error("Invalid logic index: " + path);
+    for(std::size_t i = 0; i < costs.size(); i++)
+    {
+        auto offset = h.type_offset - sizeof(h) + i * sizeof(fmt::type_record) +
+                      offsetof(fmt::type_record, cost);
+        std::memcpy(&body[offset], &costs[i], sizeof(fmt::cost_record));
+    }
+    write_index_file(path, h, body);
+}
+
+const std::size_t logic_index::npos;
+
+logic_index::logic_index(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        throw std::runtime_error("Failed to open logic index: " + path);
+    struct stat st;
+    if(fstat(fd, &st) != 0 or std::size_t(st.st_size) < sizeof(fmt::header))
+    {
+        close(fd);
+        throw std::runtime_error("Invalid logic index: " + path);
+    }
+    size   = st.st_size;
+    auto p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED)
+        throw std::runtime_error("Failed to map logic index: " + path);
+    data = static_cast<const unsigned char*>(p);
+
+    const auto& h = get_header();
+    auto fits     = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t record) {
+        return offset <= size and count <= (size - offset) / record;
+    };
+    if(h.magic != fmt::magic or h.version != fmt::version or h.file_size != size or
+       not fits(h.string_offset, h.string_size, 1) or
+       not fits(h.type_offset, h.type_count, sizeof(type_record)) or
+       not fits(h.solution_offset, h.solution_count, sizeof(solution_record)) or
+       not fits(h.entry_offset, h.entry_count, sizeof(entry_record)) or h.string_size == 0 or
+       data[h.string_offset + h.string_size - 1] != '\0')
+    {
+        munmap(const_cast<unsigned char*>(data), size);
+        throw std::runtime_error("Invalid logic index: " + path);
+    }
+    strings   = reinterpret_cast<const char*>(data + h.string_offset);
+    types     = reinterpret_cast<const type_record*>(data + h.type_offset);
+    solutions = reinterpret_cast<const solution_record*>(data + h.solution_offset);
+    entries   = reinterpret_cast<const entry_record*>(data + h.entry_offset);
+    trees     = std::make_unique<size_tree[]>(h.type_count);
+    for(std::size_t i = 0; i < h.type_count; i++)
+    {
+        const auto& t = types[i];
+        if(t.first_solution + std::uint64_t(t.solution_count) > h.solution_count or
+           t.first_entry + t.entry_count > h.entry_count)
+        {
+            munmap(const_cast<unsigned char*>(data), size);
+            throw std::runtime_error("Invalid logic index: " + path);
+        }
+    }
+}
+
+logic_index::~logic_index() { munmap(const_cast<unsigned char*>(data), size); }
+
+record_range<logic_index::solution_record> logic_index::solutions_of(const type_record& t) const
+{
+    return {solutions + t.first_solution, solutions + t.first_solution + t.solution_count};
+}
+
+record_range<logic_index::entry_record> logic_index::entries_of(const type_record& t) const
+{
+    return {entries + t.first_entry, entries + t.first_entry + t.entry_count};
+}
+
+std::size_t logic_index::find_type(const std::string& arch,
+                                   const std::string& operation,
+                                   bool cu_efficiency) const
+{
+    auto compare = [&](const type_record& t) {
+        if(auto x = std::strcmp(string(t.arch), arch.c_str()))
+            return x;
+        if(auto x = std::strcmp(string(t.operation), operation.c_str()))
+            return x;
+        return int(bool(t.cu_efficiency)) - int(cu_efficiency);
+    };
+    auto last = types + type_count();
+    auto it =
+        std::partition_point(types, last, [&](const type_record& t) { return compare(t) < 0; });
+    if(it == last or compare(*it) != 0)
+        return npos;
+    return it - types;
+}
+
+record_range<logic_index::entry_record> logic_index::find_exact(std::size_t type,
+                                                                std::uint64_t m,
+                                                                std::uint64_t n,
+                                                                std::uint64_t batch,
+                                                                std::uint64_t k) const
+{
+    if(type >= type_count())
+        return {};
+    auto all  = entries_of(types[type]);
+    auto size = std::make_tuple(m, n, batch, k);
+    auto key  = [](const entry_record& e) { return std::make_tuple(e.m, e.n, e.batch, e.k); };
+    auto first =
+        std::lower_bound(all.begin(), all.end(), size, [&](const entry_record& e, const auto& s) {
+            return key(e) < s;
+        });
+    auto last = std::upper_bound(first, all.end(), size, [&](const auto& s, const entry_record& e) {
+        return s < key(e);
+    });
+    return {first, last};
+}
+
+logic_index::nearest_entry logic_index::find_nearest(std::size_t type,
+                                                    std::uint64_t m,
+                                                    std::uint64_t n,
+                                                    std::uint64_t batch,
+                                                    std::uint64_t k) const
+{
+    if(type >= type_count())
+        return {};
+    auto& t = trees[type];
+    std::call_once(t.flag, [&] {
+        std::vector<nearest_size_tree::size_type> sizes;
+        for(auto&& e : entries_of(types[type]))
+        {
+            // Entries of a size are sorted best first, so keep the first
+            nearest_size_tree::size_type s = {{e.m, e.n, e.batch, e.k}};
+            if(not sizes.empty() and sizes.back() == s)
+                continue;
+            sizes.push_back(s);
+            t.entries.push_back(&e);
+        }
+        t.tree = nearest_size_tree{sizes};
+    });
+    auto r = t.tree.nearest({{m, n, batch, k}});
+    if(r.id == nearest_size_tree::npos)
+        return {};
+    return {t.entries[r.id], r.distance};
+}
+
+} // namespace miopentensile
@@ -0,0 +1,204 @@
+#include <miopentensile/logic_problem.hpp>
+#include <miopentensile/hardware.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace miopentensile {
+
+// Values of Tensile::DataType as written in the logic files
+enum logic_data_type
+{
+    logic_float    = 0,
+    logic_half     = 4,
+    logic_int8x4   = 5,
+    logic_int32    = 6,
+    logic_bfloat16 = 7,
+};
+
+bool logic_input_type(const logic_index::type_record& t, miopen_tensile_type& result)
+{
+    if(not t.strided_batched)
+        return false;
+    if(t.data_type == logic_float and t.dest_data_type == logic_float)
+        result = miopen_tensile_type_float;
+    else if(t.data_type == logic_half and t.dest_data_type == logic_half and
+            t.high_precision_accumulate)
+        result = miopen_tensile_type_half;
+    else if(t.data_type == logic_bfloat16 and t.dest_data_type == logic_bfloat16 and
+            t.high_precision_accumulate)
+        result = miopen_tensile_type_bfloat16;
+    else if(t.data_type == logic_int8x4 and t.dest_data_type == logic_int32)
+        result = miopen_tensile_type_int8x4;
+    else
+        return false;
+    return true;
+}
+
+miopen_tensile_matrix logic_matrix(std::size_t rows,
+                                   std::size_t cols,
+                                   bool transposed,
+                                   std::size_t ld,
+                                   std::size_t batch,
+                                   miopen_tensile_type type)
+{
+    miopen_tensile_matrix result{};
+    result.lens[0] = rows;
+    result.lens[1] = cols;
+    if(transposed)
+    {
+        result.strides[0] = 1;
+        result.strides[1] = ld == 0 ? rows : ld;
+    }
+    else
+    {
+        result.strides[0] = ld == 0 ? cols : ld;
+        result.strides[1] = 1;
+    }
+    if(batch > 1)
+        result.batch = miopen_tensile_batch{
+            batch, transposed ? result.strides[1] * cols : result.strides[0] * rows};
+    result.type = type;
+    return result;
+}
+
+tensile_operands logic_operands(const logic_index::type_record& t,
+                                const logic_index::entry_record& e)
+{
+    miopen_tensile_type type;
+    if(not logic_input_type(t, type))
+        throw std::runtime_error("Logic type is not supported by the gemm api");
+    auto k   = e.k;
+    auto lda = e.lda;
+    auto ldb = e.ldb;
+    // The tables count int8x4 elements along k while the api counts bytes
+    if(type == miopen_tensile_type_int8x4)
+    {
+        k *= 4;
+        lda *= t.transpose_a ? 4 : 1;
+        ldb *= t.transpose_b ? 1 : 4;
+    }
+    auto c_type = type == miopen_tensile_type_int8x4 ? miopen_tensile_type_int32 : type;
+    tensile_operands result;
+    result.a = logic_matrix(k, e.m, t.transpose_a, lda, e.batch, type);
+    result.b = logic_matrix(e.n, k, t.transpose_b, ldb, e.batch, type);
+    result.c = logic_matrix(e.n, e.m, false, e.ldc, e.batch, c_type);
+    return result;
+}
+
+std::string logic_operation(const problem_key& key)
+{
+    if(key.pointer_batched or key.type_a != key.type_b)
+        return "";
+    std::string suffix;
+    if(key.type_a == miopen_tensile_type_int8x4 and key.type_c == miopen_tensile_type_int32)
+        suffix = "4xi8BH";
+    else if(key.type_a != key.type_c)
+        return "";
+    else if(key.type_a == miopen_tensile_type_float)
+        suffix = "SB";
+    else if(key.type_a == miopen_tensile_type_half)
+        suffix = "HBH";
+    else if(key.type_a == miopen_tensile_type_bfloat16)
+        suffix = "BBH";
+    else
+        return "";
+    return std::string("Cijk_") + (key.transpose_a ? "Alik" : "Ailk") + "_" +
+           (key.transpose_b ? "Bjlk" : "Bljk") + "_" + suffix;
+}
+
+std::size_t find_logic_type(const logic_index& index, const std::string& arch, const problem_key& key)
+{
+    auto operation = logic_operation(key);
+    if(operation.empty())
+        return logic_index::npos;
+    return index.find_type(arch, operation);
+}
+
+nearest_size_tree::size_type logic_size(const problem_key& key)
+{
+    auto k = key.type_a == miopen_tensile_type_int8x4 ? key.k / 4 : key.k;
+    return {{key.m, key.n, key.batch, k}};
+}
+
+logic_index::nearest_entry
+find_nearest_entry(const logic_index& index, const std::string& arch, const problem_key& key)
+{
+    auto type = find_logic_type(index, arch, key);
+    if(type == logic_index::npos)
+        return {};
+    auto size = logic_size(key);
+    return index.find_nearest(type, size[0], size[1], size[2], size[3]);
+}
+
+std::unordered_map<std::string, logic_estimate>
+logic_solution_estimates(const logic_index& index, const std::string& arch, const problem_key& key)
+{
+    std::unordered_map<std::string, logic_estimate> result;
+    auto type = find_logic_type(index, arch, key);
+    if(type == logic_index::npos)
+        return result;
+    auto size = logic_size(key);
+    for(auto&& e : index.entries_of(index.type(type)))
+    {
+        std::string name = index.string(index.solution(e.solution).name);
+        if(name.empty())
+            continue;
+        auto d  = nearest_size_tree::distance({{e.m, e.n, e.batch, e.k}}, size);
+        auto it = result.find(name);
+        // Entries of a size are ordered best first, so ties keep the best
+        if(it == result.end())
+            result.emplace(name, logic_estimate{e.gflops, d});
+        else if(d < it->second.distance)
+            it->second = logic_estimate{e.gflops, d};
+    }
+    return result;
+}
+
+// Adds the named solutions of the type with their predicted cost
+void rank_type(const logic_index& index,
+               std::size_t type,
+               const problem_key& key,
+               const device_params& device,
+               std::vector<ranked_solution>& result)
+{
+    cost_params params;
+    if(type == logic_index::npos or not logic_cost_params(index, type, params))
+        return;
+    const auto& t = index.type(type);
+    auto size     = logic_size(key);
+    cost_problem x;
+    x.m            = size[0];
+    x.n            = size[1];
+    x.batch        = size[2];
+    x.k            = size[3];
+    x.input_bytes  = logic_type_size(t.data_type);
+    x.output_bytes = logic_type_size(t.dest_data_type);
+    for(auto&& s : index.solutions_of(t))
+    {
+        if(*index.string(s.name) == '\0')
+            continue;
+        result.push_back({&s, predict_cost(s, x, device, params)});
+    }
+}
+
+std::vector<ranked_solution> rank_logic_solutions(const logic_index& index,
+                                                  const std::string& arch,
+                                                  const problem_key& key,
+                                                  const Tensile::Hardware& hw)
+{
+    std::vector<ranked_solution> result;
+    auto device = default_device_params(arch);
+    if(hardware_cu_count(hw) > 0)
+        device.cu_count = hardware_cu_count(hw);
+    rank_type(index, find_logic_type(index, arch, key), key, device, result);
+    // On part of a device the logic tuned for efficiency per cu competes too
+    auto operation = logic_operation(key);
+    if(key.cu_count > 0 and not operation.empty())
+        rank_type(index, index.find_type(arch, operation, true), key, device, result);
+    std::stable_sort(result.begin(), result.end(), [](auto&& a, auto&& b) {
+        return a.estimate.seconds < b.estimate.seconds;
+    });
+    return result;
+}
+
+} // namespace miopentensile
@@ -0,0 +1,112 @@
+#include <miopentensile/nearest_size.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace miopentensile {
+
+const std::size_t nearest_size_tree::npos;
+
+nearest_size_tree::nearest_size_tree(const std::vector<size_type>& sizes)
+{
+    nodes.reserve(sizes.size());
+    for(std::size_t i = 0; i < sizes.size(); i++)
+        nodes.push_back({to_point(sizes[i]), i, 0});
+    build(0, nodes.size());
+}
+
+nearest_size_tree::point nearest_size_tree::to_point(const size_type& s)
+{
+    point result;
+    for(std::size_t i = 0; i < s.size(); i++)
+        result[i] = std::log2(double(std::max<std::uint64_t>(s[i], 1)));
+    return result;
+}
+
+double nearest_size_tree::distance(const size_type& x, const size_type& y)
+{
+    auto px       = to_point(x);
+    auto py       = to_point(y);
+    double result = 0;
+    for(std::size_t i = 0; i < px.size(); i++)
+        result += (px[i] - py[i]) * (px[i] - py[i]);
+    return result;
+}
+
+// The nodes of [first, last) form a subtree rooted at the middle element, with
+// the smaller half of the split axis before it
+void nearest_size_tree::build(std::size_t first, std::size_t last)
+{
+    if(last - first < 2)
+        return;
+    // Split along the dimension with the largest spread
+    std::size_t axis   = 0;
+    double best_spread = -1;
+    for(std::size_t d = 0; d < 4; d++)
+    {
+        auto mm = std::minmax_element(
+            nodes.begin() + first, nodes.begin() + last, [&](auto&& x, auto&& y) {
+                return x.p[d] < y.p[d];
+            });
+        auto spread = mm.second->p[d] - mm.first->p[d];
+        if(spread > best_spread)
+        {
+            best_spread = spread;
+            axis        = d;
+        }
+    }
+    auto mid = first + (last - first) / 2;
+    std::nth_element(nodes.begin() + first,
+                     nodes.begin() + mid,
+                     nodes.begin() + last,
+                     [&](auto&& x, auto&& y) { return x.p[axis] < y.p[axis]; });
+    nodes[mid].axis = axis;
+    build(first, mid);
+    build(mid + 1, last);
+}
+
+void nearest_size_tree::search(std::size_t first,
+                               std::size_t last,
+                               const point& q,
+                               result& best) const
+{
+    if(first >= last)
+        return;
+    auto mid      = first + (last - first) / 2;
+    const auto& n = nodes[mid];
+    double d      = 0;
+    for(std::size_t i = 0; i < 4; i++)
+        d += (q[i] - n.p[i]) * (q[i] - n.p[i]);
+    if(d < best.distance or (d == best.distance and n.id < best.id))
+    {
+        best.distance = d;
+        best.id       = n.id;
+    }
+    if(last - first == 1)
+        return;
+    auto diff = q[n.axis] - n.p[n.axis];
+    if(diff < 0)
+    {
+        search(first, mid, q, best);
+        if(diff * diff <= best.distance)
+            search(mid + 1, last, q, best);
+    }
+    else
+    {
+        search(mid + 1, last, q, best);
+        if(diff * diff <= best.distance)
+            search(first, mid, q, best);
+    }
+}
+
+nearest_size_tree::result nearest_size_tree::nearest(const size_type& s) const
+{
+    result best;
+    best.distance = std::numeric_limits<double>::infinity();
+    search(0, nodes.size(), to_point(s), best);
+    if(best.id == npos)
+        best.distance = 0;
+    return best;
+}
+
+} // namespace miopentensile
@@ -0,0 +1,191 @@
+#include <miopentensile/problem.hpp>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace miopentensile {
+
+bool is_transposed(const miopen_tensile_matrix& a)
+{
+    return a.strides[1] > a.strides[0];
+}
+
+size_t get_idx(const miopen_tensile_matrix& a, size_t n)
+{
+    return (n + (is_transposed(a) ? 1 : 0)) % 2;
+}
+
+size_t get_ld(const miopen_tensile_matrix& a)
+{
+    return a.strides[get_idx(a, 0)];
+}
+
+Tensile::DataType get_data_type(const miopen_tensile_matrix& a)
+{
+    switch(a.type)
+    {
+    case miopen_tensile_type_float: return Tensile::DataType::Float;
+    case miopen_tensile_type_half: return Tensile::DataType::Half;
+    case miopen_tensile_type_int8x4: return Tensile::DataType::Int8x4;
+    case miopen_tensile_type_int32: return Tensile::DataType::Int32;
+    case miopen_tensile_type_bfloat16: return Tensile::DataType::BFloat16;
+    }
+}
+
+miopen_tensile_matrix transpose(const miopen_tensile_matrix& a)
+{
+    auto result = a;
+    std::swap(result.lens[0], result.lens[1]);
+    std::swap(result.strides[0], result.strides[1]);
+    return result;
+}
+
+// The stride of a dimension of length one is never used, so it is chosen to
+// make the matrix row major where the stride of the other dimension allows.
+// Int8x4 operands keep theirs, as their layout says which way k is packed.
+miopen_tensile_matrix normalize_strides(miopen_tensile_matrix m)
+{
+    if(m.type == miopen_tensile_type_int8x4)
+        return m;
+    if(m.lens[1] == 1)
+        m.strides[1] = 1;
+    if(m.lens[0] == 1)
+        m.strides[0] = m.strides[1] == 1 ? m.lens[1] : 1;
+    return m;
+}
+
+canonical_gemm canonicalize(const miopen_tensile_matrix& a,
+                            const miopen_tensile_matrix& b,
+                            const miopen_tensile_matrix& c)
+{
+    canonical_gemm result{a, b, c};
+    // c = a * b stored by columns is c' = b' * a' stored by rows
+    if(is_transposed(normalize_strides(c)))
+    {
+        result.a       = transpose(b);
+        result.b       = transpose(a);
+        result.c       = transpose(c);
+        result.swapped = true;
+    }
+    for(auto* m : {&result.a, &result.b, &result.c})
+        *m = normalize_strides(*m);
+    auto& x    = result.b;
+    auto batch = std::max({result.a.batch.num, x.batch.num, result.c.batch.num, std::size_t{1}});
+    // The rows of the batch items follow each other in the a of the gemm api
+    // and in c, and every item multiplies them with the same b
+    auto rows = x.lens[0];
+    if(batch > 1 and result.a.batch.stride == 0 and not is_transposed(x) and
+       x.batch.num == batch and x.batch.stride == rows * x.strides[0] and
+       result.c.batch.num == batch and result.c.batch.stride == rows * result.c.strides[0])
+    {
+        x.lens[0] *= batch;
+        result.c.lens[0] *= batch;
+        batch = 1;
+    }
+    if(batch == 1)
+    {
+        for(auto* m : {&result.a, &result.b, &result.c})
+            m->batch = miopen_tensile_batch{0, 0};
+    }
+    return result;
+}
+
+problem_key create_problem_key(const miopen_tensile_matrix& a, const miopen_tensile_matrix& b, const miopen_tensile_matrix& c, double beta, int device)
+{
+    problem_key key;
+    key.transpose_a = is_transposed(a);
+    key.transpose_b = is_transposed(b);
+    key.m = a.lens[1];
+    key.n = b.lens[0];
+    key.k = a.lens[0];
+    key.batch = std::max({a.batch.num, b.batch.num, c.batch.num, std::size_t{1}});
+    key.lda = get_ld(a);
+    key.ldb = get_ld(b);
+    key.ldc = get_ld(c);
+    key.stride_a = a.batch.stride;
+    key.stride_b = b.batch.stride;
+    key.stride_c = c.batch.stride;
+    key.type_a = a.type;
+    key.type_b = b.type;
+    key.type_c = c.type;
+    key.high_precision_accumulate = a.type == miopen_tensile_type_half || a.type == miopen_tensile_type_bfloat16 || a.type == miopen_tensile_type_int8x4;
+    key.beta = get_beta_class(beta);
+    key.device = device;
+    return key;
+}
+
+Tensile::ContractionProblem create_tensile_problem(const miopen_tensile_matrix& a, const miopen_tensile_matrix& b, const miopen_tensile_matrix& c, double beta)
+{
+    if (a.lens[0] != b.lens[1])
+      throw std::runtime_error("K dimensions do not match");
+    if (a.lens[1] != c.lens[1])
+      throw std::runtime_error("M dimensions do not match");
+    if (b.lens[0] != c.lens[0])
+      throw std::runtime_error("N dimensions do not match");
+
+    if (a.batch.num > 1 or b.batch.num > 1 or c.batch.num > 1 or a.type != miopen_tensile_type_float or b.type != miopen_tensile_type_float or c.type != miopen_tensile_type_float)
+    {
+        auto batch = std::max({a.batch.num, b.batch.num, c.batch.num, std::size_t{1}});
+        auto k = a.lens[0];
+        auto lda = get_ld(a);
+        auto ldb = get_ld(b);
+        auto stride_a = a.batch.stride;
+        auto stride_b = b.batch.stride;
+        if(a.type == miopen_tensile_type_int8x4)
+        {
+            if(k % 4 != 0 || (is_transposed(a) && (lda % 4 != 0))|| (!is_transposed(b) && (ldb % 4 != 0))|| (c.batch.num > 1 && (a.batch.stride % 4 != 0 || b.batch.stride % 4 != 0)))
+            {
+                std::cerr << "Invalid int8 problem size." << std::endl;
+                return Tensile::ContractionProblem{};
+            }
+            else
+            {
+                k /= 4;
+                lda = !is_transposed(a) ? lda : lda / 4;
+                ldb = !is_transposed(b) ? ldb / 4 : ldb;
+                stride_a /= 4;
+                stride_b /= 4;
+            }
+        }
+        auto problem = Tensile::ContractionProblem::GEMM_Strides(is_transposed(a), 
+                                                                 is_transposed(b), 
+                                                                 get_data_type(a), 
+                                                                 get_data_type(b), 
+                                                                 get_data_type(c), 
+                                                                 get_data_type(c), 
+                                                                 a.lens[1],
+                                                                 b.lens[0],
+                                                                 k,
+                                                                 batch,
+                                                                 lda,
+                                                                 stride_a,
+                                                                 ldb,
+                                                                 stride_b,
+                                                                 get_ld(c),
+                                                                 c.batch.stride,
+                                                                 get_ld(c),
+                                                                 c.batch.stride,
+                                                                 beta);
+
+        if (a.type == miopen_tensile_type_half || a.type == miopen_tensile_type_bfloat16 || a.type == miopen_tensile_type_int8x4)
+            problem.setHighPrecisionAccumulate(true);
+
+        return problem;
+    }
+    else
+    {
+        return Tensile::ContractionProblem::GEMM(is_transposed(a),
+                                                 is_transposed(b), 
+                                                 a.lens[1],
+                                                 b.lens[0],
+                                                 a.lens[0],
+                                                 get_ld(a), 
+                                                 get_ld(b), 
+                                                 get_ld(c), 
+                                                 beta, 
+                                                 false, 
+                                                 1);
+    }
+}
+
+} // namespace miopentensile
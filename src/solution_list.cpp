@@ -0,0 +1,70 @@
+#include <miopentensile/solution_list.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/logic_problem.hpp>
+#include <miopentensile/problem.hpp>
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+namespace miopentensile {
+
+std::uint64_t solution_id(const Tensile::ContractionSolution& s)
+{
+    return fnv1a(s.kernelName.data(), s.kernelName.size());
+}
+
+std::vector<solution_info> find_solutions(const miopen_tensile_matrix& a,
+                                          const miopen_tensile_matrix& b,
+                                          const miopen_tensile_matrix& c,
+                                          double beta,
+                                          int device)
+{
+    // Solutions of the normal form, which plans look solution ids up in
+    auto g       = canonicalize(a, b, c);
+    auto key     = create_problem_key(g.a, g.b, g.c, beta, device);
+    auto problem = create_tensile_problem(g.a, g.b, g.c, beta);
+    problem.setWorkspaceSize(std::numeric_limits<std::size_t>::max());
+    const auto& hw = *hardware().get(device);
+    auto arch      = hardware_arch(hw);
+
+    std::unordered_map<std::string, logic_estimate> estimates;
+    if(const auto* index = library_index(arch))
+        estimates = logic_solution_estimates(*index, arch, key);
+
+    std::vector<solution_info> result;
+    for(auto&& s : library(arch).findAllSolutions(problem, hw))
+    {
+        solution_info x;
+        x.id             = solution_id(*s);
+        x.solution       = s;
+        x.size_distance  = std::numeric_limits<double>::infinity();
+        x.workspace_size = s->requiredWorkspaceSize(problem);
+        auto it          = estimates.find(s->kernelName);
+        if(it != estimates.end())
+        {
+            x.predicted_gflops = it->second.gflops;
+            x.size_distance    = it->second.distance;
+        }
+        result.push_back(x);
+    }
+    std::sort(result.begin(), result.end(), [](auto&& x, auto&& y) {
+        return std::make_tuple(x.size_distance, -x.predicted_gflops, x.id) <
+               std::make_tuple(y.size_distance, -y.predicted_gflops, y.id);
+    });
+    return result;
+}
+
+solution_ptr find_solution(const library_type& lib,
+                           const Tensile::ContractionProblem& problem,
+                           const Tensile::Hardware& hw,
+                           std::uint64_t id)
+{
+    for(auto&& s : lib.findAllSolutions(problem, hw))
+    {
+        if(solution_id(*s) == id)
+            return s;
+    }
+    return nullptr;
+}
+
+} // namespace miopentensile
@@ -0,0 +1,464 @@
+#include <miopentensile/trace.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/solution_list.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace miopentensile {
+
+std::atomic<bool> trace_enabled{false};
+
+std::int64_t trace_clock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Records of one thread. Only the owning thread appends, so appending takes
+// no lock; draining is serialized by the flush mutex. A full ring swaps its
+// records with the spare buffer and hands them to the writer thread, which
+// gives the buffer back once they are written.
+struct trace_ring
+{
+    trace_ring(std::size_t n, std::uint32_t id) : records(n), spare(n), thread(id) {}
+
+    std::vector<trace_record> records;
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<std::uint64_t> tail{0};
+    std::mutex flush_mutex;
+    std::vector<trace_record> spare;
+    // The writer holds the spare buffer
+    bool writing = false;
+    std::condition_variable written;
+    std::uint32_t thread;
+};
+
+// Records head - first to head - 1 of a full ring, in the order they were
+// added
+struct trace_batch
+{
+    std::shared_ptr<trace_ring> ring;
+    std::vector<trace_record> records;
+    std::uint64_t first;
+    std::uint64_t last;
+};
+
+struct trace_output
+{
+    std::mutex mutex;
+    std::FILE* file         = nullptr;
+    trace_format format     = trace_jsonl;
+    std::size_t buffer_size = 1024;
+    std::int64_t epoch      = 0;
+    // No chrome event was written yet, so the next one takes no separator
+    bool first_event          = true;
+    std::uint32_t next_thread = 0;
+    std::vector<std::shared_ptr<trace_ring>> rings;
+
+    // Full rings waiting for the writer thread
+    std::mutex batch_mutex;
+    std::condition_variable batch_added;
+    std::deque<trace_batch> batches;
+    bool stopping = false;
+    std::thread writer;
+};
+
+trace_output& output()
+{
+    static trace_output result;
+    return result;
+}
+
+void release_ring(const std::shared_ptr<trace_ring>& ring);
+
+// Flushes the records of a thread when it exits
+struct ring_holder
+{
+    std::shared_ptr<trace_ring> ring;
+    ~ring_holder()
+    {
+        if(ring != nullptr)
+            release_ring(ring);
+    }
+};
+
+thread_local ring_holder local_ring;
+thread_local trace_record staging;
+thread_local trace_record* active = nullptr;
+
+trace_record* current_trace() { return active; }
+
+const char* type_name(miopen_tensile_type t)
+{
+    switch(t)
+    {
+    case miopen_tensile_type_float: return "float";
+    case miopen_tensile_type_half: return "half";
+    case miopen_tensile_type_bfloat16: return "bfloat16";
+    case miopen_tensile_type_int8x4: return "int8x4";
+    case miopen_tensile_type_int32: return "int32";
+    }
+    return "unknown";
+}
+
+const char* beta_name(beta_class b)
+{
+    switch(b)
+    {
+    case beta_other: return "other";
+    case beta_zero: return "zero";
+    case beta_one: return "one";
+    }
+    return "unknown";
+}
+
+const char* source_name(gemm_plan::source_type s)
+{
+    switch(s)
+    {
+    case gemm_plan::from_library: return "library";
+    case gemm_plan::from_exact_size: return "exact_size";
+    case gemm_plan::from_nearest_size: return "nearest_size";
+    case gemm_plan::from_tuning_db: return "tuning_db";
+    case gemm_plan::from_solution_id: return "solution_id";
+    }
+    return "unknown";
+}
+
+void write_string(std::ostream& os, const std::string& s)
+{
+    os << '"';
+    for(char c : s)
+    {
+        if(c == '"' or c == '\\')
+            os << '\\' << c;
+        else if(static_cast<unsigned char>(c) < 0x20)
+            os << ' ';
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+double to_us(std::int64_t ns) { return ns / 1000.0; }
+
+void write_fields(std::ostream& os, const trace_record& r)
+{
+    os << "\"cache\":\"" << (r.cache_hit ? "hit" : "miss") << "\"";
+    os << ",\"status\":" << int(r.status);
+    os << ",\"select_us\":" << to_us(r.select);
+    if(r.has_scalars)
+        os << ",\"alpha\":" << r.alpha << ",\"beta_value\":" << r.beta;
+    if(r.plan == nullptr)
+        return;
+    const auto& p = *r.plan;
+    const auto& k = p.key;
+    os << ",\"construct_us\":" << to_us(r.planned - r.start - r.select);
+    os << ",\"launch_us\":" << to_us(r.end - r.planned);
+    os << ",\"m\":" << k.m << ",\"n\":" << k.n << ",\"k\":" << k.k << ",\"batch\":" << k.batch;
+    os << ",\"transpose_a\":" << k.transpose_a << ",\"transpose_b\":" << k.transpose_b;
+    os << ",\"lda\":" << k.lda << ",\"ldb\":" << k.ldb << ",\"ldc\":" << k.ldc;
+    os << ",\"stride_a\":" << k.stride_a << ",\"stride_b\":" << k.stride_b
+       << ",\"stride_c\":" << k.stride_c;
+    os << ",\"type_a\":\"" << type_name(k.type_a) << "\",\"type_b\":\"" << type_name(k.type_b)
+       << "\",\"type_c\":\"" << type_name(k.type_c) << "\"";
+    os << ",\"beta\":\"" << beta_name(k.beta) << "\"";
+    os << ",\"pointer_batched\":" << k.pointer_batched << ",\"device\":" << k.device
+       << ",\"cu_count\":" << k.cu_count;
+    os << ",\"max_workspace\":" << k.max_workspace << ",\"workspace\":" << p.workspace_size;
+    if(p.solution == nullptr)
+    {
+        os << ",\"solution\":null";
+        return;
+    }
+    os << ",\"solution\":";
+    write_string(os, p.solution->kernelName);
+    os << ",\"solution_id\":\"" << std::hex << solution_id(*p.solution) << std::dec << "\"";
+    os << ",\"source\":\"" << source_name(p.source) << "\"";
+    os << ",\"expected_gflops\":" << p.expected_gflops;
+    os << ",\"kernels\":[";
+    if(p.kernels.empty())
+        write_string(os, p.solution->kernelName);
+    for(std::size_t i = 0; i < p.kernels.size(); i++)
+    {
+        if(i > 0)
+            os << ",";
+        write_string(os, p.kernels[i].invocation.kernelName);
+    }
+    os << "]";
+}
+
+// Chrome events are preceded by a separator, which the writer drops for the
+// first event of the file
+void write_record(std::ostream& os, const trace_record& r, std::uint32_t thread)
+{
+    const auto& o = output();
+    if(o.format == trace_chrome)
+    {
+        os << ",\n{\"name\":\"" << r.call << "\",\"cat\":\"miopentensile\",\"ph\":\"X\"";
+        os << ",\"pid\":" << getpid() << ",\"tid\":" << thread;
+        os << ",\"ts\":" << to_us(r.start - o.epoch) << ",\"dur\":" << to_us(r.end - r.start);
+        os << ",\"args\":{";
+        write_fields(os, r);
+        os << "}}";
+    }
+    else
+    {
+        os << "{\"call\":\"" << r.call << "\",\"thread\":" << thread;
+        os << ",\"ts_us\":" << to_us(r.start - o.epoch)
+           << ",\"duration_us\":" << to_us(r.end - r.start) << ",";
+        write_fields(os, r);
+        os << "}\n";
+    }
+}
+
+void write_output(const std::string& text)
+{
+    auto& o = output();
+    std::lock_guard<std::mutex> guard(o.mutex);
+    if(o.file == nullptr or text.empty())
+        return;
+    std::size_t skip = 0;
+    if(o.format == trace_chrome and o.first_event)
+    {
+        skip          = 2;
+        o.first_event = false;
+    }
+    std::fwrite(text.data() + skip, 1, text.size() - skip, o.file);
+}
+
+void write_records(std::vector<trace_record>& records,
+                   std::uint64_t first,
+                   std::uint64_t last,
+                   std::uint32_t thread)
+{
+    std::ostringstream os;
+    for(; first != last; first++)
+    {
+        auto& r = records[first % records.size()];
+        write_record(os, r, thread);
+        r.plan = nullptr;
+    }
+    write_output(os.str());
+}
+
+void write_batches()
+{
+    auto& o = output();
+    std::unique_lock<std::mutex> lock(o.batch_mutex);
+    for(;;)
+    {
+        o.batch_added.wait(lock, [&] { return o.stopping or not o.batches.empty(); });
+        if(o.batches.empty())
+            return;
+        auto batch = std::move(o.batches.front());
+        o.batches.pop_front();
+        lock.unlock();
+        auto& ring = *batch.ring;
+        write_records(batch.records, batch.first, batch.last, ring.thread);
+        {
+            std::lock_guard<std::mutex> guard(ring.flush_mutex);
+            ring.spare   = std::move(batch.records);
+            ring.writing = false;
+        }
+        ring.written.notify_all();
+        lock.lock();
+    }
+}
+
+// Writes the records of a ring on this thread, after the ones the writer
+// holds
+void flush_ring(trace_ring& ring)
+{
+    std::unique_lock<std::mutex> lock(ring.flush_mutex);
+    ring.written.wait(lock, [&] { return not ring.writing; });
+    auto tail = ring.tail.load(std::memory_order_relaxed);
+    auto head = ring.head.load(std::memory_order_acquire);
+    if(tail == head)
+        return;
+    write_records(ring.records, tail, head, ring.thread);
+    ring.tail.store(head, std::memory_order_release);
+}
+
+// Gives the records of a full ring to the writer thread. Waits only when the
+// writer still holds the previous records of the ring.
+void hand_off(const std::shared_ptr<trace_ring>& ring)
+{
+    trace_batch batch;
+    {
+        std::unique_lock<std::mutex> lock(ring->flush_mutex);
+        ring->written.wait(lock, [&] { return not ring->writing; });
+        batch.ring  = ring;
+        batch.first = ring->tail.load(std::memory_order_relaxed);
+        batch.last  = ring->head.load(std::memory_order_acquire);
+        if(batch.first == batch.last)
+            return;
+        batch.records = std::move(ring->records);
+        ring->records = std::move(ring->spare);
+        ring->writing = true;
+        ring->tail.store(batch.last, std::memory_order_release);
+    }
+    auto& o = output();
+    {
+        std::lock_guard<std::mutex> guard(o.batch_mutex);
+        if(not o.writer.joinable())
+            o.writer = std::thread{write_batches};
+        o.batches.push_back(std::move(batch));
+    }
+    o.batch_added.notify_one();
+}
+
+// Writes every batch handed off and ends the writer thread
+void stop_writer()
+{
+    auto& o = output();
+    {
+        std::lock_guard<std::mutex> guard(o.batch_mutex);
+        if(not o.writer.joinable())
+            return;
+        o.stopping = true;
+    }
+    o.batch_added.notify_one();
+    o.writer.join();
+    std::lock_guard<std::mutex> guard(o.batch_mutex);
+    o.stopping = false;
+}
+
+void release_ring(const std::shared_ptr<trace_ring>& ring)
+{
+    flush_ring(*ring);
+    auto& o = output();
+    std::lock_guard<std::mutex> guard(o.mutex);
+    o.rings.erase(std::remove(o.rings.begin(), o.rings.end(), ring), o.rings.end());
+}
+
+std::shared_ptr<trace_ring> create_ring()
+{
+    auto& o = output();
+    std::lock_guard<std::mutex> guard(o.mutex);
+    auto ring = std::make_shared<trace_ring>(o.buffer_size, o.next_thread++);
+    o.rings.push_back(ring);
+    return ring;
+}
+
+trace_record* begin_trace(const char* call)
+{
+    // Calls made on behalf of another, such as while tuning, are part of it
+    if(active != nullptr)
+        return nullptr;
+    staging.call        = call;
+    staging.start       = trace_clock();
+    staging.planned     = staging.start;
+    staging.select      = 0;
+    staging.cache_hit   = true;
+    staging.status      = miopen_tensile_status_unknown;
+    staging.has_scalars = false;
+    active              = &staging;
+    return active;
+}
+
+void trace_plan(trace_record& r, const gemm_plan_ptr& p)
+{
+    r.plan    = p;
+    r.planned = trace_clock();
+}
+
+void end_trace(trace_record& r)
+{
+    r.end       = trace_clock();
+    active      = nullptr;
+    auto& ring  = local_ring.ring;
+    if(ring == nullptr)
+        ring = create_ring();
+    auto head = ring->head.load(std::memory_order_relaxed);
+    if(head - ring->tail.load(std::memory_order_acquire) == ring->records.size())
+        hand_off(ring);
+    ring->records[head % ring->records.size()] = std::move(r);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void stop_trace()
+{
+    auto& o = output();
+    trace_enabled.store(false, std::memory_order_relaxed);
+    stop_writer();
+    std::vector<std::shared_ptr<trace_ring>> rings;
+    {
+        std::lock_guard<std::mutex> guard(o.mutex);
+        rings = o.rings;
+    }
+    for(auto&& ring : rings)
+        flush_ring(*ring);
+    std::lock_guard<std::mutex> guard(o.mutex);
+    if(o.file == nullptr)
+        return;
+    if(o.format == trace_chrome)
+        std::fputs("\n]\n", o.file);
+    std::fclose(o.file);
+    o.file = nullptr;
+}
+
+void start_trace(const std::string& path, trace_format format, std::size_t buffer_size)
+{
+    stop_trace();
+    auto name = path;
+    auto pid  = name.find("%p");
+    if(pid != std::string::npos)
+        name.replace(pid, 2, std::to_string(getpid()));
+    auto& o = output();
+    std::lock_guard<std::mutex> guard(o.mutex);
+    o.file = std::fopen(name.c_str(), "w");
+    if(o.file == nullptr)
+        throw std::runtime_error("Failed to open trace file: " + name);
+    o.format      = format;
+    o.buffer_size = std::max<std::size_t>(buffer_size, 1);
+    o.epoch       = trace_clock();
+    o.first_event = true;
+    if(format == trace_chrome)
+        std::fputs("[\n", o.file);
+    trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+// Starts tracing from the environment when the library is loaded and writes
+// out what is left when it is unloaded
+struct trace_from_env
+{
+    trace_from_env()
+    {
+        // Constructed first so it outlives this object
+        output();
+        const char* path = std::getenv("MIOPEN_TENSILE_TRACE");
+        if(path == nullptr or *path == '\0')
+            return;
+        const char* format = std::getenv("MIOPEN_TENSILE_TRACE_FORMAT");
+        auto f = format != nullptr and std::strcmp(format, "chrome") == 0 ? trace_chrome
+                                                                          : trace_jsonl;
+        try
+        {
+            start_trace(path, f, env_size("MIOPEN_TENSILE_TRACE_BUFFER", 1024));
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << "MIOpenTensile error: " << e.what() << std::endl;
+        }
+    }
+    ~trace_from_env() { stop_trace(); }
+};
+
+const trace_from_env start_trace_from_env;
+
+} // namespace miopentensile
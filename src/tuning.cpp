@@ -0,0 +1,409 @@
+#include <miopentensile/tuning.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/solution_list.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace miopentensile {
+
+std::unordered_map<std::string, std::uint64_t> read_tuning_records(const std::string& path)
+{
+    std::unordered_map<std::string, std::uint64_t> result;
+    std::ifstream is(path);
+    std::string line;
+    while(std::getline(is, line))
+    {
+        if(line.empty() or line.front() == '#')
+            continue;
+        std::istringstream fields(line);
+        std::string key;
+        std::uint64_t id = 0;
+        if(fields >> key >> std::hex >> id and id != 0)
+            result[key] = id;
+    }
+    return result;
+}
+
+void make_directories(const std::string& dir)
+{
+    for(auto i = dir.find('/', 1);; i = dir.find('/', i + 1))
+    {
+        mkdir(dir.substr(0, i).c_str(), 0755);
+        if(i == std::string::npos)
+            break;
+    }
+}
+
+// Exclusive advisory lock on a file, held until destruction
+struct file_lock
+{
+    int fd = -1;
+
+    explicit file_lock(const std::string& path)
+    {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0)
+            throw std::runtime_error("Failed to open tuning db lock: " + path);
+        while(flock(fd, LOCK_EX) != 0)
+        {
+            if(errno != EINTR)
+            {
+                close(fd);
+                throw std::runtime_error("Failed to lock tuning db: " + path);
+            }
+        }
+    }
+    ~file_lock() { close(fd); }
+
+    file_lock(const file_lock&) = delete;
+    file_lock& operator=(const file_lock&) = delete;
+};
+
+tuning_db::tuning_db(std::string p) : file(std::move(p)) {}
+
+// Identifies what was written to the file. It is replaced on every write, so
+// a new inode, mtime or size means it has to be read again.
+bool file_version(const std::string& path, std::int64_t& version, std::int64_t& size)
+{
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0)
+        return false;
+    version = std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    version ^= std::int64_t(st.st_ino) << 32;
+    size = st.st_size;
+    return true;
+}
+
+void tuning_db::refresh()
+{
+    std::int64_t version = -1;
+    std::int64_t size    = -1;
+    if(not file_version(file, version, size))
+        records.clear();
+    else if(version != read_version or size != read_size)
+        records = read_tuning_records(file);
+    read_version = version;
+    read_size    = size;
+}
+
+std::uint64_t tuning_db::find(const std::string& key)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    refresh();
+    auto it = records.find(key);
+    if(it == records.end())
+        return 0;
+    return it->second;
+}
+
+void tuning_db::store(const std::string& key, std::uint64_t id)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    auto slash = file.rfind('/');
+    if(slash != std::string::npos and slash > 0)
+        make_directories(file.substr(0, slash));
+    file_lock lock{file + ".lock"};
+    // Merge with what other processes wrote since the last read
+    refresh();
+    records[key] = id;
+
+    auto tmp = file + ".tmp." + std::to_string(getpid());
+    {
+        std::map<std::string, std::uint64_t> sorted(records.begin(), records.end());
+        std::ofstream os(tmp);
+        os << "# miopentensile tuning db: key solution_id\n";
+        for(auto&& r : sorted)
+            os << r.first << " " << std::hex << r.second << std::dec << "\n";
+        if(not os)
+        {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("Failed to write tuning db: " + tmp);
+        }
+    }
+    if(std::rename(tmp.c_str(), file.c_str()) != 0)
+    {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Failed to write tuning db: " + file);
+    }
+    // The records already match what was written
+    file_version(file, read_version, read_size);
+}
+
+std::size_t tuning_db::size()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    refresh();
+    return records.size();
+}
+
+std::string tuning_key(const problem_key& key, const Tensile::Hardware& hw)
+{
+    auto arch          = hardware_arch(hw);
+    std::uint64_t hash = 0;
+    if(const auto* index = library_index(arch))
+        hash = index->content_hash();
+    std::ostringstream os;
+    os << arch << ":" << hardware_cu_count(hw) << "," << std::hex << hash << std::dec;
+    for(auto v : {std::size_t(key.transpose_a),
+                  std::size_t(key.transpose_b),
+                  key.m,
+                  key.n,
+                  key.k,
+                  key.batch,
+                  key.lda,
+                  key.ldb,
+                  key.ldc,
+                  key.stride_a,
+                  key.stride_b,
+                  key.stride_c,
+                  std::size_t(key.type_a),
+                  std::size_t(key.type_b),
+                  std::size_t(key.type_c),
+                  std::size_t(key.high_precision_accumulate),
+                  std::size_t(key.beta),
+                  std::size_t(key.pointer_batched)})
+        os << "," << v;
+    return os.str();
+}
+
+std::size_t element_size(miopen_tensile_type t)
+{
+    switch(t)
+    {
+    case miopen_tensile_type_float: return 4;
+    case miopen_tensile_type_half: return 2;
+    case miopen_tensile_type_bfloat16: return 2;
+    // Lengths along k are in bytes
+    case miopen_tensile_type_int8x4: return 1;
+    case miopen_tensile_type_int32: return 4;
+    }
+    return 4;
+}
+
+std::size_t matrix_bytes(const miopen_tensile_matrix& m)
+{
+    if(m.lens[0] == 0 or m.lens[1] == 0)
+        return 0;
+    auto last = (m.lens[0] - 1) * m.strides[0] + (m.lens[1] - 1) * m.strides[1];
+    if(m.batch.num > 1)
+        last += (m.batch.num - 1) * m.batch.stride;
+    return (last + 1) * element_size(m.type);
+}
+
+struct device_buffer
+{
+    void* data = nullptr;
+
+    explicit device_buffer(std::size_t n)
+    {
+        if(n == 0)
+            return;
+        if(hipMalloc(&data, n) != hipSuccess)
+            throw std::runtime_error("Failed to allocate tuning buffer");
+        hipMemset(data, 0, n);
+    }
+    ~device_buffer()
+    {
+        if(data != nullptr)
+            hipFree(data);
+    }
+
+    device_buffer(const device_buffer&) = delete;
+    device_buffer& operator=(const device_buffer&) = delete;
+};
+
+struct hip_event
+{
+    hipEvent_t event = nullptr;
+
+    hip_event()
+    {
+        if(hipEventCreate(&event) != hipSuccess)
+            throw std::runtime_error("Failed to create tuning event");
+    }
+    ~hip_event() { hipEventDestroy(event); }
+
+    hip_event(const hip_event&) = delete;
+    hip_event& operator=(const hip_event&) = delete;
+};
+
+struct hip_timer : solution_timer
+{
+    static const int runs = 10;
+
+    double time(const gemm_plan& p, const tensile_operands& x) override
+    {
+        device_buffer a{matrix_bytes(x.a)};
+        device_buffer b{matrix_bytes(x.b)};
+        device_buffer c{matrix_bytes(x.c)};
+        device_buffer workspace{p.workspace_size};
+        gemm_args args;
+        args.a         = a.data;
+        args.b         = b.data;
+        args.c         = c.data;
+        args.beta      = p.problem.beta();
+        args.workspace = workspace.data;
+        // The first run loads the code object
+        if(p.execute(nullptr, args) != miopen_tensile_status_success)
+            return std::numeric_limits<double>::infinity();
+        hip_event start;
+        hip_event stop;
+        hipEventRecord(start.event, nullptr);
+        for(int i = 0; i < runs; i++)
+            p.execute(nullptr, args);
+        hipEventRecord(stop.event, nullptr);
+        hipEventSynchronize(stop.event);
+        float ms = 0;
+        hipEventElapsedTime(&ms, start.event, stop.event);
+        return ms / runs;
+    }
+};
+
+std::shared_ptr<solution_timer> hip_solution_timer() { return std::make_shared<hip_timer>(); }
+
+// Without tuning and a path set there is no database, so selection does no
+// file io and takes no lock for it
+std::string default_tuning_db_path(bool tune)
+{
+    const char* path = std::getenv("MIOPEN_TENSILE_TUNING_DB");
+    if(path != nullptr and *path != '\0')
+        return path;
+    if(not tune)
+        return "";
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    if(cache != nullptr and *cache != '\0')
+        return std::string(cache) + "/miopentensile/tuning.db";
+    const char* home = std::getenv("HOME");
+    if(home != nullptr and *home != '\0')
+        return std::string(home) + "/.cache/miopentensile/tuning.db";
+    return "";
+}
+
+tuning_options default_tuning_options()
+{
+    tuning_options result;
+    result.candidates = env_size("MIOPEN_TENSILE_TUNE", 0);
+    result.db_path    = default_tuning_db_path(result.candidates > 0);
+    return result;
+}
+
+struct tuning_state
+{
+    std::mutex mutex;
+    tuning_options options = default_tuning_options();
+    // Whether options has a database, read without the lock
+    std::atomic<bool> enabled{not options.db_path.empty()};
+    // Opened on first use
+    std::shared_ptr<tuning_db> db;
+    std::shared_ptr<solution_timer> timer = hip_solution_timer();
+};
+
+tuning_state& tuning()
+{
+    static tuning_state result;
+    return result;
+}
+
+void set_tuning_options(const tuning_options& o)
+{
+    auto& s = tuning();
+    std::lock_guard<std::mutex> guard(s.mutex);
+    s.options = o;
+    s.db      = nullptr;
+    s.enabled = not o.db_path.empty();
+}
+
+void set_solution_timer(std::shared_ptr<solution_timer> t)
+{
+    auto& s = tuning();
+    std::lock_guard<std::mutex> guard(s.mutex);
+    s.timer = std::move(t);
+}
+
+std::uint64_t tune_solution(const tensile_operands& x,
+                            double beta,
+                            int device,
+                            std::size_t max_workspace,
+                            std::size_t candidates,
+                            solution_timer& timer)
+{
+    std::uint64_t result = 0;
+    double best          = std::numeric_limits<double>::infinity();
+    std::size_t timed    = 0;
+    for(auto&& s : find_solutions(x.a, x.b, x.c, beta, device))
+    {
+        if(timed == candidates)
+            break;
+        if(s.workspace_size > max_workspace)
+            continue;
+        auto p = create_gemm_plan(x.a, x.b, x.c, beta, device, max_workspace, s.id);
+        if(p->solution == nullptr)
+            continue;
+        timed++;
+        auto ms = timer.time(*p, x);
+        if(ms < best)
+        {
+            best   = ms;
+            result = s.id;
+        }
+    }
+    return result;
+}
+
+solution_ptr tuned_solution(const gemm_plan& p, const tensile_operands& x, double beta)
+{
+    std::shared_ptr<tuning_db> db;
+    std::shared_ptr<solution_timer> timer;
+    std::size_t candidates = 0;
+    {
+        auto& s = tuning();
+        if(not s.enabled)
+            return nullptr;
+        std::lock_guard<std::mutex> guard(s.mutex);
+        if(s.db == nullptr and not s.options.db_path.empty())
+            s.db = std::make_shared<tuning_db>(s.options.db_path);
+        db         = s.db;
+        timer      = s.timer;
+        candidates = s.options.candidates;
+    }
+    if(db == nullptr)
+        return nullptr;
+    auto key = tuning_key(p.key, *p.hardware);
+    auto id  = db->find(key);
+    if(id == 0 and candidates > 0 and timer != nullptr)
+    {
+        id = tune_solution(x, beta, p.key.device, p.key.max_workspace, candidates, *timer);
+        try
+        {
+            if(id != 0)
+                db->store(key, id);
+        }
+        catch(const std::exception& e)
+        {
+            // The gemm can still use the winner when the database is read-only
+            std::cerr << e.what() << std::endl;
+        }
+    }
+    if(id == 0)
+        return nullptr;
+    auto s = find_solution(library(hardware_arch(*p.hardware)), p.problem, *p.hardware, id);
+    if(s == nullptr or s->requiredWorkspaceSize(p.problem) > p.key.max_workspace)
+        return nullptr;
+    return s;
+}
+
+} // namespace miopentensile
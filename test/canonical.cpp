@@ -0,0 +1,338 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/problem.hpp>
+#include "cpu_gemm.hpp"
+#include "fixtures.hpp"
+#include "test.hpp"
+
+// Runs gemms and their normal forms on the host reference over the same
+// buffers, so the two agree element for element without a gpu.
+
+using mitensile::half;
+using mitensile::shape;
+
+template<class T>
+miopen_tensile_type type_of();
+
+template<>
+miopen_tensile_type type_of<float>() { return miopen_tensile_type_float; }
+
+template<>
+miopen_tensile_type type_of<half>() { return miopen_tensile_type_half; }
+
+// Rows and columns stored with the given strides, and a batch when count is
+// more than one
+miopen_tensile_matrix matrix(std::size_t rows,
+                             std::size_t cols,
+                             std::size_t row_stride,
+                             std::size_t col_stride,
+                             std::size_t count        = 0,
+                             std::size_t batch_stride = 0)
+{
+    return miopen_tensile_matrix{{rows, cols},
+                                 {row_stride, col_stride},
+                                 {count, batch_stride},
+                                 miopen_tensile_type_float,
+                                 nullptr};
+}
+
+miopen_tensile_matrix by_rows(std::size_t rows, std::size_t cols)
+{
+    return matrix(rows, cols, cols, 1);
+}
+
+miopen_tensile_matrix by_cols(std::size_t rows, std::size_t cols)
+{
+    return matrix(rows, cols, 1, rows);
+}
+
+// The layout of the matrix for the reference, which applies the batch stride
+// to every item as the library does
+shape to_shape(const miopen_tensile_matrix& m, std::size_t batch)
+{
+    shape result;
+    if(batch > 1)
+    {
+        result.lens.push_back(batch);
+        result.strides.push_back(m.batch.stride);
+    }
+    result.lens.insert(result.lens.end(), {m.lens[0], m.lens[1]});
+    result.strides.insert(result.strides.end(), {m.strides[0], m.strides[1]});
+    return result;
+}
+
+std::size_t batch_of(const miopen_tensile_matrix& a,
+                     const miopen_tensile_matrix& b,
+                     const miopen_tensile_matrix& c)
+{
+    return std::max({a.batch.num, b.batch.num, c.batch.num, std::size_t{1}});
+}
+
+// Gemm in api operand order over the buffers, on the reference
+template<class T>
+std::vector<T> reference(const miopen_tensile_matrix& a,
+                         const miopen_tensile_matrix& b,
+                         const miopen_tensile_matrix& c,
+                         const std::vector<T>& a_data,
+                         const std::vector<T>& b_data,
+                         const std::vector<T>& c_data)
+{
+    auto batch = batch_of(a, b, c);
+    mitensile::problem<T> p;
+    p.as = to_shape(a, batch);
+    p.bs = to_shape(b, batch);
+    p.cs = to_shape(c, batch);
+    p.a  = a_data;
+    p.b  = b_data;
+    p.c  = c_data;
+    return mitensile::cpu_gemm(p);
+}
+
+std::size_t space(const miopen_tensile_matrix& m, std::size_t batch)
+{
+    return to_shape(m, batch).element_space();
+}
+
+template<class T>
+void verify_canonical(miopen_tensile_matrix a, miopen_tensile_matrix b, miopen_tensile_matrix c)
+{
+    for(auto* m : {&a, &b, &c})
+        m->type = type_of<T>();
+    auto batch    = batch_of(a, b, c);
+    auto a_data   = mitensile::generate<T>(space(a, batch), 1);
+    auto b_data   = mitensile::generate<T>(space(b, batch), 2);
+    auto c_data   = mitensile::fill<T>(space(c, batch), 7);
+    auto expected = reference(a, b, c, a_data, b_data, c_data);
+
+    auto g = miopentensile::canonicalize(b, a, c);
+    EXPECT(not miopentensile::is_transposed(g.c));
+    EXPECT(g.a.type == a.type);
+    EXPECT(g.b.type == b.type);
+    EXPECT(g.c.type == c.type);
+    // The form takes a from the api b and b from the api a, unless swapped
+    auto x_data = g.swapped ? b_data : a_data;
+    auto y_data = g.swapped ? a_data : b_data;
+    EXPECT(reference(g.b, g.a, g.c, x_data, y_data, c_data) == expected);
+
+    // Idempotent, so the plans of the form are found again from it
+    auto h = miopentensile::canonicalize(g.a, g.b, g.c);
+    EXPECT(not h.swapped);
+    EXPECT(bool(miopentensile::create_problem_key(h.a, h.b, h.c, 0.0, 0) ==
+                miopentensile::create_problem_key(g.a, g.b, g.c, 0.0, 0)));
+}
+
+void verify_canonical(miopen_tensile_matrix a, miopen_tensile_matrix b, miopen_tensile_matrix c)
+{
+    verify_canonical<float>(a, b, c);
+    verify_canonical<half>(a, b, c);
+}
+
+miopentensile::problem_key key_of(miopen_tensile_matrix a,
+                                  miopen_tensile_matrix b,
+                                  miopen_tensile_matrix c)
+{
+    auto g            = miopentensile::canonicalize(b, a, c);
+    auto key          = miopentensile::create_problem_key(g.a, g.b, g.c, 0.0, 0);
+    key.swap_operands = g.swapped;
+    return key;
+}
+
+TEST_CASE(canonical_transposed_c)
+{
+    for(bool ta : {false, true})
+    {
+        for(bool tb : {false, true})
+        {
+            auto a = ta ? by_cols(37, 20) : by_rows(37, 20);
+            auto b = tb ? by_cols(20, 29) : by_rows(20, 29);
+            verify_canonical(a, b, by_cols(37, 29));
+            verify_canonical(a, b, by_rows(37, 29));
+            // Padded columns of c
+            verify_canonical(a, b, matrix(37, 29, 1, 40));
+            // Batched
+            auto ab  = a;
+            auto bb  = b;
+            ab.batch = {3, 37 * 20 + 5};
+            bb.batch = {3, 20 * 29};
+            verify_canonical(ab, bb, matrix(37, 29, 1, 37, 3, 37 * 29));
+        }
+    }
+    auto g = miopentensile::canonicalize(by_rows(20, 29), by_rows(37, 20), by_cols(37, 29));
+    EXPECT(g.swapped);
+    // The same gemm as its transpose stored by rows, with the operands swapped
+    auto x = key_of(by_rows(37, 20), by_rows(20, 29), by_cols(37, 29));
+    auto y = key_of(by_cols(29, 20), by_cols(20, 37), by_rows(29, 37));
+    EXPECT(x.swap_operands);
+    EXPECT(not y.swap_operands);
+    x.swap_operands = false;
+    EXPECT(bool(x == y));
+}
+
+TEST_CASE(canonical_batch_of_one)
+{
+    auto a     = by_rows(24, 16);
+    auto b     = by_cols(16, 12);
+    auto c     = by_rows(24, 12);
+    auto plain = key_of(a, b, c);
+    for(std::size_t stride : {0, 1, 24 * 16, 100000})
+    {
+        auto ab  = a;
+        auto bb  = b;
+        auto cb  = c;
+        ab.batch = {1, stride};
+        bb.batch = {1, stride + 3};
+        cb.batch = {1, stride * 2};
+        verify_canonical(ab, bb, cb);
+        EXPECT(bool(key_of(ab, bb, cb) == plain));
+        auto g = miopentensile::canonicalize(bb, ab, cb);
+        for(auto&& m : {g.a, g.b, g.c})
+        {
+            EXPECT(m.batch.num == 0u);
+            EXPECT(m.batch.stride == 0u);
+        }
+    }
+}
+
+TEST_CASE(canonical_contiguous_batches)
+{
+    // Items follow each other in a and c and share b
+    auto a = matrix(9, 16, 16, 1, 5, 9 * 16);
+    auto b = matrix(16, 11, 11, 1, 0, 0);
+    auto c = matrix(9, 11, 11, 1, 5, 9 * 11);
+    verify_canonical(a, b, c);
+    auto g = miopentensile::canonicalize(b, a, c);
+    EXPECT(g.b.lens[0] == 45u);
+    EXPECT(g.c.lens[0] == 45u);
+    EXPECT(g.c.batch.num == 0u);
+    EXPECT(bool(key_of(a, b, c) == key_of(by_rows(45, 16), by_rows(16, 11), by_rows(45, 11))));
+
+    // The shared b given with a count and a stride of zero
+    b.batch = {5, 0};
+    verify_canonical(a, b, c);
+    EXPECT(miopentensile::canonicalize(b, a, c).c.lens[0] == 45u);
+    // Padded rows, as long as the items follow on
+    auto padded_a = matrix(9, 16, 20, 1, 5, 9 * 20);
+    auto padded_c = matrix(9, 11, 13, 1, 5, 9 * 13);
+    verify_canonical(padded_a, b, padded_c);
+    EXPECT(miopentensile::canonicalize(b, padded_a, padded_c).c.lens[0] == 45u);
+    // A c stored by columns, whose normal form merges the batches of b
+    auto ct = matrix(9, 11, 1, 9, 5, 9 * 11);
+    auto bt = matrix(16, 11, 1, 16, 5, 16 * 11);
+    verify_canonical(matrix(9, 16, 16, 1, 0, 0), bt, ct);
+    EXPECT(miopentensile::canonicalize(bt, matrix(9, 16, 16, 1, 0, 0), ct).c.lens[0] == 55u);
+
+    // Kept as batches: b differs per item, a gap between items, a by columns
+    auto kept = [](miopen_tensile_matrix x, miopen_tensile_matrix y, miopen_tensile_matrix z) {
+        verify_canonical(x, y, z);
+        EXPECT(miopentensile::canonicalize(y, x, z).c.batch.num == 5u);
+    };
+    kept(a, matrix(16, 11, 11, 1, 5, 16 * 11), c);
+    kept(matrix(9, 16, 16, 1, 5, 9 * 16 + 16), b, c);
+    kept(a, b, matrix(9, 11, 11, 1, 5, 9 * 11 + 1));
+    kept(matrix(9, 16, 1, 9, 5, 9 * 16), b, c);
+}
+
+TEST_CASE(canonical_strides)
+{
+    // The unused stride of a vector does not change the form
+    auto key = key_of(by_rows(1, 16), by_rows(16, 12), by_rows(1, 12));
+    for(std::size_t stride : {0, 1, 7, 500})
+    {
+        auto a = matrix(1, 16, stride, 1);
+        auto c = matrix(1, 12, stride, 1);
+        verify_canonical(a, by_rows(16, 12), c);
+        EXPECT(bool(key_of(a, by_rows(16, 12), c) == key));
+    }
+    auto column = key_of(by_rows(20, 16), by_rows(16, 1), by_rows(20, 1));
+    for(std::size_t stride : {0, 1, 20, 64})
+    {
+        auto b = matrix(16, 1, 1, stride);
+        auto c = matrix(20, 1, 1, stride);
+        verify_canonical(by_rows(20, 16), b, c);
+        EXPECT(bool(key_of(by_rows(20, 16), b, c) == column));
+    }
+    // A row of c with strided columns is the transpose of a column
+    verify_canonical(by_rows(1, 16), by_cols(16, 12), matrix(1, 12, 1, 3));
+    EXPECT(miopentensile::canonicalize(by_cols(16, 12), by_rows(1, 16), matrix(1, 12, 1, 3))
+               .swapped);
+    // Single elements
+    verify_canonical(matrix(1, 1, 4, 9), matrix(1, 1, 2, 3), matrix(1, 1, 5, 6));
+    // Int8x4 operands keep their layout
+    auto a = matrix(1, 16, 3, 1);
+    auto b = by_cols(16, 12);
+    auto c = by_rows(1, 12);
+    a.type = miopen_tensile_type_int8x4;
+    b.type = miopen_tensile_type_int8x4;
+    c.type = miopen_tensile_type_int32;
+    EXPECT(miopentensile::canonicalize(b, a, c).b.strides[0] == 3u);
+}
+
+struct recording_launcher : miopentensile::kernel_launcher
+{
+    std::vector<Tensile::KernelInvocation> last;
+    void load_code_object(const std::string&) override {}
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>& kernels, hipStream_t) override
+    {
+        last = kernels;
+        return hipSuccess;
+    }
+};
+
+TEST_CASE(canonical_plans_share_selection)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    auto launcher = std::make_shared<recording_launcher>();
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    miopentensile::set_kernel_launcher(launcher);
+    miopentensile::clear_plan_cache();
+
+    // A gemm with c stored by columns and its transpose stored by rows
+    auto a  = by_rows(256, 64);
+    auto b  = by_rows(64, 128);
+    auto c  = by_cols(256, 128);
+    auto ya = by_cols(128, 64);
+    auto yb = by_cols(64, 256);
+    auto yc = by_rows(128, 256);
+    auto x  = miopentensile::get_gemm_plan(b, a, c, 0.0);
+    auto y  = miopentensile::get_gemm_plan(yb, ya, yc, 0.0);
+    EXPECT(x->key.swap_operands);
+    EXPECT(not y->key.swap_operands);
+    EXPECT(x->solution == y->solution);
+    if(x->solution == nullptr)
+        return;
+    // The same kernels with the same arguments
+    std::vector<float> buffers(3);
+    a.data  = &buffers[0];
+    b.data  = &buffers[1];
+    c.data  = &buffers[2];
+    ya.data = &buffers[1];
+    yb.data = &buffers[0];
+    yc.data = &buffers[2];
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    auto first = launcher->last;
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &ya, &yb, &yc, 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    EXPECT(first.size() == launcher->last.size());
+    for(std::size_t i = 0; i < first.size() and i < launcher->last.size(); i++)
+    {
+        const auto& u = first[i].args;
+        const auto& v = launcher->last[i].args;
+        EXPECT(first[i].kernelName == launcher->last[i].kernelName);
+        EXPECT(u.size() == v.size());
+        EXPECT(std::equal(static_cast<const char*>(u.data()),
+                          static_cast<const char*>(u.data()) + std::min(u.size(), v.size()),
+                          static_cast<const char*>(v.data())));
+    }
+    miopentensile::set_kernel_launcher(miopentensile::hip_kernel_launcher());
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -0,0 +1,119 @@
+#include <miopentensile/code_objects.hpp>
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "test.hpp"
+
+// Write a minimal ELF64 file whose symbol table describes the given objects
+std::string write_code_object(const std::string& name, const std::vector<std::pair<std::string, unsigned char>>& symbols)
+{
+    std::string strtab(1, '\0');
+    std::vector<Elf64_Sym> syms(1, Elf64_Sym{});
+    for(auto&& s : symbols)
+    {
+        Elf64_Sym sym{};
+        sym.st_name = strtab.size();
+        sym.st_info = ELF64_ST_INFO(STB_GLOBAL, s.second);
+        syms.push_back(sym);
+        strtab += s.first;
+        strtab.push_back('\0');
+    }
+    Elf64_Ehdr header{};
+    std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_shentsize       = sizeof(Elf64_Shdr);
+    header.e_shnum           = 3;
+    header.e_shoff           = sizeof(Elf64_Ehdr);
+
+    std::vector<Elf64_Shdr> sections(3, Elf64_Shdr{});
+    auto data_offset       = header.e_shoff + 3 * sizeof(Elf64_Shdr);
+    sections[1].sh_type    = SHT_SYMTAB;
+    sections[1].sh_offset  = data_offset;
+    sections[1].sh_size    = syms.size() * sizeof(Elf64_Sym);
+    sections[1].sh_entsize = sizeof(Elf64_Sym);
+    sections[1].sh_link    = 2;
+    sections[2].sh_type    = SHT_STRTAB;
+    sections[2].sh_offset  = data_offset + sections[1].sh_size;
+    sections[2].sh_size    = strtab.size();
+
+    auto path = "/tmp/miopentensile_test_" + std::to_string(getpid()) + "_" + name;
+    std::ofstream os(path, std::ios::binary);
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(Elf64_Shdr));
+    os.write(reinterpret_cast<const char*>(syms.data()), syms.size() * sizeof(Elf64_Sym));
+    os.write(strtab.data(), strtab.size());
+    return path;
+}
+
+TEST_CASE(elf_kernels)
+{
+    auto path = write_code_object("a_gfx906.co",
+                                  {{"kernel1.kd", STT_OBJECT},
+                                   {"kernel1", STT_FUNC},
+                                   {"kernel2", 10},
+                                   {"data", STT_OBJECT}});
+    auto kernels = miopentensile::code_object_kernels(path);
+    EXPECT(kernels == std::vector<std::string>{"kernel1", "kernel2"});
+    std::remove(path.c_str());
+    EXPECT(test::throws([] { miopentensile::code_object_kernels("/does/not/exist.co"); }));
+}
+
+TEST_CASE(match_arch)
+{
+    EXPECT(miopentensile::code_object_matches_arch("lib/TensileLibrary_gfx906.co", "gfx906"));
+    EXPECT(miopentensile::code_object_matches_arch("lib/Kernels.so-000-gfx906.hsaco", "gfx906:xnack-"));
+    EXPECT(not miopentensile::code_object_matches_arch("lib/TensileLibrary_gfx906.co", "gfx90"));
+    EXPECT(not miopentensile::code_object_matches_arch("lib/TensileLibrary_gfx908.co", "gfx90a"));
+    EXPECT(miopentensile::code_object_matches_arch("lib/TensileLibrary_gfx908_xnack-.co", "gfx908"));
+    EXPECT(miopentensile::code_object_matches_arch("lib/Kernels.co", "gfx1030"));
+}
+
+TEST_CASE(lazy_loading)
+{
+    auto a = write_code_object("a.co", {{"ka.kd", STT_OBJECT}});
+    auto b = write_code_object("b.co", {{"kb.kd", STT_OBJECT}, {"kc.kd", STT_OBJECT}});
+    std::atomic<int> loads_a{0};
+    std::atomic<int> loads_b{0};
+    miopentensile::code_object_loader loader{{a, b}, [&](const std::string& f) {
+                                                 if(f == a)
+                                                     loads_a++;
+                                                 else
+                                                     loads_b++;
+                                             }};
+    EXPECT(loader.loaded_files() == 0u);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 8; i++)
+        threads.emplace_back([&] {
+            EXPECT(loader.load_kernel("kb"));
+            EXPECT(loader.load_kernel("kc"));
+        });
+    for(auto&& t : threads)
+        t.join();
+    EXPECT(loads_a == 0);
+    EXPECT(loads_b == 1);
+    EXPECT(not loader.load_kernel("kd"));
+    EXPECT(loader.load_kernel("ka"));
+    EXPECT(loads_a == 1);
+    EXPECT(loader.loaded_files() == 2u);
+    std::remove(a.c_str());
+    std::remove(b.c_str());
+}
+
+TEST_CASE(build_index)
+{
+    // The index is read once, when it is built, without loading anything
+    auto a = write_code_object("c.co", {{"ke.kd", STT_OBJECT}});
+    miopentensile::code_object_loader loader{{a}, [](const std::string&) {}};
+    loader.build_index();
+    std::remove(a.c_str());
+    loader.build_index();
+    EXPECT(loader.kernel_file("ke") == 0u);
+    EXPECT(loader.loaded_files() == 0u);
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -0,0 +1,386 @@
+#include <miopentensile/cost_model.hpp>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_file.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/logic_problem.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fixtures.hpp"
+#include "test.hpp"
+
+// Runs without a gpu. The ranking is measured on table entries left out of
+// the fit, for a table generated from known parameters and for the installed
+// tables when there are any.
+
+std::string temp_path(const std::string& name)
+{
+    auto dir = "/tmp/miopentensile_test_" + std::to_string(getpid());
+    mkdir(dir.c_str(), 0700);
+    return dir + "/" + name;
+}
+
+miopentensile::logic_index::solution_record make_solution(int mt0, int mt1, int du, int gsu = 1)
+{
+    miopentensile::logic_index::solution_record s{};
+    s.macro_tile0              = mt0;
+    s.macro_tile1              = mt1;
+    s.depth_u                  = du;
+    s.global_split_u           = gsu;
+    s.workgroup_mapping        = 8;
+    s.vector_width             = 4;
+    s.global_read_vector_width = 4;
+    return s;
+}
+
+miopentensile::cost_problem make_problem(std::uint64_t m, std::uint64_t n, std::uint64_t k)
+{
+    miopentensile::cost_problem x;
+    x.m = m;
+    x.n = n;
+    x.k = k;
+    return x;
+}
+
+TEST_CASE(cost_terms)
+{
+    miopentensile::device_params device{120, 1500};
+    miopentensile::cost_params params;
+    auto s = make_solution(64, 64, 16);
+
+    // 120 tiles fill one wave, one more tile takes a second
+    auto full = miopentensile::predict_cost(s, make_problem(768, 640, 256), device, params);
+    auto more = miopentensile::predict_cost(s, make_problem(769, 640, 256), device, params);
+    EXPECT(full.waves == 1);
+    EXPECT(more.waves == 2);
+    EXPECT(more.seconds > 1.5 * full.seconds);
+    EXPECT(full.tile_efficiency == 1);
+    auto padded = miopentensile::predict_cost(s, make_problem(65, 64, 256), device, params);
+    EXPECT(std::abs(padded.tile_efficiency - 65.0 / 128) < 1e-9);
+
+    // More cus and a higher clock are faster for large problems
+    auto big = make_problem(4096, 4096, 4096);
+    auto t   = miopentensile::predict_cost(s, big, device, params).seconds;
+    EXPECT(miopentensile::predict_cost(s, big, {60, 1500}, params).seconds > 1.9 * t);
+    EXPECT(miopentensile::predict_cost(s, big, {120, 750}, params).seconds > 1.9 * t);
+
+    // Split k helps a problem with few tiles and a long k, and costs extra
+    // traffic for the partial results
+    auto deep  = make_problem(128, 128, 65536);
+    auto split = make_solution(64, 64, 16, 16);
+    auto one   = miopentensile::predict_cost(s, deep, device, params);
+    auto many  = miopentensile::predict_cost(split, deep, device, params);
+    EXPECT(many.seconds < one.seconds);
+    EXPECT(many.bytes > one.bytes);
+
+    // Narrow reads and thread tiles are slower
+    auto narrow                     = s;
+    narrow.global_read_vector_width = 1;
+    narrow.vector_width             = 1;
+    EXPECT(miopentensile::predict_cost(narrow, big, device, params).seconds > t);
+}
+
+// Positions of the table winners in the model ranking of their sizes
+struct ranking_result
+{
+    std::size_t sizes = 0;
+    std::size_t top1  = 0;
+    std::size_t top5  = 0;
+    // Sizes whose winner is also the winner of the closest size left in
+    std::size_t nearest = 0;
+    // Sums over the sizes of 1 / solutions and 5 / solutions, the expected
+    // top1 and top5 of a random ranking
+    double chance1 = 0;
+    double chance5 = 0;
+
+    void add(const ranking_result& r)
+    {
+        sizes += r.sizes;
+        top1 += r.top1;
+        top5 += r.top5;
+        nearest += r.nearest;
+        chance1 += r.chance1;
+        chance5 += r.chance5;
+    }
+};
+
+ranking_result held_out_ranking(const miopentensile::logic_index& index,
+                                std::size_t type,
+                                const miopentensile::device_params& device)
+{
+    const auto& t = index.type(type);
+    auto entries  = index.entries_of(t);
+    auto held_out = [&](const miopentensile::logic_index::entry_record& e) {
+        return (&e - entries.begin()) % 5 == 0;
+    };
+    auto params = miopentensile::calibrate_cost_model(
+        index, type, device, [&](auto&& e) { return not held_out(e); });
+    auto solutions = index.solutions_of(t);
+    ranking_result result;
+    for(auto&& e : entries)
+    {
+        if(not held_out(e) or e.gflops <= 0)
+            continue;
+        auto x = miopentensile::entry_problem(t, e);
+        std::vector<std::pair<double, std::size_t>> ranked;
+        for(auto&& s : solutions)
+            ranked.emplace_back(miopentensile::predict_cost(s, x, device, params).seconds,
+                                &s - &index.solution(0));
+        std::stable_sort(ranked.begin(), ranked.end(), [](auto&& a, auto&& b) {
+            return a.first < b.first;
+        });
+        auto it = std::find_if(ranked.begin(), ranked.end(), [&](auto&& r) {
+            return r.second == e.solution;
+        });
+        auto position = it - ranked.begin();
+        const miopentensile::logic_index::entry_record* closest = nullptr;
+        double distance = std::numeric_limits<double>::infinity();
+        for(auto&& f : entries)
+        {
+            auto d = miopentensile::nearest_size_tree::distance({{f.m, f.n, f.batch, f.k}},
+                                                                {{e.m, e.n, e.batch, e.k}});
+            if(not held_out(f) and d < distance)
+            {
+                closest  = &f;
+                distance = d;
+            }
+        }
+        result.sizes++;
+        result.top1 += position == 0;
+        result.top5 += position < 5;
+        result.nearest += closest != nullptr and closest->solution == e.solution;
+        result.chance1 += 1.0 / ranked.size();
+        result.chance5 += std::min(5.0 / ranked.size(), 1.0);
+    }
+    return result;
+}
+
+miopentensile::cost_params true_params()
+{
+    miopentensile::cost_params result;
+    result.flops_per_cycle = 180;
+    result.bytes_per_cycle = 300;
+    result.wave_cycles     = 3500;
+    result.vector_cost     = 0.5;
+    result.read_cost       = 2;
+    return result;
+}
+
+const miopentensile::device_params reference_device{120, 1502};
+
+// A logic file with a solution for each macro tile and split, and the winner
+// of each of a number of random sizes under the true parameters, measured
+// with noise
+miopentensile::logic_file synthetic_logic(const std::vector<int>& tiles0,
+                                          const std::vector<int>& tiles1,
+                                          const std::vector<int>& splits,
+                                          std::size_t sizes,
+                                          bool cu_efficiency = false)
+{
+    miopentensile::logic_file f;
+    f.path          = "synthetic_Cijk_Ailk_Bljk_SB.yaml";
+    f.arch          = "gfx908";
+    f.operation     = "Cijk_Ailk_Bljk_SB";
+    f.cu_efficiency = cu_efficiency;
+    std::vector<miopentensile::logic_index::solution_record> records;
+    for(int mt0 : tiles0)
+    {
+        for(int mt1 : tiles1)
+        {
+            for(int gsu : splits)
+            {
+                miopentensile::logic_solution s;
+                s.name = (cu_efficiency ? "CU_MT" : "MT") + std::to_string(mt0) + "x" +
+                         std::to_string(mt1) + "_GSU" + std::to_string(gsu);
+                s.macro_tile0              = mt0;
+                s.macro_tile1              = mt1;
+                s.depth_u                  = mt0 * mt1 > 8192 ? 8 : 16;
+                s.global_split_u           = gsu;
+                s.workgroup_mapping        = mt0 == 32 ? 1 : 8;
+                s.vector_width             = mt0 * mt1 >= 4096 ? 4 : 2;
+                s.global_read_vector_width = mt1 == 32 ? 1 : 4;
+                f.solutions.push_back(s);
+                auto r                     = make_solution(mt0, mt1, s.depth_u, gsu);
+                r.workgroup_mapping        = s.workgroup_mapping;
+                r.vector_width             = s.vector_width;
+                r.global_read_vector_width = s.global_read_vector_width;
+                records.push_back(r);
+            }
+        }
+    }
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<double> log_size(4, 13);
+    std::uniform_int_distribution<int> batches(1, 4);
+    std::normal_distribution<double> noise(0, 0.03);
+    for(std::size_t i = 0; i < sizes; i++)
+    {
+        miopentensile::logic_entry e;
+        e.m     = std::uint64_t(std::exp2(log_size(gen)));
+        e.n     = std::uint64_t(std::exp2(log_size(gen)));
+        e.k     = std::uint64_t(std::exp2(log_size(gen)));
+        e.batch = batches(gen) == 1 ? 8 : 1;
+        auto x  = make_problem(e.m, e.n, e.k);
+        x.batch = e.batch;
+        for(std::size_t j = 0; j < records.size(); j++)
+        {
+            auto g = miopentensile::predict_cost(records[j], x, reference_device, true_params())
+                         .gflops;
+            if(g > e.gflops)
+            {
+                e.gflops   = g;
+                e.solution = j;
+            }
+        }
+        e.gflops *= std::exp(noise(gen));
+        f.exact.push_back(e);
+    }
+    return f;
+}
+
+TEST_CASE(synthetic_ranking)
+{
+    auto path = temp_path("synthetic.idx");
+    miopentensile::write_logic_index(
+        {synthetic_logic({32, 64, 128, 256}, {32, 64, 128}, {1, 4}, 500)}, path);
+    {
+        miopentensile::logic_index index{path};
+        auto r = held_out_ranking(index, 0, reference_device);
+        std::cout << "Held out sizes: " << r.sizes << ", top 1: " << r.top1
+                  << ", top 5: " << r.top5 << std::endl;
+        EXPECT(r.sizes == 100u);
+        EXPECT(r.top1 >= 70u);
+        EXPECT(r.top5 >= 95u);
+
+        // The fit recovers the rates that decide the ranking
+        auto truth  = true_params();
+        auto params = miopentensile::calibrate_cost_model(
+            index, 0, reference_device, [](auto&&) { return true; });
+        EXPECT(std::abs(std::log(params.flops_per_cycle / truth.flops_per_cycle)) < 0.2);
+        EXPECT(std::abs(std::log(params.bytes_per_cycle / truth.bytes_per_cycle)) < 0.3);
+
+        // The same fit is stored in the index when it is compiled
+        miopentensile::cost_params stored;
+        EXPECT(not miopentensile::logic_cost_params(index, 0, stored));
+        miopentensile::write_logic_costs(path, miopentensile::calibrate_logic_index(index));
+        miopentensile::logic_index calibrated{path};
+        EXPECT(miopentensile::logic_cost_params(calibrated, 0, stored));
+        EXPECT(stored.flops_per_cycle == params.flops_per_cycle);
+        EXPECT(stored.bytes_per_cycle == params.bytes_per_cycle);
+        EXPECT(stored.wave_cycles == params.wave_cycles);
+        EXPECT(stored.vector_cost == params.vector_cost);
+        EXPECT(stored.read_cost == params.read_cost);
+        EXPECT(calibrated.entry_count() == index.entry_count());
+    }
+    std::remove(path.c_str());
+    rmdir(path.substr(0, path.rfind('/')).c_str());
+}
+
+miopentensile::problem_key make_key(std::size_t m, std::size_t n, std::size_t k)
+{
+    miopentensile::problem_key key;
+    key.m     = m;
+    key.n     = n;
+    key.k     = k;
+    key.batch = 1;
+    return key;
+}
+
+TEST_CASE(cu_count_ranking)
+{
+    // Solutions are picked for the cus the gemm may use. The logic tuned for
+    // efficiency per cu only competes on part of the device.
+    auto path = temp_path("cu_count.idx");
+    miopentensile::write_logic_index(
+        {synthetic_logic({32, 64, 128, 256}, {32, 64, 128}, {1, 4}, 200),
+         synthetic_logic({16, 32}, {16, 32}, {1}, 50, true)},
+        path);
+    auto whole = miopentensile::fake_hardware_provider("gfx908", 120)->create_hardware(0);
+    auto part  = miopentensile::with_cu_count(whole, 8);
+    EXPECT(miopentensile::hardware_cu_count(*part) == 8u);
+    auto key = make_key(128, 256, 1024);
+    {
+        // Nothing is ranked until the index is calibrated
+        miopentensile::logic_index index{path};
+        EXPECT(miopentensile::rank_logic_solutions(index, "gfx908", key, *whole).empty());
+        miopentensile::write_logic_costs(path, miopentensile::calibrate_logic_index(index));
+    }
+    {
+        miopentensile::logic_index index{path};
+        auto first = [&](const miopentensile::problem_key& k, const Tensile::Hardware& hw) {
+            auto r = miopentensile::rank_logic_solutions(index, "gfx908", k, hw);
+            return r.empty() ? std::string() : std::string(index.string(r.front().solution->name));
+        };
+        auto on_whole = first(key, *whole);
+        key.cu_count  = 8;
+        auto on_part  = first(key, *part);
+        std::cout << "120 cus: " << on_whole << ", 8 cus: " << on_part << std::endl;
+        EXPECT(not on_whole.empty());
+        EXPECT(not on_part.empty());
+        EXPECT(on_whole != on_part);
+
+        auto count_variant = [&](const miopentensile::problem_key& k) {
+            auto r = miopentensile::rank_logic_solutions(index, "gfx908", k, *part);
+            return std::count_if(r.begin(), r.end(), [&](auto&& x) {
+                return std::string(index.string(x.solution->name)).compare(0, 3, "CU_") == 0;
+            });
+        };
+        EXPECT(count_variant(key) == 4);
+        key.cu_count = 0;
+        EXPECT(count_variant(key) == 0);
+    }
+    std::remove(path.c_str());
+    rmdir(path.substr(0, path.rfind('/')).c_str());
+}
+
+TEST_CASE(installed_ranking)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    const auto& index = *miopentensile::library_index(arch);
+    auto device       = miopentensile::default_device_params(arch);
+    ranking_result total;
+    for(std::size_t type = 0; type < index.type_count(); type++)
+    {
+        const auto& t = index.type(type);
+        miopen_tensile_type input;
+        if(t.cu_efficiency or t.entry_count < 100 or t.solution_count < 10 or
+           not miopentensile::logic_input_type(t, input))
+            continue;
+        auto r = held_out_ranking(index, type, device);
+        std::cout << index.string(t.operation) << ": " << r.sizes << " sizes, top 1: " << r.top1
+                  << ", top 5: " << r.top5 << ", random top 5: " << r.chance5
+                  << ", closest size: " << r.nearest << std::endl;
+        total.add(r);
+    }
+    if(total.sizes == 0)
+        return;
+    std::cout << "Table winner ranked first for " << total.top1 << " of " << total.sizes
+              << " sizes, the winner of the closest size for " << total.nearest << std::endl;
+    // Far better than a random order of the solutions
+    EXPECT(total.top1 > 2 * total.chance1);
+    EXPECT(total.top5 > 1.5 * total.chance5);
+    // But worse than the closest size, which is why selection does not use
+    // the model
+    EXPECT(total.nearest > total.top1);
+
+    // The compiled index carries the fit of every type with enough entries
+    for(std::size_t type = 0; type < index.type_count(); type++)
+    {
+        miopentensile::cost_params params;
+        if(index.type(type).entry_count >= 16)
+            EXPECT(miopentensile::logic_cost_params(index, type, params));
+    }
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
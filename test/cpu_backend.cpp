@@ -0,0 +1,260 @@
+#include <miopentensile/gemm.h>
+#include <thread>
+#include "cpu_gemm.hpp"
+#include "test.hpp"
+
+// Runs the gemm api on the cpu backend with host buffers, so no gpu is
+// needed, and compares with the reference the gpu tests use.
+
+using mitensile::bfloat16;
+using mitensile::half;
+using mitensile::int8x4;
+using mitensile::shape;
+
+template<class T>
+miopen_tensile_type type_of();
+
+template<>
+miopen_tensile_type type_of<float>() { return miopen_tensile_type_float; }
+
+template<>
+miopen_tensile_type type_of<half>() { return miopen_tensile_type_half; }
+
+template<>
+miopen_tensile_type type_of<bfloat16>() { return miopen_tensile_type_bfloat16; }
+
+template<>
+miopen_tensile_type type_of<int8x4>() { return miopen_tensile_type_int8x4; }
+
+template<>
+miopen_tensile_type type_of<std::int32_t>() { return miopen_tensile_type_int32; }
+
+miopen_tensile_matrix to_matrix(const shape& s, miopen_tensile_type type, const void* data)
+{
+    miopen_tensile_matrix m{};
+    auto n       = s.lens.size();
+    m.lens[0]    = s.lens[n - 2];
+    m.lens[1]    = s.lens[n - 1];
+    m.strides[0] = s.strides[n - 2];
+    m.strides[1] = s.strides[n - 1];
+    if(n == 3)
+        m.batch = miopen_tensile_batch{s.lens[0], s.strides[0]};
+    m.type = type;
+    m.data = const_cast<void*>(data);
+    return m;
+}
+
+// Uses the cpu backend until destroyed
+struct cpu_backend_scope
+{
+    miopen_tensile_backend previous = miopen_tensile_backend_hip;
+    cpu_backend_scope()
+    {
+        miopen_tensile_get_backend(&previous);
+        miopen_tensile_set_backend(miopen_tensile_backend_cpu);
+    }
+    ~cpu_backend_scope() { miopen_tensile_set_backend(previous); }
+};
+
+// Int8x4 matrices are given to the api in bytes and to the reference in
+// packed elements
+template<class T, class Out = T>
+void verify_cpu_backend(shape as, shape bs, shape cs)
+{
+    auto lanes = mitensile::element_lanes<T>{};
+    auto p     = mitensile::problem<T, Out>::generate(as.step(-1, lanes), bs.step(-2, lanes), cs);
+    // Values the gemm has to overwrite, as beta is zero, and that stay
+    // between the rows and batches
+    p.c           = mitensile::fill<Out>(cs.element_space(), 5);
+    auto expected = mitensile::cpu_gemm(p);
+    auto c        = p.c;
+    auto a_mat    = to_matrix(as, type_of<T>(), p.a.data());
+    auto b_mat    = to_matrix(bs, type_of<T>(), p.b.data());
+    auto c_mat    = to_matrix(cs, type_of<Out>(), c.data());
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a_mat, &b_mat, &c_mat, 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    EXPECT(c == expected);
+}
+
+void verify_cpu_backend(shape as, shape bs, shape cs)
+{
+    verify_cpu_backend<float>(as, bs, cs);
+    verify_cpu_backend<half>(as, bs, cs);
+    verify_cpu_backend<bfloat16>(as, bs, cs);
+    verify_cpu_backend<int8x4, std::int32_t>(as, bs, cs);
+}
+
+shape mat(std::size_t batch, std::size_t rows, std::size_t cols, bool transposed = false)
+{
+    if(transposed)
+        std::swap(rows, cols);
+    auto s = batch == 1 ? shape::from_lens({rows, cols}) : shape::from_lens({batch, rows, cols});
+    return transposed ? s.transpose() : s;
+}
+
+TEST_CASE(cpu_backend_gemm)
+{
+    cpu_backend_scope scope;
+    for(bool ta : {false, true})
+    {
+        for(bool tb : {false, true})
+        {
+            verify_cpu_backend(mat(1, 36, 52, ta), mat(1, 52, 28, tb), mat(1, 36, 28));
+            verify_cpu_backend(mat(3, 37, 64, ta), mat(3, 64, 53, tb), mat(3, 37, 53));
+        }
+    }
+    // Crosses the blocks of c and of k
+    verify_cpu_backend(mat(1, 131, 520), mat(1, 520, 300, true), mat(1, 131, 300));
+    // Padded rows and batches
+    auto padded = [](shape s, std::vector<std::size_t> strides) {
+        s.strides = std::move(strides);
+        return s;
+    };
+    verify_cpu_backend(padded(mat(2, 9, 8), {120, 12, 1}),
+                       padded(mat(2, 8, 11), {100, 16, 1}),
+                       padded(mat(2, 9, 11), {110, 12, 1}));
+}
+
+TEST_CASE(cpu_backend_threads)
+{
+    cpu_backend_scope scope;
+    // Gemms from several threads at once, which share the threads of the
+    // backend or run alone while another one uses them
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([] {
+            for(int i = 0; i < 4; i++)
+                verify_cpu_backend<float>(mat(2, 131, 300), mat(2, 300, 270), mat(2, 131, 270));
+        });
+    }
+    for(auto&& t : threads)
+        t.join();
+}
+
+TEST_CASE(cpu_backend_scalars)
+{
+    cpu_backend_scope scope;
+    auto p        = mitensile::problem<float>::generate(
+        mat(1, 20, 12), mat(1, 12, 18), mat(1, 20, 18));
+    auto expected = mitensile::cpu_gemm(p);
+    auto c        = mitensile::generate<float>(p.cs.element_space(), 3);
+    auto start    = c;
+    auto a        = to_matrix(p.as, miopen_tensile_type_float, p.a.data());
+    auto b        = to_matrix(p.bs, miopen_tensile_type_float, p.b.data());
+    auto cm       = to_matrix(p.cs, miopen_tensile_type_float, c.data());
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &cm, 2.0, 3.0) ==
+           miopen_tensile_status_success);
+    for(std::size_t i = 0; i < c.size(); i++)
+        EXPECT(c[i] == 2 * expected[i] + 3 * start[i]);
+}
+
+TEST_CASE(cpu_backend_api)
+{
+    cpu_backend_scope scope;
+    miopen_tensile_backend backend = miopen_tensile_backend_hip;
+    EXPECT(miopen_tensile_get_backend(&backend) == miopen_tensile_status_success);
+    EXPECT(backend == miopen_tensile_backend_cpu);
+
+    auto p        = mitensile::problem<float>::generate(
+        mat(1, 16, 8), mat(1, 8, 24), mat(1, 16, 24));
+    auto expected = mitensile::cpu_gemm(p);
+    auto a        = to_matrix(p.as, miopen_tensile_type_float, p.a.data());
+    auto b        = to_matrix(p.bs, miopen_tensile_type_float, p.b.data());
+    auto c        = to_matrix(p.cs, miopen_tensile_type_float, nullptr);
+
+    // Plans
+    std::vector<float> out(p.c.size());
+    miopen_tensile_gemm_plan plan = nullptr;
+    EXPECT(miopen_tensile_gemm_plan_create(&plan, &a, &b, &c) == miopen_tensile_status_success);
+    EXPECT(miopen_tensile_gemm_plan_execute(
+               plan, nullptr, p.a.data(), p.b.data(), out.data(), 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    EXPECT(out == expected);
+    double gflops = -1;
+    EXPECT(miopen_tensile_gemm_plan_get_expected_gflops(plan, &gflops) ==
+           miopen_tensile_status_success);
+    EXPECT(gflops == 0.0);
+    EXPECT(miopen_tensile_gemm_plan_destroy(plan) == miopen_tensile_status_success);
+
+    // Plans for a beta of zero only run with that beta
+    EXPECT(miopen_tensile_gemm_plan_create_for_beta(&plan, &a, &b, &c, 0.0, 0) ==
+           miopen_tensile_status_success);
+    EXPECT(miopen_tensile_gemm_plan_execute(
+               plan, nullptr, p.a.data(), p.b.data(), out.data(), 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    EXPECT(out == expected);
+    EXPECT(miopen_tensile_gemm_plan_execute(
+               plan, nullptr, p.a.data(), p.b.data(), out.data(), 1.0, 1.0) ==
+           miopen_tensile_status_unknown);
+    EXPECT(miopen_tensile_gemm_plan_destroy(plan) == miopen_tensile_status_success);
+
+    // Pointer arrays in host memory
+    std::vector<std::vector<float>> outs(3, std::vector<float>(p.c.size()));
+    std::vector<const void*> a_ptrs(3, p.a.data());
+    std::vector<const void*> b_ptrs(3, p.b.data());
+    std::vector<void*> c_ptrs;
+    for(auto&& x : outs)
+        c_ptrs.push_back(x.data());
+    EXPECT(miopen_tensile_gemm_batched_hip(
+               nullptr, &a, &b, &c, a_ptrs.data(), b_ptrs.data(), c_ptrs.data(), 3, 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    for(auto&& x : outs)
+        EXPECT(x == expected);
+
+    // Groups
+    std::fill(out.begin(), out.end(), 0.0f);
+    c.data = out.data();
+    miopen_tensile_gemm_desc desc{a, b, c, 1.0, 0.0};
+    EXPECT(miopen_tensile_gemm_grouped_hip(nullptr, &desc, 1) == miopen_tensile_status_success);
+    EXPECT(out == expected);
+    EXPECT(miopen_tensile_warmup(&desc, 1) == miopen_tensile_status_success);
+
+    // The single solution
+    std::size_t workspace = 1;
+    EXPECT(miopen_tensile_gemm_get_workspace_size(&a, &b, &c, 0.0, &workspace) ==
+           miopen_tensile_status_success);
+    EXPECT(workspace == 0u);
+    miopen_tensile_solution_info info{};
+    std::size_t count = 0;
+    EXPECT(miopen_tensile_gemm_find_solutions(&a, &b, &c, 0.0, &info, 1, &count) ==
+           miopen_tensile_status_success);
+    EXPECT(count == 1u);
+    EXPECT(info.id != 0u);
+    std::fill(out.begin(), out.end(), 0.0f);
+    EXPECT(miopen_tensile_gemm_solution_hip(nullptr, &a, &b, &c, 1.0, 0.0, info.id, nullptr, 0) ==
+           miopen_tensile_status_success);
+    EXPECT(out == expected);
+    EXPECT(miopen_tensile_gemm_solution_hip(
+               nullptr, &a, &b, &c, 1.0, 0.0, info.id + 1, nullptr, 0) ==
+           miopen_tensile_status_no_solution);
+}
+
+TEST_CASE(cpu_backend_errors)
+{
+    cpu_backend_scope scope;
+    auto a = to_matrix(mat(1, 16, 8), miopen_tensile_type_float, nullptr);
+    auto b = to_matrix(mat(1, 8, 24), miopen_tensile_type_float, nullptr);
+    auto c = to_matrix(mat(1, 16, 20), miopen_tensile_type_float, nullptr);
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 0.0) ==
+           miopen_tensile_status_unknown);
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, nullptr, 1.0, 0.0) ==
+           miopen_tensile_status_unknown);
+
+    c = to_matrix(mat(1, 16, 24), miopen_tensile_type_half, nullptr);
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 0.0) ==
+           miopen_tensile_status_no_solution);
+    miopen_tensile_gemm_desc desc{a, b, c, 1.0, 0.0};
+    EXPECT(miopen_tensile_warmup(&desc, 1) == miopen_tensile_status_no_solution);
+
+    // K is not a multiple of 4
+    a = to_matrix(mat(1, 16, 6), miopen_tensile_type_int8x4, nullptr);
+    b = to_matrix(mat(1, 6, 24), miopen_tensile_type_int8x4, nullptr);
+    c = to_matrix(mat(1, 16, 24), miopen_tensile_type_int32, nullptr);
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 0.0) ==
+           miopen_tensile_status_no_solution);
+    EXPECT(miopen_tensile_set_backend(miopen_tensile_backend(7)) ==
+           miopen_tensile_status_unknown);
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
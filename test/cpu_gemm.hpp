@@ -0,0 +1,494 @@
+#ifndef MIOPEN_TENSILE_GUARD_CPU_GEMM_HPP
+#define MIOPEN_TENSILE_GUARD_CPU_GEMM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <half.hpp>
+#include "array.hpp"
+
+namespace mitensile {
+
+using int8x4 = array<std::int8_t, 4>;
+using doublex4 = array<double, 4>;
+using half = half_float::half;
+
+// Brain float with the rounding of the conversions on the gpu: to nearest, ties
+// to even
+struct bfloat16
+{
+    std::uint16_t bits = 0;
+    bfloat16() = default;
+    explicit bfloat16(float x)
+    {
+        std::uint32_t u;
+        std::memcpy(&u, &x, sizeof(u));
+        if(std::isnan(x))
+            bits = 0x7fc0;
+        else
+            bits = std::uint16_t((u + 0x7fff + ((u >> 16) & 1)) >> 16);
+    }
+    operator float() const
+    {
+        std::uint32_t u = std::uint32_t(bits) << 16;
+        float x;
+        std::memcpy(&x, &u, sizeof(x));
+        return x;
+    }
+    friend bool operator==(bfloat16 x, bfloat16 y) { return x.bits == y.bits; }
+    friend bool operator!=(bfloat16 x, bfloat16 y) { return x.bits != y.bits; }
+};
+
+// Multidimensional for loop
+inline auto dfor()
+{
+    return [](auto f) { f(); };
+}
+
+template <class T, class... Ts>
+auto dfor(T x, Ts... xs)
+{
+    return [=](auto f) {
+        for(T i = 0; i < x; i++)
+        {
+            dfor(xs...)([&](Ts... is) { f(i, is...); });
+        }
+    };
+}
+
+template<class T>
+T increment(T start, int max)
+{
+    return T(start > max ? 1 : start + 1);
+}
+
+inline int8x4 increment(int8x4 start, int max)
+{
+    int8x4 result = start;
+    for(std::size_t i = 0;i < 4;i++)
+    {
+        result[i] = start[i] > max ? 1 : start[i] + 1;
+    }
+    return result;
+}
+
+template<class T, class U>
+std::vector<T> generate(std::size_t sz, U pstart)
+{
+    auto start = T(pstart);
+    std::vector<T> result(sz);
+    std::generate(result.begin(), result.end(), [&] {
+        T r = start;
+        start = increment(start, 6);
+        return r;
+    });
+    return result;
+}
+
+template<class T, class U>
+std::vector<T> fill(std::size_t sz, U pvalue)
+{
+    auto value = T(pvalue);
+    std::vector<T> result(sz);
+    std::fill(result.begin(), result.end(), value);
+    return result;
+}
+
+template <class Iterator>
+inline std::string to_string_range(Iterator start, Iterator last)
+{
+    std::stringstream ss;
+    if(start != last)
+    {
+        ss << *start;
+        std::for_each(std::next(start), last, [&](auto&& x) { ss << ", " << x; });
+    }
+    return ss.str();
+}
+
+struct shape
+{
+    std::vector<std::size_t> lens;
+    std::vector<std::size_t> strides;
+    void calculate_strides()
+    {
+        strides.clear();
+        strides.resize(lens.size(), 0);
+        if(strides.empty())
+            return;
+        strides.back() = 1;
+        std::partial_sum(lens.rbegin(),
+                         lens.rend() - 1,
+                         strides.rbegin() + 1,
+                         std::multiplies<std::size_t>());
+    }
+
+    std::size_t element_space() const
+    {
+        assert(lens.size() == strides.size());
+        if(lens.empty())
+            return 0;
+        return std::inner_product(lens.begin(),
+                                  lens.end(),
+                                  strides.begin(),
+                                  std::size_t{0},
+                                  std::plus<std::size_t>{},
+                                  [](std::size_t l, std::size_t s) { return (l - 1) * s; }) +
+               1;
+    }
+
+    std::size_t elements() const
+    {
+        assert(lens.size() == strides.size());
+        if(lens.empty())
+            return 0;
+        return std::accumulate(
+            lens.begin(), lens.end(), std::size_t{1}, std::multiplies<std::size_t>());
+    }
+
+    std::size_t index(const std::vector<std::size_t>& l) const
+    {
+        assert(l.size() <= this->lens.size());
+        assert(this->lens.size() == this->strides.size());
+        return std::inner_product(l.begin(), l.end(), this->strides.begin(), std::size_t{0});
+    }
+    std::size_t index_ik(std::vector<std::size_t> l, std::size_t k) const
+    {
+        l.back() = k;
+        return this->index(l);
+    }
+
+    std::size_t index_kj(std::vector<std::size_t> l, std::size_t k) const
+    {
+        l.at(l.size() - 2) = k;
+        return this->index(l);
+    }
+
+    shape transpose() const
+    {
+        assert(lens.size() == strides.size());
+        shape r = *this;
+        if (r.lens.size() > 1) 
+        {
+            std::reverse(r.lens.end()-2, r.lens.end());
+            std::reverse(r.strides.end()-2, r.strides.end());
+        }
+        return r;
+    }
+
+    shape step(int axis, int step) const
+    {
+        if (axis < 0)
+            return this->step(lens.size() + axis, step);
+        shape r = *this;
+        r.lens[axis] /= step;
+        for(auto&& stride:r.strides)
+        {
+            if (stride > r.strides[axis])
+                stride /= step;
+        }
+        return r;
+    }
+
+    template<class T>
+    std::vector<T> generate(std::size_t seed=0) const
+    {
+        return mitensile::generate<T>(element_space(), seed);
+    }
+
+    template<class T>
+    std::vector<T> fill(std::size_t x=0) const
+    {
+        return mitensile::fill<T>(element_space(), x);
+    }
+
+    static shape from_lens(std::vector<std::size_t> l)
+    {
+        shape r;
+        r.lens = l;
+        r.calculate_strides();
+        return r;
+    }
+
+    template <class F>
+    void for_each(F f)
+    {
+        assert(lens.size() == strides.size());
+        // Ensure calls to f use const ref to vector
+        auto call = [&f](const std::vector<std::size_t>& i) { f(i); };
+        std::vector<std::size_t> indices(lens.size());
+        shape ss = from_lens(lens);
+        for(std::size_t i = 0; i < ss.elements(); i++)
+        {
+            std::transform(ss.strides.begin(),
+                           ss.strides.end(),
+                           ss.lens.begin(),
+                           indices.begin(),
+                           [&](std::size_t stride, std::size_t len) {
+                               assert(len > 0 and stride > 0);
+                               return (i / stride) % len;
+                           });
+            call(indices);
+        }
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const shape& x)
+    {
+        os << "{" << to_string_range(x.lens.begin(), x.lens.end()) << "}, ";
+        os << "{" << to_string_range(x.strides.begin(), x.strides.end()) << "}";
+        return os;
+    }
+
+};
+
+template<class R>
+auto shape_with(const shape& s, R&& x)
+{
+    return [&](std::size_t i, std::size_t j) -> auto& {
+        return x[s.index({i, j})];
+    };
+}
+
+template<class T, class Out = T>
+struct problem
+{
+    static problem generate(shape as, shape bs, shape cs)
+    {
+        problem result;
+        result.as = as;
+        result.bs = bs;
+        result.cs = cs;
+        result.a = as.generate<T>(1);
+        result.b = bs.generate<T>(2);
+        result.c = cs.fill<Out>(0);
+        return result;
+    }
+    shape as;
+    shape bs;
+    shape cs;
+    std::vector<T> a;
+    std::vector<T> b;
+    std::vector<Out> c;
+};
+
+template<class T, class U>
+double product(T x, U y)
+{
+    return double(x)*double(y);
+}
+
+template<class T, class U, std::size_t N>
+double product(const array<T, N>& x, const array<U, N>& y)
+{
+    using R = array<double, N>;
+    return (R(x)*R(y)).sum();
+}
+
+// Element by element reference, only fast enough for small problems. Kept to
+// check cpu_gemm against.
+template<class T, class Out = T>
+std::vector<Out> naive_gemm(problem<T, Out> p)
+{
+    auto k = p.as.lens.back();
+    p.cs.for_each([&](auto idx) {
+        double x = 0.0;
+        dfor(k)([&](int kk) { 
+            // x += a(i, kk) * b(kk, j); 
+            x += product(p.a[p.as.index_ik(idx, kk)], p.b[p.bs.index_kj(idx, kk)]); 
+        });
+        p.c[p.cs.index(idx)] = Out(x);
+    });
+    return p.c;
+}
+
+// Runs f for each index below n on every hardware thread
+template <class F>
+void parallel_for(std::size_t n, F f)
+{
+    std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    threads             = std::min(threads, n);
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+        for(auto i = next++; i < n; i = next++)
+            f(i);
+    };
+    std::vector<std::thread> workers;
+    for(std::size_t t = 1; t < threads; t++)
+        workers.emplace_back(work);
+    work();
+    for(auto&& w : workers)
+        w.join();
+}
+
+// Values packed in one element along k, ie 4 for int8x4
+template <class T>
+struct element_lanes : std::integral_constant<std::size_t, 1>
+{
+};
+
+template <class T, std::size_t N>
+struct element_lanes<array<T, N>> : std::integral_constant<std::size_t, N>
+{
+};
+
+template <class T>
+double lane(const T& x, std::size_t)
+{
+    return double(x);
+}
+
+template <class T, std::size_t N>
+double lane(const array<T, N>& x, std::size_t i)
+{
+    return double(x[i]);
+}
+
+// A matrix shape of 2 or 3 dimensions as batch, rows and columns
+struct matrix_view
+{
+    std::size_t batch        = 1;
+    std::size_t rows         = 0;
+    std::size_t cols         = 0;
+    std::size_t batch_stride = 0;
+    std::size_t row_stride   = 0;
+    std::size_t col_stride   = 0;
+
+    explicit matrix_view(const shape& s)
+    {
+        assert(s.lens.size() == 2 or s.lens.size() == 3);
+        auto n = s.lens.size();
+        if(n == 3)
+        {
+            batch        = s.lens[0];
+            batch_stride = s.strides[0];
+        }
+        rows       = s.lens[n - 2];
+        cols       = s.lens[n - 1];
+        row_stride = s.strides[n - 2];
+        col_stride = s.strides[n - 1];
+    }
+
+    std::size_t index(std::size_t b, std::size_t i, std::size_t j) const
+    {
+        return b * batch_stride + i * row_stride + j * col_stride;
+    }
+};
+
+// Multiplies rows [i, i + R) of the packed a with the packed b into the R
+// rows of acc, over columns [0, cols) and depths [k0, k1). The loop over
+// the columns of a row of b is contiguous, so the compiler vectorizes it.
+template <std::size_t R>
+void gemm_rows(const double* a,
+               const double* b,
+               double* acc,
+               std::size_t lda,
+               std::size_t ldb,
+               std::size_t ldacc,
+               std::size_t cols,
+               std::size_t k0,
+               std::size_t k1)
+{
+    for(std::size_t kk = k0; kk < k1; kk++)
+    {
+        const double* brow = b + kk * ldb;
+        double x[R];
+        for(std::size_t r = 0; r < R; r++)
+            x[r] = a[r * lda + kk];
+        for(std::size_t r = 0; r < R; r++)
+        {
+            double* c = acc + r * ldacc;
+            for(std::size_t j = 0; j < cols; j++)
+                c[j] += x[r] * brow[j];
+        }
+    }
+}
+
+// Reference gemm for problems of the size run on the gpu. a and b are
+// converted once to contiguous doubles, with packed elements spread along k,
+// and c is computed in tiles on all threads, blocked over k so the rows of b
+// used by a tile stay in cache. Sums of products of the small integers the
+// tests generate are exact in double, so the result does not depend on the
+// order of the sums.
+template<class T, class Out = T>
+std::vector<Out> cpu_gemm(const problem<T, Out>& p)
+{
+    const std::size_t tile_rows = 64;
+    const std::size_t tile_cols = 256;
+    const std::size_t depth     = 256;
+    const std::size_t lanes     = element_lanes<T>{};
+
+    matrix_view av{p.as};
+    matrix_view bv{p.bs};
+    matrix_view cv{p.cs};
+    auto batch = cv.batch;
+    auto m     = cv.rows;
+    auto n     = cv.cols;
+    auto k     = av.cols * lanes;
+    assert(av.rows == m and bv.cols == n and bv.rows * lanes == k);
+
+    // a as batch x m x k and b as batch x k x n, row major
+    std::vector<double> a(batch * m * k);
+    std::vector<double> b(batch * k * n);
+    parallel_for(batch * m, [&](std::size_t bi) {
+        auto bb = bi / m;
+        auto i  = bi % m;
+        for(std::size_t kk = 0; kk < av.cols; kk++)
+        {
+            const auto& x = p.a[av.index(av.batch == 1 ? 0 : bb, i, kk)];
+            for(std::size_t l = 0; l < lanes; l++)
+                a[(bb * m + i) * k + kk * lanes + l] = lane(x, l);
+        }
+    });
+    parallel_for(batch * bv.rows, [&](std::size_t bk) {
+        auto bb = bk / bv.rows;
+        auto kk = bk % bv.rows;
+        for(std::size_t j = 0; j < n; j++)
+        {
+            const auto& x = p.b[bv.index(bv.batch == 1 ? 0 : bb, kk, j)];
+            for(std::size_t l = 0; l < lanes; l++)
+                b[(bb * k + kk * lanes + l) * n + j] = lane(x, l);
+        }
+    });
+
+    auto result    = p.c;
+    auto row_tiles = (m + tile_rows - 1) / tile_rows;
+    auto col_tiles = (n + tile_cols - 1) / tile_cols;
+    parallel_for(batch * row_tiles * col_tiles, [&](std::size_t t) {
+        auto bb   = t / (row_tiles * col_tiles);
+        auto i0   = (t / col_tiles) % row_tiles * tile_rows;
+        auto j0   = t % col_tiles * tile_cols;
+        auto rows = std::min(tile_rows, m - i0);
+        auto cols = std::min(tile_cols, n - j0);
+        std::vector<double> acc(rows * tile_cols, 0.0);
+        const double* ap = a.data() + (bb * m + i0) * k;
+        const double* bp = b.data() + bb * k * n + j0;
+        for(std::size_t k0 = 0; k0 < k; k0 += depth)
+        {
+            auto k1       = std::min(k0 + depth, k);
+            std::size_t i = 0;
+            for(; i + 4 <= rows; i += 4)
+                gemm_rows<4>(ap + i * k, bp, &acc[i * tile_cols], k, n, tile_cols, cols, k0, k1);
+            for(; i < rows; i++)
+                gemm_rows<1>(ap + i * k, bp, &acc[i * tile_cols], k, n, tile_cols, cols, k0, k1);
+        }
+        for(std::size_t i = 0; i < rows; i++)
+        {
+            for(std::size_t j = 0; j < cols; j++)
+                result[cv.index(bb, i0 + i, j0 + j)] = Out(acc[i * tile_cols + j]);
+        }
+    });
+    return result;
+}
+
+} // namespace mitensile
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MIOPEN_TENSILE_GUARD_FIXTURES_HPP
+#define MIOPEN_TENSILE_GUARD_FIXTURES_HPP
+
+#include <miopentensile/gemm.h>
+#include <miopentensile/library.hpp>
+#include <exception>
+#include <string>
+
+namespace mitensile {
+
+// The first architecture with a library installed, or empty if there is none
+inline std::string installed_arch()
+{
+    for(auto&& arch : {"gfx908", "gfx90a", "gfx906", "gfx900", "gfx1030", "gfx803"})
+    {
+        try
+        {
+            if(miopentensile::library_index(arch) != nullptr)
+                return arch;
+        }
+        catch(const std::exception&)
+        {
+        }
+    }
+    return "";
+}
+
+// A packed row major matrix without data
+inline miopen_tensile_matrix make_matrix(std::size_t rows,
+                                         std::size_t cols,
+                                         miopen_tensile_type type = miopen_tensile_type_float)
+{
+    return miopen_tensile_matrix{{rows, cols}, {cols, 1}, {0, 0}, type, nullptr};
+}
+
+} // namespace mitensile
+
+#endif
@@ -1,280 +1,15 @@
 #include <miopentensile/gemm.h>
 #include <algorithm>
+#include <array>
 #include <numeric>
 #include <set>
 #include <sstream>
-#include <half.hpp>
+#include "cpu_gemm.hpp"
 #include "hip.hpp"
-#include "array.hpp"
 #include "test.hpp"
 
 namespace mitensile {
 
-
-using int8x4 = array<std::int8_t, 4>;
-using doublex4 = array<double, 4>;
-using half = half_float::half;
-
-// Multidimensional for loop
-inline auto dfor()
-{
-    return [](auto f) { f(); };
-}
-
-template <class T, class... Ts>
-auto dfor(T x, Ts... xs)
-{
-    return [=](auto f) {
-        for(T i = 0; i < x; i++)
-        {
-            dfor(xs...)([&](Ts... is) { f(i, is...); });
-        }
-    };
-}
-
-template<class T>
-T increment(T start, int max)
-{
-    return T(start > max ? 1 : start + 1);
-}
-
-int8x4 increment(int8x4 start, int max)
-{
-    int8x4 result = start;
-    for(std::size_t i = 0;i < 4;i++)
-    {
-        result[i] = start[i] > max ? 1 : start[i] + 1;
-    }
-    return result;
-}
-
-template<class T, class U>
-std::vector<T> generate(std::size_t sz, U pstart)
-{
-    auto start = T(pstart);
-    std::vector<T> result(sz);
-    std::generate(result.begin(), result.end(), [&] {
-        T r = start;
-        start = increment(start, 6);
-        return r;
-    });
-    return result;
-}
-
-template<class T, class U>
-std::vector<T> fill(std::size_t sz, U pvalue)
-{
-    auto value = T(pvalue);
-    std::vector<T> result(sz);
-    std::fill(result.begin(), result.end(), value);
-    return result;
-}
-
-template <class Iterator>
-inline std::string to_string_range(Iterator start, Iterator last)
-{
-    std::stringstream ss;
-    if(start != last)
-    {
-        ss << *start;
-        std::for_each(std::next(start), last, [&](auto&& x) { ss << ", " << x; });
-    }
-    return ss.str();
-}
-
-struct shape
-{
-    std::vector<std::size_t> lens;
-    std::vector<std::size_t> strides;
-    void calculate_strides()
-    {
-        strides.clear();
-        strides.resize(lens.size(), 0);
-        if(strides.empty())
-            return;
-        strides.back() = 1;
-        std::partial_sum(lens.rbegin(),
-                         lens.rend() - 1,
-                         strides.rbegin() + 1,
-                         std::multiplies<std::size_t>());
-    }
-
-    std::size_t element_space() const
-    {
-        assert(lens.size() == strides.size());
-        if(lens.empty())
-            return 0;
-        return std::inner_product(lens.begin(),
-                                  lens.end(),
-                                  strides.begin(),
-                                  std::size_t{0},
-                                  std::plus<std::size_t>{},
-                                  [](std::size_t l, std::size_t s) { return (l - 1) * s; }) +
-               1;
-    }
-
-    std::size_t elements() const
-    {
-        assert(lens.size() == strides.size());
-        if(lens.empty())
-            return 0;
-        return std::accumulate(
-            lens.begin(), lens.end(), std::size_t{1}, std::multiplies<std::size_t>());
-    }
-
-    std::size_t index(const std::vector<std::size_t>& l) const
-    {
-        assert(l.size() <= this->lens.size());
-        assert(this->lens.size() == this->strides.size());
-        return std::inner_product(l.begin(), l.end(), this->strides.begin(), std::size_t{0});
-    }
-    std::size_t index_ik(std::vector<std::size_t> l, std::size_t k) const
-    {
-        l.back() = k;
-        return this->index(l);
-    }
-
-    std::size_t index_kj(std::vector<std::size_t> l, std::size_t k) const
-    {
-        l.at(l.size() - 2) = k;
-        return this->index(l);
-    }
-
-    shape transpose() const
-    {
-        assert(lens.size() == strides.size());
-        shape r = *this;
-        if (r.lens.size() > 1) 
-        {
-            std::reverse(r.lens.end()-2, r.lens.end());
-            std::reverse(r.strides.end()-2, r.strides.end());
-        }
-        return r;
-    }
-
-    shape step(int axis, int step) const
-    {
-        if (axis < 0)
-            return this->step(lens.size() + axis, step);
-        shape r = *this;
-        r.lens[axis] /= step;
-        for(auto&& stride:r.strides)
-        {
-            if (stride > r.strides[axis])
-                stride /= step;
-        }
-        return r;
-    }
-
-    template<class T>
-    std::vector<T> generate(std::size_t seed=0) const
-    {
-        return mitensile::generate<T>(element_space(), seed);
-    }
-
-    template<class T>
-    std::vector<T> fill(std::size_t x=0) const
-    {
-        return mitensile::fill<T>(element_space(), x);
-    }
-
-    static shape from_lens(std::vector<std::size_t> l)
-    {
-        shape r;
-        r.lens = l;
-        r.calculate_strides();
-        return r;
-    }
-
-    template <class F>
-    void for_each(F f)
-    {
-        assert(lens.size() == strides.size());
-        // Ensure calls to f use const ref to vector
-        auto call = [&f](const std::vector<std::size_t>& i) { f(i); };
-        std::vector<std::size_t> indices(lens.size());
-        shape ss = from_lens(lens);
-        for(std::size_t i = 0; i < ss.elements(); i++)
-        {
-            std::transform(ss.strides.begin(),
-                           ss.strides.end(),
-                           ss.lens.begin(),
-                           indices.begin(),
-                           [&](std::size_t stride, std::size_t len) {
-                               assert(len > 0 and stride > 0);
-                               return (i / stride) % len;
-                           });
-            call(indices);
-        }
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const shape& x)
-    {
-        os << "{" << to_string_range(x.lens.begin(), x.lens.end()) << "}, ";
-        os << "{" << to_string_range(x.strides.begin(), x.strides.end()) << "}";
-        return os;
-    }
-
-};
-
-template<class R>
-auto shape_with(const shape& s, R&& x)
-{
-    return [&](std::size_t i, std::size_t j) -> auto& {
-        return x[s.index({i, j})];
-    };
-}
-
-template<class T, class Out = T>
-struct problem
-{
-    static problem generate(shape as, shape bs, shape cs)
-    {
-        problem result;
-        result.as = as;
-        result.bs = bs;
-        result.cs = cs;
-        result.a = as.generate<T>(1);
-        result.b = bs.generate<T>(2);
-        result.c = cs.fill<Out>(0);
-        return result;
-    }
-    shape as;
-    shape bs;
-    shape cs;
-    std::vector<T> a;
-    std::vector<T> b;
-    std::vector<Out> c;
-};
-
-template<class T, class U>
-double product(T x, U y)
-{
-    return double(x)*double(y);
-}
-
-template<class T, class U, std::size_t N>
-double product(const array<T, N>& x, const array<U, N>& y)
-{
-    using R = array<double, N>;
-    return (R(x)*R(y)).sum();
-}
-
-template<class T, class Out = T>
-std::vector<Out> cpu_gemm(problem<T, Out> p)
-{
-    auto k = p.as.lens.back();
-    p.cs.for_each([&](auto idx) {
-        double x = 0.0;
-        dfor(k)([&](int kk) { 
-            // x += a(i, kk) * b(kk, j); 
-            x += product(p.a[p.as.index_ik(idx, kk)], p.b[p.bs.index_kj(idx, kk)]); 
-        });
-        p.c[p.cs.index(idx)] = x;
-    });
-    return p.c;
-}
-
 template<miopen_tensile_type N>
 using tensile_type_const = std::integral_constant<miopen_tensile_type, N>;
 
@@ -289,6 +24,10 @@ template<>
 struct get_data_type<half> : tensile_type_const<miopen_tensile_type_half>
 {};
 
+template<>
+struct get_data_type<bfloat16> : tensile_type_const<miopen_tensile_type_bfloat16>
+{};
+
 template<>
 struct get_data_type<int8x4> : tensile_type_const<miopen_tensile_type_int8x4>
 {};
@@ -326,6 +65,155 @@ std::vector<Out> gpu_gemm(const problem<T, Out>& p)
     return r;
 }
 
+template<class T, class Out = T>
+std::vector<Out> gpu_gemm_plan(const problem<T, Out>& p)
+{
+    auto a = to_gpu(p.a);
+    auto b = to_gpu(p.b);
+    auto c = to_gpu(p.c);
+    auto am = to_tensile_matrix<T>(p.as, a);
+    auto bm = to_tensile_matrix<T>(p.bs, b);
+    auto cm = to_tensile_matrix<Out>(p.cs, c);
+    am.data = nullptr;
+    bm.data = nullptr;
+    cm.data = nullptr;
+
+    miopen_tensile_gemm_plan plan = nullptr;
+    if (miopen_tensile_gemm_plan_create(&plan, &am, &bm, &cm) != miopen_tensile_status_success)
+        throw std::runtime_error("Failed to run miopen_tensile_gemm_plan_create");
+    auto stream = create_stream();
+    // Execute on two sets of buffers to check the packed arguments are
+    // replaced on each call
+    auto a2 = to_gpu(p.a);
+    auto b2 = to_gpu(p.b);
+    auto c2 = to_gpu(p.c);
+    auto e1 = miopen_tensile_gemm_plan_execute(plan, stream.get(), a2.get(), b2.get(), c2.get(), 1.0, 0.0);
+    auto e2 = miopen_tensile_gemm_plan_execute(plan, stream.get(), a.get(), b.get(), c.get(), 1.0, 0.0);
+    miopen_tensile_gemm_plan_destroy(plan);
+    if (e1 != miopen_tensile_status_success or e2 != miopen_tensile_status_success)
+        throw std::runtime_error("Failed to run miopen_tensile_gemm_plan_execute");
+    EXPECT(from_gpu<Out>(c2.get(), p.cs.element_space()) == from_gpu<Out>(c.get(), p.cs.element_space()));
+    return from_gpu<Out>(c.get(), p.cs.element_space());
+}
+
+template<class T, class Out = T>
+void verify_gemm_plan(shape as, shape bs, shape cs)
+{
+    auto p = problem<T, Out>::generate(as, bs, cs);
+    auto cpu = cpu_gemm(p);
+    auto gpu = gpu_gemm_plan(p);
+    EXPECT(cpu == gpu);
+}
+
+template<class T, class Out = T>
+std::vector<Out> gpu_gemm_workspace(const problem<T, Out>& p)
+{
+    auto a = to_gpu(p.a);
+    auto b = to_gpu(p.b);
+    auto c = to_gpu(p.c);
+    auto am = to_tensile_matrix<T>(p.as, a);
+    auto bm = to_tensile_matrix<T>(p.bs, b);
+    auto cm = to_tensile_matrix<Out>(p.cs, c);
+
+    std::size_t size = 0;
+    if (miopen_tensile_gemm_get_workspace_size(&am, &bm, &cm, 0.0, &size) != miopen_tensile_status_success)
+        throw std::runtime_error("Failed to run miopen_tensile_gemm_get_workspace_size");
+    auto workspace = allocate_gpu(std::max<std::size_t>(size, 1));
+    auto stream = create_stream();
+    auto e = miopen_tensile_gemm_workspace_hip(stream.get(), &am, &bm, &cm, 1.0, 0.0, workspace.get(), size);
+    if (e != miopen_tensile_status_success)
+        throw std::runtime_error("Failed to run miopen_tensile_gemm_workspace_hip");
+    return from_gpu<Out>(cm.data, p.cs.element_space());
+}
+
+template<class T, class Out = T>
+void verify_gemm_workspace(shape as, shape bs, shape cs)
+{
+    auto p = problem<T, Out>::generate(as, bs, cs);
+    auto cpu = cpu_gemm(p);
+    EXPECT(cpu == gpu_gemm_workspace(p));
+    // Without a workspace only solutions that need none are selected
+    EXPECT(cpu == gpu_gemm(p));
+}
+
+template<class T, class Out = T>
+void verify_gemm_batched(shape as, shape bs, shape cs, std::size_t n)
+{
+    std::vector<problem<T, Out>> ps;
+    std::vector<hip_ptr> buffers;
+    std::vector<const void*> a_ptrs;
+    std::vector<const void*> b_ptrs;
+    std::vector<void*> c_ptrs;
+    for(std::size_t i = 0; i < n; i++)
+    {
+        auto p = problem<T, Out>::generate(as, bs, cs);
+        p.a = as.generate<T>(i + 1);
+        p.b = bs.generate<T>(i + 2);
+        buffers.push_back(to_gpu(p.a));
+        a_ptrs.push_back(buffers.back().get());
+        buffers.push_back(to_gpu(p.b));
+        b_ptrs.push_back(buffers.back().get());
+        buffers.push_back(to_gpu(p.c));
+        c_ptrs.push_back(buffers.back().get());
+        ps.push_back(p);
+    }
+    auto a_dev = to_gpu(a_ptrs);
+    auto b_dev = to_gpu(b_ptrs);
+    auto c_dev = to_gpu(c_ptrs);
+    auto am = to_tensile_matrix<T>(as, a_dev);
+    auto bm = to_tensile_matrix<T>(bs, b_dev);
+    auto cm = to_tensile_matrix<Out>(cs, c_dev);
+
+    miopen_tensile_cache_stats before;
+    miopen_tensile_get_solution_cache_stats(&before);
+    auto stream = create_stream();
+    auto e = miopen_tensile_gemm_batched_hip(stream.get(),
+                                             &am,
+                                             &bm,
+                                             &cm,
+                                             static_cast<const void* const*>(a_dev.get()),
+                                             static_cast<const void* const*>(b_dev.get()),
+                                             static_cast<void* const*>(c_dev.get()),
+                                             n,
+                                             1.0,
+                                             0.0);
+    if (e != miopen_tensile_status_success)
+        throw std::runtime_error("Failed to run miopen_tensile_gemm_batched_hip");
+    for(std::size_t i = 0; i < n; i++)
+        EXPECT(cpu_gemm(ps[i]) == from_gpu<Out>(c_ptrs[i], cs.element_space()));
+    // Counted once per call, not per item
+    miopen_tensile_cache_stats after;
+    miopen_tensile_get_solution_cache_stats(&after);
+    EXPECT(after.pointer_batched_fallbacks - before.pointer_batched_fallbacks <= 1u);
+}
+
+template<class T, class Out = T>
+void verify_gemm_grouped(std::vector<std::array<shape, 3>> shapes)
+{
+    std::vector<problem<T, Out>> ps;
+    std::vector<hip_ptr> buffers;
+    std::vector<miopen_tensile_gemm_desc> descs;
+    for(auto&& s : shapes)
+    {
+        auto p = problem<T, Out>::generate(s[0], s[1], s[2]);
+        buffers.push_back(to_gpu(p.a));
+        auto am = to_tensile_matrix<T>(s[0], buffers.back());
+        buffers.push_back(to_gpu(p.b));
+        auto bm = to_tensile_matrix<T>(s[1], buffers.back());
+        buffers.push_back(to_gpu(p.c));
+        auto cm = to_tensile_matrix<Out>(s[2], buffers.back());
+        descs.push_back({am, bm, cm, 1.0, 0.0});
+        ps.push_back(p);
+    }
+
+    auto stream = create_stream();
+    auto e = miopen_tensile_gemm_grouped_hip(stream.get(), descs.data(), descs.size());
+    if (e != miopen_tensile_status_success)
+        throw std::runtime_error("Failed to run miopen_tensile_gemm_grouped_hip");
+    for(std::size_t i = 0; i < ps.size(); i++)
+        EXPECT(cpu_gemm(ps[i]) == from_gpu<Out>(descs[i].c.data, shapes[i][2].element_space()));
+}
+
 template<class T, class Out = T>
 void verify_gemm(shape as, shape bs, shape cs)
 {
@@ -367,6 +255,63 @@ shape create_mat_shape(std::vector<std::size_t> l, bool transposed = false)
         return s;
 }
 
+template<class T, class Out = T>
+void verify_cpu_gemm(shape as, shape bs, shape cs)
+{
+    auto p = problem<T, Out>::generate(as, bs, cs);
+    EXPECT(cpu_gemm(p) == naive_gemm(p));
+}
+
+void verify_cpu_gemm(shape as, shape bs, shape cs)
+{
+    verify_cpu_gemm<float>(as, bs, cs);
+    verify_cpu_gemm<half>(as, bs, cs);
+    verify_cpu_gemm<bfloat16>(as, bs, cs);
+    verify_cpu_gemm<int8x4, std::int32_t>(as.step(-1, 4), bs.step(-2, 4), cs);
+}
+
+shape with_strides(shape s, std::vector<std::size_t> strides)
+{
+    s.strides = std::move(strides);
+    return s;
+}
+
+// The reference used by the other tests against the element by element one,
+// runs without a gpu
+TEST_CASE(cpu_gemm_reference)
+{
+    // Lens of a matrix of r x c stored transposed or not
+    auto mat = [](std::size_t b, std::size_t r, std::size_t c, bool transposed) {
+        if(transposed)
+            std::swap(r, c);
+        if(b == 1)
+            return create_mat_shape({r, c}, transposed);
+        return create_mat_shape({b, r, c}, transposed);
+    };
+    for(bool ta : {false, true})
+    {
+        for(bool tb : {false, true})
+        {
+            verify_cpu_gemm(mat(1, 36, 52, ta), mat(1, 52, 28, tb), mat(1, 36, 28, false));
+            verify_cpu_gemm(mat(3, 37, 64, ta), mat(3, 64, 53, tb), mat(3, 37, 53, false));
+        }
+    }
+    // Crosses the tile and depth blocks
+    verify_cpu_gemm(mat(1, 131, 520, false), mat(1, 520, 300, true), mat(1, 131, 300, false));
+    // Padded rows and batches
+    verify_cpu_gemm(with_strides(shape::from_lens({2, 9, 8}), {120, 12, 1}),
+                    with_strides(shape::from_lens({2, 8, 11}), {100, 13, 1}),
+                    with_strides(shape::from_lens({2, 9, 11}), {110, 12, 1}));
+    // Values of c outside of the matrix are kept
+    auto p = problem<float>::generate(shape::from_lens({5, 4}),
+                                      shape::from_lens({4, 3}),
+                                      with_strides(shape::from_lens({5, 3}), {4, 1}));
+    p.c = fill<float>(p.cs.element_space(), 7);
+    auto c = cpu_gemm(p);
+    for(std::size_t i = 0; i + 1 < 5; i++)
+        EXPECT(c[i * 4 + 3] == 7.0f);
+}
+
 TEST_CASE(gemm1)
 {
     verify_gemm(create_mat_shape({2, 2}, true),
@@ -431,6 +376,47 @@ TEST_CASE(bgemm3)
                        create_mat_shape({64, 8, 32}));
 }
 
+TEST_CASE(plan_gemm1)
+{
+    verify_gemm_plan<float>(create_mat_shape({8, 4}),
+                            create_mat_shape({4, 32}),
+                            create_mat_shape({8, 32}));
+    verify_gemm_plan<half>(create_mat_shape({64, 4, 8}, true),
+                           create_mat_shape({64, 32, 4}, true),
+                           create_mat_shape({64, 8, 32}));
+}
+
+TEST_CASE(workspace_gemm1)
+{
+    verify_gemm_workspace<float>(create_mat_shape({8, 4}),
+                                 create_mat_shape({4, 32}),
+                                 create_mat_shape({8, 32}));
+    // Deep k is where split-k solutions are picked
+    verify_gemm_workspace<float>(create_mat_shape({32, 4096}),
+                                 create_mat_shape({4096, 32}),
+                                 create_mat_shape({32, 32}));
+}
+
+TEST_CASE(batched_gemm1)
+{
+    verify_gemm_batched<float>(create_mat_shape({8, 4}),
+                               create_mat_shape({4, 32}),
+                               create_mat_shape({8, 32}),
+                               5);
+    verify_gemm_batched<half>(create_mat_shape({4, 8}, true),
+                              create_mat_shape({32, 4}, true),
+                              create_mat_shape({8, 32}),
+                              3);
+}
+
+TEST_CASE(grouped_gemm1)
+{
+    verify_gemm_grouped<float>({{create_mat_shape({8, 4}), create_mat_shape({4, 32}), create_mat_shape({8, 32})},
+                                {create_mat_shape({16, 8}), create_mat_shape({8, 4}), create_mat_shape({16, 4})},
+                                {create_mat_shape({8, 4}), create_mat_shape({4, 32}), create_mat_shape({8, 32})},
+                                {create_mat_shape({4, 8}, true), create_mat_shape({32, 4}, true), create_mat_shape({8, 32})}});
+}
+
 TEST_CASE(int8gemm1)
 {
     verify_int8x4_gemm(create_mat_shape({2, 4}),
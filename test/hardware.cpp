@@ -0,0 +1,133 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/hardware.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test.hpp"
+
+struct counting_provider : miopentensile::hardware_provider
+{
+    std::shared_ptr<miopentensile::hardware_provider> fake =
+        miopentensile::fake_hardware_provider("gfx906", 60);
+    int device = 0;
+    mutable std::atomic<int> calls{0};
+
+    int current_device() const override { return device; }
+    miopentensile::hardware_ptr create_hardware(int d) const override
+    {
+        calls++;
+        return fake->create_hardware(d);
+    }
+};
+
+TEST_CASE(fake_hardware)
+{
+    auto p  = miopentensile::fake_hardware_provider("gfx908", 120);
+    auto hw = p->create_hardware(0);
+    EXPECT(hw != nullptr);
+    EXPECT(miopentensile::hardware_arch(*hw) == "gfx908");
+    EXPECT(miopentensile::hardware_cu_count(*hw) == 120u);
+    EXPECT(miopentensile::hardware_arch(
+               *miopentensile::fake_hardware_provider("gfx90a:xnack-", 104)->create_hardware(0)) ==
+           "gfx90a");
+    EXPECT(test::throws([] { miopentensile::fake_hardware_provider("gfx000", 1); }));
+}
+
+TEST_CASE(registry_once_per_device)
+{
+    auto p = std::make_shared<counting_provider>();
+    miopentensile::hardware_registry r{p};
+    const auto& hw = r.current();
+    EXPECT(&r.get(0) == &hw);
+    EXPECT(p->calls == 1);
+    p->device = 3;
+    EXPECT(r.current() != hw);
+    EXPECT(p->calls == 2);
+    EXPECT(r.created() == 2u);
+    EXPECT(test::throws([&] { r.get(-1); }));
+    EXPECT(test::throws([&] { r.get(miopentensile::hardware_registry::max_devices); }));
+}
+
+TEST_CASE(registry_threads)
+{
+    auto p = std::make_shared<counting_provider>();
+    miopentensile::hardware_registry r{p};
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 8; t++)
+        threads.emplace_back([&] {
+            for(int i = 0; i < 1000; i++)
+                EXPECT(r.get(i % 4) != nullptr);
+        });
+    for(auto&& t : threads)
+        t.join();
+    EXPECT(p->calls == 4);
+}
+
+TEST_CASE(global_registry)
+{
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider("gfx90a", 104));
+    EXPECT(miopentensile::current_device() == 0);
+    EXPECT(miopentensile::hardware_arch(*miopentensile::hardware().current()) == "gfx90a");
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+TEST_CASE(stream_cu_count)
+{
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider("gfx908", 120));
+    auto s1 = reinterpret_cast<hipStream_t>(0x10);
+    auto s2 = reinterpret_cast<hipStream_t>(0x20);
+    EXPECT(miopentensile::stream_cu_count(s1) == 0u);
+    miopentensile::set_stream_cu_count(s1, 16);
+    EXPECT(miopentensile::stream_cu_count(s1) == 16u);
+    EXPECT(miopentensile::stream_cu_count(s2) == 0u);
+    miopentensile::set_stream_cu_count(s1, 0);
+    EXPECT(miopentensile::stream_cu_count(s1) == 0u);
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+
+    auto hw   = miopentensile::fake_hardware_provider("gfx908", 120)->create_hardware(0);
+    auto half = miopentensile::with_cu_count(hw, 60);
+    EXPECT(half != hw);
+    EXPECT(miopentensile::hardware_cu_count(*half) == 60u);
+    EXPECT(miopentensile::hardware_arch(*half) == "gfx908");
+    EXPECT(miopentensile::with_cu_count(hw, 0) == hw);
+    EXPECT(miopentensile::with_cu_count(hw, 120) == hw);
+}
+
+// Reports a cu mask for every stream and counts the queries
+struct masked_provider : miopentensile::hardware_provider
+{
+    std::shared_ptr<miopentensile::hardware_provider> fake =
+        miopentensile::fake_hardware_provider("gfx908", 120);
+    mutable std::atomic<int> queries{0};
+
+    int current_device() const override { return 0; }
+    miopentensile::hardware_ptr create_hardware(int d) const override
+    {
+        return fake->create_hardware(d);
+    }
+    std::size_t stream_cu_count(hipStream_t) const override
+    {
+        queries++;
+        return 24;
+    }
+};
+
+TEST_CASE(stream_cu_mask)
+{
+    auto p = std::make_shared<masked_provider>();
+    miopentensile::set_hardware_provider(p);
+    auto s = reinterpret_cast<hipStream_t>(0x30);
+    // The mask is only queried when asked for, and then once
+    EXPECT(miopentensile::stream_cu_count(s) == 0u);
+    EXPECT(p->queries == 0);
+    EXPECT(miopen_tensile_set_stream_cu_count_from_mask(s) == miopen_tensile_status_success);
+    EXPECT(p->queries == 1);
+    for(int i = 0; i < 4; i++)
+        EXPECT(miopentensile::stream_cu_count(s) == 24u);
+    EXPECT(p->queries == 1);
+    EXPECT(miopen_tensile_set_stream_cu_count(s, 0) == miopen_tensile_status_success);
+    EXPECT(miopentensile::stream_cu_count(s) == 0u);
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
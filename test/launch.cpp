@@ -0,0 +1,264 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/problem.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+#include "fixtures.hpp"
+#include "test.hpp"
+
+// Counts the heap allocations of the whole process while enabled, including
+// those of the library
+
+std::atomic<bool> counting{false};
+std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t n)
+{
+    if(counting)
+        allocations++;
+    if(void* p = std::malloc(n == 0 ? 1 : n))
+        return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+template <class F>
+std::size_t count_allocations(F f)
+{
+    allocations = 0;
+    counting    = true;
+    f();
+    counting = false;
+    return allocations;
+}
+
+// Records the launches instead of submitting them, without allocating
+struct recording_launcher : miopentensile::kernel_launcher
+{
+    std::size_t launches  = 0;
+    std::size_t kernels   = 0;
+    std::size_t arg_bytes = 0;
+    void load_code_object(const std::string&) override {}
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>& invocations,
+                      hipStream_t) override
+    {
+        launches++;
+        kernels += invocations.size();
+        for(auto&& k : invocations)
+            arg_bytes += k.args.size();
+        return hipSuccess;
+    }
+};
+
+TEST_CASE(steady_state_launches_do_not_allocate)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    auto launcher = std::make_shared<recording_launcher>();
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    miopentensile::set_kernel_launcher(launcher);
+    miopentensile::clear_plan_cache();
+
+    std::size_t plans    = 0;
+    std::size_t unpacked = 0;
+    for(auto type : {miopen_tensile_type_float, miopen_tensile_type_half})
+    {
+        for(double beta : {0.0, 1.0, 0.5})
+        {
+            auto a    = mitensile::make_matrix(512, 256, type);
+            auto b    = mitensile::make_matrix(256, 768, type);
+            auto c    = mitensile::make_matrix(512, 768, type);
+            auto plan = miopentensile::get_gemm_plan(b, a, c, beta);
+            if(plan->solution == nullptr)
+                continue;
+            plans++;
+            auto gemm = [&] {
+                EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, beta) ==
+                       miopen_tensile_status_success);
+            };
+            gemm();
+            auto launches = launcher->launches;
+            // Plans whose arguments could not be located are solved by
+            // tensile on every call, which allocates, but still launch once
+            // per call
+            if(not plan->packed)
+            {
+                unpacked++;
+                gemm();
+                EXPECT(launcher->launches == launches + 1);
+                continue;
+            }
+            EXPECT(count_allocations([&] {
+                       for(int i = 0; i < 10; i++)
+                           gemm();
+                   }) == 0u);
+            EXPECT(launcher->launches == launches + 10);
+
+            // Plans for any beta and plans for this beta
+            for(double plan_beta : {miopentensile::generic_beta, beta})
+            {
+                miopen_tensile_gemm_plan p = nullptr;
+                EXPECT(miopen_tensile_gemm_plan_create_for_beta(&p, &a, &b, &c, plan_beta, 0) ==
+                       miopen_tensile_status_success);
+                auto execute = [&](const void* x) {
+                    EXPECT(miopen_tensile_gemm_plan_execute(
+                               p, nullptr, x, x, nullptr, 2.0, beta) ==
+                           miopen_tensile_status_success);
+                };
+                execute(nullptr);
+                EXPECT(count_allocations([&] {
+                           for(int i = 0; i < 10; i++)
+                               execute(&i);
+                       }) == 0u);
+                miopen_tensile_gemm_plan_destroy(p);
+            }
+        }
+    }
+    EXPECT(launcher->kernels >= launcher->launches);
+    std::cout << unpacked << " of " << plans << " plans are not packed" << std::endl;
+    // Locating the arguments works for the common float and half kernels
+    EXPECT(plans > unpacked);
+
+    miopentensile::set_kernel_launcher(miopentensile::hip_kernel_launcher());
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+TEST_CASE(alternating_shapes_do_not_allocate)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    auto launcher = std::make_shared<recording_launcher>();
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    miopentensile::set_kernel_launcher(launcher);
+
+    // A thread cycling through a few shapes, as the layers of a network do,
+    // keeps the kernels of each in its arena
+    struct gemm_shape
+    {
+        miopen_tensile_matrix a;
+        miopen_tensile_matrix b;
+        miopen_tensile_matrix c;
+    };
+    std::vector<gemm_shape> shapes;
+    for(std::size_t n : {256, 384, 512, 640})
+    {
+        auto a = mitensile::make_matrix(n, 128);
+        auto b = mitensile::make_matrix(128, n * 2);
+        auto c = mitensile::make_matrix(n, n * 2);
+        auto p = miopentensile::get_gemm_plan(b, a, c, 0.0);
+        if(p->solution != nullptr and p->packed)
+            shapes.push_back({a, b, c});
+    }
+    std::cout << shapes.size() << " packed shapes" << std::endl;
+    auto gemms = [&] {
+        for(auto&& s : shapes)
+        {
+            EXPECT(miopen_tensile_gemm_hip(nullptr, &s.a, &s.b, &s.c, 1.0, 0.0) ==
+                   miopen_tensile_status_success);
+        }
+    };
+    gemms();
+    auto launches = launcher->launches;
+    EXPECT(count_allocations([&] {
+               for(int i = 0; i < 10; i++)
+                   gemms();
+           }) == 0u);
+    EXPECT(launcher->launches == launches + 10 * shapes.size());
+
+    miopentensile::set_kernel_launcher(miopentensile::hip_kernel_launcher());
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+TEST_CASE(arena_follows_the_plan)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    // Solving into the same arena gives the same arguments as a fresh one,
+    // whichever plan was solved into it before
+    auto a      = mitensile::make_matrix(256, 128, miopen_tensile_type_float);
+    auto b      = mitensile::make_matrix(128, 384, miopen_tensile_type_float);
+    auto c      = mitensile::make_matrix(256, 384, miopen_tensile_type_float);
+    auto d      = mitensile::make_matrix(256, 128, miopen_tensile_type_float);
+    auto first  = miopentensile::get_gemm_plan(b, a, c, 0.0);
+    auto second = miopentensile::get_gemm_plan(mitensile::make_matrix(128, 128, a.type), a, d, 0.0);
+    std::vector<float> buffer(4);
+    miopentensile::gemm_args args;
+    args.a = buffer.data();
+    args.b = buffer.data() + 1;
+    args.c = buffer.data() + 2;
+    miopentensile::launch_arena shared;
+    for(auto&& plan : {first, second, first, first, second})
+    {
+        if(plan->solution == nullptr)
+            continue;
+        args.alpha += 1;
+        miopentensile::launch_arena fresh;
+        const auto& reused = plan->solve(args, shared);
+        const auto& solved = plan->solve(args, fresh);
+        EXPECT(reused.size() == solved.size());
+        for(std::size_t i = 0; i < reused.size() and i < solved.size(); i++)
+        {
+            const auto& x = reused[i].args;
+            const auto& y = solved[i].args;
+            EXPECT(x.size() == y.size());
+            EXPECT(std::equal(static_cast<const char*>(x.data()),
+                              static_cast<const char*>(x.data()) + x.size(),
+                              static_cast<const char*>(y.data())));
+        }
+    }
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+TEST_CASE(arena_slots)
+{
+    // Plans keep their slot while fewer than the slots alternate, and the
+    // least recently used one is replaced
+    miopentensile::launch_arena arena;
+    auto n = arena.slots.size();
+    std::vector<miopentensile::launch_slot*> slots;
+    for(std::uint64_t plan = 1; plan <= n; plan++)
+    {
+        auto& s = arena.slot(plan);
+        EXPECT(s.plan == 0u);
+        s.plan = plan;
+        slots.push_back(&s);
+    }
+    for(std::uint64_t plan = 1; plan <= n; plan++)
+        EXPECT(&arena.slot(plan) == slots[plan - 1]);
+    EXPECT(std::set<miopentensile::launch_slot*>(slots.begin(), slots.end()).size() == n);
+    arena.slot(1);
+    auto& replaced = arena.slot(n + 1);
+    EXPECT(&replaced == slots[1]);
+    EXPECT(replaced.plan == 0u);
+    EXPECT(arena.slot(1).plan == 1u);
+    // Plans that are not packed get a slot of their own every time
+    EXPECT(arena.slot(0).plan == 0u);
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
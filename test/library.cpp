@@ -0,0 +1,192 @@
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/problem.hpp>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include "fixtures.hpp"
+#include "test.hpp"
+
+std::string temp_dir(const std::string& name)
+{
+    auto dir = "/tmp/miopentensile_test_" + std::to_string(getpid());
+    mkdir(dir.c_str(), 0700);
+    dir += "/" + name;
+    mkdir(dir.c_str(), 0700);
+    return dir + "/";
+}
+
+// Answers every problem with the same solution, or none
+struct fixed_library : miopentensile::library_type
+{
+    using solution_ptr = std::shared_ptr<Tensile::ContractionSolution>;
+
+    explicit fixed_library(solution_ptr s) : solution(std::move(s)) {}
+
+    solution_ptr findBestSolution(Tensile::ContractionProblem const&,
+                                  Tensile::Hardware const&,
+                                  double*) const override
+    {
+        calls++;
+        return solution;
+    }
+
+    Tensile::SolutionSet<Tensile::ContractionSolution>
+    findAllSolutions(Tensile::ContractionProblem const&, Tensile::Hardware const&) const override
+    {
+        if(solution == nullptr)
+            return {};
+        return {solution};
+    }
+
+    std::string type() const override { return "fixed"; }
+    std::string description() const override { return "fixed"; }
+
+    solution_ptr solution;
+    mutable std::atomic<int> calls{0};
+};
+
+TEST_CASE(parallel_for_bounded)
+{
+    std::vector<std::atomic<int>> visits(1000);
+    std::mutex m;
+    std::set<std::thread::id> threads;
+    miopentensile::parallel_for(visits.size(), 4, [&](std::size_t i) {
+        visits[i]++;
+        std::lock_guard<std::mutex> lock(m);
+        threads.insert(std::this_thread::get_id());
+    });
+    EXPECT(std::all_of(visits.begin(), visits.end(), [](auto&& v) { return v == 1; }));
+    EXPECT(threads.size() <= 4u);
+
+    miopentensile::parallel_for(0, 4, [](std::size_t) { throw std::runtime_error("empty"); });
+    std::atomic<int> ran{0};
+    EXPECT(test::throws([&] {
+        miopentensile::parallel_for(16, 4, [&](std::size_t i) {
+            ran++;
+            if(i == 3)
+                throw std::runtime_error("failed");
+        });
+    }));
+    EXPECT(ran == 16);
+}
+
+TEST_CASE(library_parts)
+{
+    auto shard = temp_dir("shard");
+    EXPECT(miopentensile::library_parts(shard) == std::vector<std::string>{shard});
+
+    // Parts without a library file are skipped
+    for(auto&& part : {"SB", "HB"})
+    {
+        auto dir = temp_dir(part);
+        mkdir((dir + "library").c_str(), 0700);
+    }
+    std::ofstream(temp_dir("SB") + "library/TensileLibrary.dat");
+    std::ofstream(temp_dir("SB") + "library/TensileLibrary.yaml");
+    std::ofstream(shard + "TensileLibraryParts.txt") << "../SB/library/\n../HB/library/\n";
+    auto parts = miopentensile::library_parts(shard);
+    EXPECT(parts == std::vector<std::string>{shard + "../SB/library/"});
+}
+
+TEST_CASE(library_set_search)
+{
+    auto first   = std::make_shared<Tensile::ContractionSolution>();
+    auto second  = std::make_shared<Tensile::ContractionSolution>();
+    auto none    = std::make_shared<fixed_library>(nullptr);
+    auto found   = std::make_shared<fixed_library>(first);
+    auto skipped = std::make_shared<fixed_library>(second);
+    miopentensile::library_set set{{none, found, skipped}};
+
+    auto hw      = miopentensile::fake_hardware_provider("gfx906", 60)->create_hardware(0);
+    auto a       = mitensile::make_matrix(64, 32);
+    auto b       = mitensile::make_matrix(32, 64);
+    auto c       = mitensile::make_matrix(64, 64);
+    auto problem = miopentensile::create_tensile_problem(b, a, c, 0.0);
+    EXPECT(set.findBestSolution(problem, *hw) == first);
+    EXPECT(none->calls == 1);
+    EXPECT(skipped->calls == 0);
+    auto all = set.findAllSolutions(problem, *hw);
+    EXPECT(all.size() == 2u);
+    EXPECT(all.count(second) == 1u);
+}
+
+TEST_CASE(library_set_owner)
+{
+    EXPECT(miopentensile::library_part_group("/opt/shard/../HBH/library/") == "HBH");
+    EXPECT(miopentensile::library_part_group("/opt/SB") == "SB");
+
+    // Both parts answer every problem, only the part of its type is asked
+    auto single = std::make_shared<Tensile::ContractionSolution>();
+    auto half   = std::make_shared<Tensile::ContractionSolution>();
+    auto hbh    = std::make_shared<fixed_library>(half);
+    auto sb     = std::make_shared<fixed_library>(single);
+    miopentensile::library_set set{{hbh, sb}, {"HBH", "SB"}};
+
+    auto hw      = miopentensile::fake_hardware_provider("gfx906", 60)->create_hardware(0);
+    auto a       = mitensile::make_matrix(64, 32);
+    auto b       = mitensile::make_matrix(32, 64);
+    auto c       = mitensile::make_matrix(64, 64);
+    auto problem = miopentensile::create_tensile_problem(b, a, c, 0.0);
+    EXPECT(miopentensile::library_group(problem) == "SB");
+    EXPECT(set.findBestSolution(problem, *hw) == single);
+    EXPECT(hbh->calls == 0);
+    auto all = set.findAllSolutions(problem, *hw);
+    EXPECT(all.size() == 1u);
+    EXPECT(all.count(single) == 1u);
+
+    a.type            = miopen_tensile_type_half;
+    b.type            = miopen_tensile_type_half;
+    c.type            = miopen_tensile_type_half;
+    auto problem_half = miopentensile::create_tensile_problem(b, a, c, 0.0);
+    EXPECT(miopentensile::library_group(problem_half) == "HBH");
+    EXPECT(set.findBestSolution(problem_half, *hw) == half);
+    EXPECT(sb->calls == 1);
+    EXPECT(set.findAllSolutions(problem_half, *hw).count(half) == 1u);
+}
+
+TEST_CASE(parallel_load)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    // Every part loads to the same selections on one thread or several
+    auto parts    = miopentensile::library_parts(miopentensile::library_path(arch));
+    auto serial   = miopentensile::load_library(parts, 1);
+    auto parallel = miopentensile::load_library(parts, 4);
+    auto hw       = miopentensile::fake_hardware_provider(arch, 64)->create_hardware(0);
+    for(std::size_t n : {64, 256, 1024})
+    {
+        for(auto type : {miopen_tensile_type_float, miopen_tensile_type_half})
+        {
+            auto a  = mitensile::make_matrix(n, n);
+            a.type  = type;
+            auto b  = a;
+            auto c  = a;
+            auto p  = miopentensile::create_tensile_problem(b, a, c, 0.0);
+            auto s1 = serial->findBestSolution(p, *hw);
+            auto s2 = parallel->findBestSolution(p, *hw);
+            EXPECT((s1 == nullptr) == (s2 == nullptr));
+            if(s1 != nullptr and s2 != nullptr)
+                EXPECT(s1->kernelName == s2->kernelName);
+        }
+    }
+
+    // Loading started in the background is the one used afterwards
+    miopentensile::initialize_library(arch);
+    miopentensile::initialize_library(arch);
+    const auto* lib = &miopentensile::library(arch);
+    EXPECT(lib == &miopentensile::library(arch));
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
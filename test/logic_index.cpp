@@ -0,0 +1,293 @@
+#include <miopentensile/logic_file.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/logic_problem.hpp>
+#include <miopentensile/problem.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "test.hpp"
+
+// The operation is taken from the file name, so keep the names as they are
+// and put them in a directory of their own
+std::string temp_path(const std::string& name)
+{
+    auto dir = "/tmp/miopentensile_test_" + std::to_string(getpid());
+    mkdir(dir.c_str(), 0700);
+    return dir + "/" + name;
+}
+
+// A cut down logic file in the layout written by tensile
+const char* const logic_yaml = R"(- {MinimumRequiredVersion: 4.27.0}
+- arcturus
+- gfx908
+- [Device 7380, Device 7388,
+  Device 738c]
+- AssignedDerivedParameters: true
+  DataType: 4
+  DestDataType: 4
+  ComputeDataType: 0
+  HighPrecisionAccumulate: true
+  TransposeA: false
+  TransposeB: true
+  SetConstStrideA: []
+- - DepthU: 16
+    GlobalSplitU: 1
+    MacroTile0: 64
+    MacroTile1: 128
+    ProblemType:
+      DataType: 0
+      TransposeA: true
+    SolutionIndex: 0
+    SolutionNameMin: Cijk_Ailk_Bjlk_HBH_MT64x128x16
+    WorkGroup: &id001 [16, 16, 1]
+    _WorkspaceSizePerElemC: 0
+  - DepthU: 8
+    GlobalSplitU: 4
+    GlobalSplitUAlgorithm: MultipleBuffer
+    MacroTile0: 32
+    MacroTile1: 32
+    SolutionIndex: 1
+    SolutionNameMin: Cijk_Ailk_Bjlk_HBH_MT32x32x8_GSU4
+    WorkGroup: *id001
+    _WorkspaceSizePerElemC: 8
+- [2, 3, 0, 1]
+- - - [1024, 1024, 1, 64]
+    - [1, 100.5]
+  - - [64, 64, 1, 256, 64, 64, 64, 64]
+    - [0, 12.0]
+  - - [1024, 1024, 1, 64]
+    - [0, 200.25]
+  - - [128, 64, 2, 64]
+    - [1, 50.0]
+- null
+)";
+
+std::string write_logic_yaml()
+{
+    auto path = temp_path("arcturus_Cijk_Ailk_Bjlk_HBH.yaml");
+    std::ofstream os(path);
+    os << logic_yaml;
+    return path;
+}
+
+TEST_CASE(parse_logic)
+{
+    auto path = write_logic_yaml();
+    auto f    = miopentensile::parse_logic_file(path);
+    std::remove(path.c_str());
+    EXPECT(f.schedule == "arcturus");
+    EXPECT(f.arch == "gfx908");
+    EXPECT(f.operation == "Cijk_Ailk_Bjlk_HBH");
+    EXPECT(f.devices.size() == 3u);
+    EXPECT(f.devices[2] == "Device 738c");
+    EXPECT(f.data_type == 4);
+    EXPECT(f.compute_data_type == 0);
+    EXPECT(f.high_precision_accumulate);
+    EXPECT(not f.transpose_a);
+    EXPECT(f.transpose_b);
+    EXPECT(f.strided_batched);
+    EXPECT(not f.cu_efficiency);
+    EXPECT(f.solutions.size() == 2u);
+    EXPECT(f.solutions[0].name == "Cijk_Ailk_Bjlk_HBH_MT64x128x16");
+    EXPECT(f.solutions[0].macro_tile1 == 128);
+    EXPECT(not f.solutions[0].multiple_buffer);
+    EXPECT(f.solutions[1].global_split_u == 4);
+    EXPECT(f.solutions[1].multiple_buffer);
+    EXPECT(f.solutions[1].workspace_per_elem_c == 8);
+    EXPECT(f.solutions[1].workgroup[1] == 16);
+    EXPECT(f.exact.size() == 4u);
+    EXPECT(f.exact[1].ldb == 64u);
+    EXPECT(f.exact[3].batch == 2u);
+    EXPECT(f.exact[3].solution == 1);
+    EXPECT(f.exact[2].gflops == 200.25);
+}
+
+TEST_CASE(index_lookup)
+{
+    auto yaml = write_logic_yaml();
+    auto path = temp_path("index.idx");
+    miopentensile::write_logic_index({miopentensile::parse_logic_file(yaml)}, path);
+    std::remove(yaml.c_str());
+    {
+        miopentensile::logic_index index{path};
+        EXPECT(index.type_count() == 1u);
+        EXPECT(index.solution_count() == 2u);
+        EXPECT(index.entry_count() == 4u);
+        EXPECT(index.find_type("gfx906", "Cijk_Ailk_Bjlk_HBH") == miopentensile::logic_index::npos);
+        EXPECT(index.find_type("gfx908", "Cijk_Ailk_Bjlk_HBH", true) ==
+               miopentensile::logic_index::npos);
+        auto t = index.find_type("gfx908", "Cijk_Ailk_Bjlk_HBH");
+        EXPECT(t == 0u);
+        EXPECT(index.string(index.type(t).devices) ==
+               std::string("Device 7380;Device 7388;Device 738c"));
+
+        // Entries of the same size are ordered best first
+        auto r = index.find_exact(t, 1024, 1024, 1, 64);
+        EXPECT(r.size() == 2u);
+        EXPECT(r.begin()->gflops == 200.25);
+        EXPECT(index.string(index.solution(r.begin()->solution).name) ==
+               std::string("Cijk_Ailk_Bjlk_HBH_MT64x128x16"));
+        EXPECT(index.find_exact(t, 128, 64, 2, 64).size() == 1u);
+        EXPECT(index.find_exact(t, 128, 64, 1, 64).empty());
+        EXPECT(index.solution(1).workspace_per_elem_c == 8);
+
+        // The nearest size keeps the best entry of that size
+        auto nearest = index.find_nearest(t, 1024, 1024, 1, 64);
+        EXPECT(nearest.entry == r.begin());
+        EXPECT(nearest.distance == 0);
+        nearest = index.find_nearest(t, 100, 60, 2, 70);
+        EXPECT(nearest.entry->gflops == 50.0);
+        EXPECT(nearest.distance > 0);
+        EXPECT(index.find_nearest(t, 900, 2000, 1, 64).entry->gflops == 200.25);
+        EXPECT(index.find_nearest(1, 64, 64, 1, 64).entry == nullptr);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE(index_type_order)
+{
+    auto yaml = write_logic_yaml();
+    auto base = miopentensile::parse_logic_file(yaml);
+    std::remove(yaml.c_str());
+    // Written out of order, with two files of the same type
+    std::vector<std::tuple<std::string, std::string, bool>> types = {
+        {"gfx908", "Cijk_Ailk_Bljk_SB", false},
+        {"gfx906", "Cijk_Ailk_Bjlk_HBH", true},
+        {"gfx908", "Cijk_Ailk_Bjlk_HBH", true},
+        {"gfx906", "Cijk_Ailk_Bjlk_HBH", false},
+        {"gfx908", "Cijk_Ailk_Bjlk_HBH", false},
+        {"gfx908", "Cijk_Ailk_Bljk_SB", false}};
+    std::vector<miopentensile::logic_file> files;
+    for(auto&& t : types)
+    {
+        auto f = base;
+        std::tie(f.arch, f.operation, f.cu_efficiency) = t;
+        f.exact.resize(files.size() + 1);
+        files.push_back(f);
+    }
+    auto path = temp_path("types.idx");
+    miopentensile::write_logic_index(files, path);
+    {
+        miopentensile::logic_index index{path};
+        EXPECT(index.type_count() == types.size());
+        for(std::size_t i = 0; i < types.size(); i++)
+        {
+            auto t = index.find_type(
+                std::get<0>(types[i]), std::get<1>(types[i]), std::get<2>(types[i]));
+            EXPECT(t != miopentensile::logic_index::npos);
+            EXPECT(index.string(index.type(t).arch) == std::get<0>(types[i]));
+            EXPECT(index.string(index.type(t).operation) == std::get<1>(types[i]));
+            EXPECT(bool(index.type(t).cu_efficiency) == std::get<2>(types[i]));
+        }
+        // The first of the files with the same type is found
+        EXPECT(index.type(index.find_type("gfx908", "Cijk_Ailk_Bljk_SB")).entry_count == 1u);
+        EXPECT(index.find_type("gfx900", "Cijk_Ailk_Bjlk_HBH") == miopentensile::logic_index::npos);
+        EXPECT(index.find_type("gfx908", "Cijk_Ailk_Bljk_HBH") == miopentensile::logic_index::npos);
+        EXPECT(index.find_type("gfx908", "Cijk_Ailk_Bljk_SB", true) ==
+               miopentensile::logic_index::npos);
+        EXPECT(index.find_type("gfx90a", "Cijk_Ailk_Bjlk_HBH") == miopentensile::logic_index::npos);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE(index_invalid)
+{
+    auto path = temp_path("invalid.idx");
+    {
+        std::ofstream os(path, std::ios::binary);
+        os << std::string(200, 'x');
+    }
+    EXPECT(test::throws([&] { miopentensile::logic_index{path}; }));
+    std::remove(path.c_str());
+    EXPECT(test::throws([&] { miopentensile::logic_index{path}; }));
+    rmdir(path.substr(0, path.rfind('/')).c_str());
+}
+
+TEST_CASE(logic_operands)
+{
+    miopentensile::logic_index::type_record t{};
+    miopentensile::logic_index::entry_record e{};
+    miopen_tensile_type type;
+    t.strided_batched = true;
+    t.transpose_a     = true;
+    t.data_type       = 4;
+    t.dest_data_type  = 4;
+    EXPECT(not miopentensile::logic_input_type(t, type));
+    t.high_precision_accumulate = true;
+    EXPECT(miopentensile::logic_input_type(t, type));
+    EXPECT(type == miopen_tensile_type_half);
+
+    e.m      = 64;
+    e.n      = 32;
+    e.batch  = 3;
+    e.k      = 16;
+    auto x   = miopentensile::logic_operands(t, e);
+    auto key = miopentensile::create_problem_key(x.a, x.b, x.c, 1.0, 0);
+    EXPECT(miopentensile::logic_operation(key) == "Cijk_Alik_Bljk_HBH");
+    EXPECT(key.transpose_a);
+    EXPECT(not key.transpose_b);
+    EXPECT(key.m == 64u);
+    EXPECT(key.n == 32u);
+    EXPECT(key.k == 16u);
+    EXPECT(key.batch == 3u);
+    EXPECT(key.lda == 16u);
+    EXPECT(key.ldb == 16u);
+    EXPECT(key.ldc == 64u);
+    EXPECT(key.stride_a == 64u * 16u);
+
+    // Leading dimensions from the table are kept
+    e.lda  = 20;
+    e.ldc  = 80;
+    auto y = miopentensile::logic_operands(t, e);
+    key    = miopentensile::create_problem_key(y.a, x.b, y.c, 1.0, 0);
+    EXPECT(key.lda == 20u);
+    EXPECT(key.ldc == 80u);
+
+    // int8x4 sizes are counted in groups of four along k
+    t.data_type      = 5;
+    t.dest_data_type = 6;
+    e                = {};
+    e.m              = 8;
+    e.n              = 8;
+    e.batch          = 1;
+    e.k              = 4;
+    x                = miopentensile::logic_operands(t, e);
+    EXPECT(x.a.type == miopen_tensile_type_int8x4);
+    EXPECT(x.c.type == miopen_tensile_type_int32);
+    key = miopentensile::create_problem_key(x.a, x.b, x.c, 1.0, 0);
+    EXPECT(key.k == 16u);
+    EXPECT(miopentensile::logic_operation(key) == "Cijk_Alik_Bljk_4xi8BH");
+
+    t.strided_batched = false;
+    EXPECT(not miopentensile::logic_input_type(t, type));
+}
+
+TEST_CASE(beta_key)
+{
+    miopentensile::logic_index::type_record t{};
+    miopentensile::logic_index::entry_record e{};
+    t.strided_batched = true;
+    e.m               = 64;
+    e.n               = 64;
+    e.batch           = 2;
+    e.k               = 64;
+    auto x            = miopentensile::logic_operands(t, e);
+    auto zero         = miopentensile::create_problem_key(x.a, x.b, x.c, 0.0, 0);
+    auto one          = miopentensile::create_problem_key(x.a, x.b, x.c, 1.0, 0);
+    auto other        = miopentensile::create_problem_key(x.a, x.b, x.c, 0.5, 0);
+    EXPECT(zero.beta == miopentensile::beta_zero);
+    EXPECT(one.beta == miopentensile::beta_one);
+    EXPECT(other.beta == miopentensile::beta_other);
+    EXPECT(bool(zero != one));
+    EXPECT(bool(one != other));
+    EXPECT(bool(other == miopentensile::create_problem_key(x.a, x.b, x.c, -3.0, 0)));
+    EXPECT(miopentensile::problem_key_hash{}(zero) != miopentensile::problem_key_hash{}(one));
+    EXPECT(miopentensile::create_tensile_problem(x.a, x.b, x.c, 0.0).beta() == 0.0);
+    EXPECT(miopentensile::create_tensile_problem(x.a, x.b, x.c, 0.5).beta() == 0.5);
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
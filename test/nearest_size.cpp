@@ -0,0 +1,96 @@
+#include <miopentensile/nearest_size.hpp>
+#include <cmath>
+#include <random>
+#include "test.hpp"
+
+using size_type = miopentensile::nearest_size_tree::size_type;
+
+double log_distance(const size_type& x, const size_type& y)
+{
+    double result = 0;
+    for(std::size_t i = 0; i < x.size(); i++)
+    {
+        auto d = std::log2(double(std::max<std::uint64_t>(x[i], 1))) -
+                 std::log2(double(std::max<std::uint64_t>(y[i], 1)));
+        result += d * d;
+    }
+    return result;
+}
+
+std::size_t brute_force_nearest(const std::vector<size_type>& sizes, const size_type& s)
+{
+    std::size_t result = miopentensile::nearest_size_tree::npos;
+    double best        = 0;
+    for(std::size_t i = 0; i < sizes.size(); i++)
+    {
+        auto d = log_distance(sizes[i], s);
+        if(result == miopentensile::nearest_size_tree::npos or d < best)
+        {
+            result = i;
+            best   = d;
+        }
+    }
+    return result;
+}
+
+size_type random_size(std::mt19937& rng)
+{
+    std::uniform_int_distribution<std::uint64_t> dim(1, 8192);
+    std::uniform_int_distribution<std::uint64_t> batch(1, 64);
+    return {{dim(rng), dim(rng), batch(rng), dim(rng)}};
+}
+
+TEST_CASE(nearest_empty)
+{
+    miopentensile::nearest_size_tree tree{{}};
+    EXPECT(tree.size() == 0u);
+    EXPECT(tree.nearest({{64, 64, 1, 64}}).id == miopentensile::nearest_size_tree::npos);
+}
+
+TEST_CASE(nearest_exact)
+{
+    std::vector<size_type> sizes = {
+        {{1024, 1024, 1, 64}}, {{64, 64, 1, 256}}, {{128, 64, 2, 64}}, {{3840, 4224, 1, 4096}}};
+    miopentensile::nearest_size_tree tree{sizes};
+    for(std::size_t i = 0; i < sizes.size(); i++)
+    {
+        auto r = tree.nearest(sizes[i]);
+        EXPECT(r.id == i);
+        EXPECT(r.distance == 0);
+    }
+    // Twice as large along m is closer than half as large along both m and n
+    auto r = tree.nearest({{2048, 1024, 1, 64}});
+    EXPECT(r.id == 0u);
+    EXPECT(r.distance == 1);
+}
+
+TEST_CASE(nearest_ties)
+{
+    // Equal sizes and equal distances resolve to the first size given
+    std::vector<size_type> sizes = {
+        {{256, 64, 1, 64}}, {{64, 64, 1, 64}}, {{64, 64, 1, 64}}, {{64, 256, 1, 64}}};
+    miopentensile::nearest_size_tree tree{sizes};
+    EXPECT(tree.nearest({{64, 64, 1, 64}}).id == 1u);
+    EXPECT(tree.nearest({{128, 128, 1, 64}}).id == 0u);
+}
+
+TEST_CASE(nearest_random)
+{
+    std::mt19937 rng{7};
+    std::vector<size_type> sizes;
+    for(int i = 0; i < 2000; i++)
+        sizes.push_back(random_size(rng));
+    miopentensile::nearest_size_tree tree{sizes};
+    EXPECT(tree.size() == sizes.size());
+    for(int i = 0; i < 500; i++)
+    {
+        auto s        = random_size(rng);
+        auto r        = tree.nearest(s);
+        auto expected = brute_force_nearest(sizes, s);
+        EXPECT(r.id != miopentensile::nearest_size_tree::npos);
+        EXPECT(log_distance(sizes[r.id], s) == log_distance(sizes[expected], s));
+        EXPECT(r.distance == log_distance(sizes[r.id], s));
+    }
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
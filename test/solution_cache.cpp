@@ -0,0 +1,102 @@
+#include <miopentensile/solution_cache.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test.hpp"
+
+using string_cache = miopentensile::sharded_cache<int, std::string>;
+
+TEST_CASE(cache_hit_miss)
+{
+    string_cache cache{16, 4};
+    int calls = 0;
+    auto make = [&] {
+        calls++;
+        return std::string("x");
+    };
+    EXPECT(cache.get(1, make) == "x");
+    EXPECT(cache.get(1, make) == "x");
+    EXPECT(cache.get(2, make) == "x");
+    EXPECT(calls == 2);
+    auto s = cache.stats();
+    EXPECT(s.hits == 1u);
+    EXPECT(s.misses == 2u);
+    EXPECT(s.size == 2u);
+}
+
+TEST_CASE(cache_eviction)
+{
+    // A single shard makes the eviction order deterministic
+    string_cache cache{4, 1};
+    for(int i = 0; i < 4; i++)
+        cache.get(i, [&] { return std::to_string(i); });
+    // Inserting a fifth value evicts the oldest one
+    cache.get(4, [] { return std::string("4"); });
+    auto s = cache.stats();
+    EXPECT(s.size == 4u);
+    EXPECT(s.evictions == 1u);
+    int calls = 0;
+    cache.get(0, [&] {
+        calls++;
+        return std::string("0");
+    });
+    EXPECT(calls == 1);
+}
+
+TEST_CASE(cache_lru)
+{
+    string_cache cache{3, 1};
+    cache.get(0, [] { return std::string("0"); });
+    cache.get(1, [] { return std::string("1"); });
+    cache.get(2, [] { return std::string("2"); });
+    cache.get(0, [] { return std::string("0"); });
+    cache.get(3, [] { return std::string("3"); });
+    int calls = 0;
+    auto make = [&] {
+        calls++;
+        return std::string();
+    };
+    cache.get(0, make);
+    cache.get(2, make);
+    cache.get(3, make);
+    EXPECT(calls == 0);
+    cache.get(1, make);
+    EXPECT(calls == 1);
+}
+
+TEST_CASE(cache_clear)
+{
+    string_cache cache{8};
+    cache.get(1, [] { return std::string("1"); });
+    cache.clear();
+    EXPECT(cache.stats().size == 0u);
+    int calls = 0;
+    cache.get(1, [&] {
+        calls++;
+        return std::string("1");
+    });
+    EXPECT(calls == 1);
+}
+
+TEST_CASE(cache_threads)
+{
+    string_cache cache{64};
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&] {
+            for(int i = 0; i < 10000; i++)
+            {
+                auto k = i % 32;
+                EXPECT(cache.get(k, [&] { return std::to_string(k); }) == std::to_string(k));
+            }
+        });
+    }
+    for(auto&& t : threads)
+        t.join();
+    auto s = cache.stats();
+    EXPECT(s.size == 32u);
+    EXPECT(s.hits + s.misses == 80000u);
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
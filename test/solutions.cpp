@@ -0,0 +1,144 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <string>
+#include "fixtures.hpp"
+#include "test.hpp"
+
+// Runs against the installed libraries with a fake device, so no gpu is
+// needed. Kernels are recorded instead of launched.
+
+struct recording_launcher : miopentensile::kernel_launcher
+{
+    std::vector<std::string> kernels;
+    void load_code_object(const std::string&) override {}
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>& invocations,
+                      hipStream_t) override
+    {
+        for(auto&& k : invocations)
+            kernels.push_back(k.kernelName);
+        return hipSuccess;
+    }
+};
+
+std::vector<miopen_tensile_solution_info>
+find_solutions(miopen_tensile_matrix& a, miopen_tensile_matrix& b, miopen_tensile_matrix& c)
+{
+    std::size_t count = 0;
+    EXPECT(miopen_tensile_gemm_find_solutions(&a, &b, &c, 0.0, nullptr, 0, &count) ==
+           miopen_tensile_status_success);
+    std::vector<miopen_tensile_solution_info> result(count);
+    EXPECT(miopen_tensile_gemm_find_solutions(&a, &b, &c, 0.0, result.data(), count, &count) ==
+           miopen_tensile_status_success);
+    EXPECT(count == result.size());
+    return result;
+}
+
+TEST_CASE(find_and_run_solutions)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    auto launcher = std::make_shared<recording_launcher>();
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    miopentensile::set_kernel_launcher(launcher);
+
+    auto a         = mitensile::make_matrix(1024, 512);
+    auto b         = mitensile::make_matrix(512, 1024);
+    auto c         = mitensile::make_matrix(1024, 1024);
+    auto solutions = find_solutions(a, b, c);
+    EXPECT(not solutions.empty());
+
+    std::set<std::uint64_t> ids;
+    for(auto&& s : solutions)
+    {
+        ids.insert(s.id);
+        EXPECT(s.id == miopentensile::fnv1a(s.kernel_name, std::strlen(s.kernel_name)));
+        EXPECT(s.predicted_gflops >= 0.0);
+    }
+    EXPECT(ids.size() == solutions.size());
+
+    // The same list in the same order on every call
+    auto again = find_solutions(a, b, c);
+    EXPECT(again.size() == solutions.size());
+    for(std::size_t i = 0; i < again.size() and i < solutions.size(); i++)
+        EXPECT(again[i].id == solutions[i].id);
+
+    // A shorter list is the head of the full one
+    std::size_t count = 0;
+    miopen_tensile_solution_info first{};
+    EXPECT(miopen_tensile_gemm_find_solutions(&a, &b, &c, 0.0, &first, 1, &count) ==
+           miopen_tensile_status_success);
+    EXPECT(count == 1u);
+    EXPECT(first.id == solutions.front().id);
+
+    for(auto&& s : solutions)
+    {
+        if(s.workspace_size > 0)
+        {
+            EXPECT(miopen_tensile_gemm_solution_hip(
+                       nullptr, &a, &b, &c, 1.0, 0.0, s.id, nullptr, 0) ==
+                   miopen_tensile_status_no_solution);
+            continue;
+        }
+        launcher->kernels.clear();
+        EXPECT(miopen_tensile_gemm_solution_hip(nullptr, &a, &b, &c, 1.0, 0.0, s.id, nullptr, 0) ==
+               miopen_tensile_status_success);
+        EXPECT(not launcher->kernels.empty());
+        EXPECT(std::count(launcher->kernels.begin(), launcher->kernels.end(), s.kernel_name) > 0);
+    }
+    EXPECT(miopen_tensile_gemm_solution_hip(nullptr, &a, &b, &c, 1.0, 0.0, 1, nullptr, 0) ==
+           miopen_tensile_status_no_solution);
+    miopentensile::set_kernel_launcher(miopentensile::hip_kernel_launcher());
+}
+
+TEST_CASE(plans_fit_the_workspace)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    // Small outputs with a long k are where split summation needs workspace
+    for(std::size_t k : {4096, 65536})
+    {
+        auto a         = mitensile::make_matrix(32, k);
+        auto b         = mitensile::make_matrix(k, 32);
+        auto c         = mitensile::make_matrix(32, 32);
+        auto solutions = find_solutions(a, b, c);
+        bool fits      = std::any_of(
+            solutions.begin(), solutions.end(), [](auto&& s) { return s.workspace_size == 0; });
+        std::size_t largest = 0;
+        for(auto&& s : solutions)
+            largest = std::max(largest, s.workspace_size);
+
+        // Without a workspace a solution that needs none is used, if any
+        auto plan = miopentensile::get_gemm_plan(b, a, c, 0.0, 0, 0);
+        EXPECT((plan->solution != nullptr) == fits);
+        EXPECT(plan->workspace_size == 0u);
+        for(std::size_t max_workspace : {largest / 2, largest})
+        {
+            plan = miopentensile::get_gemm_plan(b, a, c, 0.0, 0, max_workspace);
+            EXPECT(bool(plan->solution != nullptr or not fits));
+            EXPECT(plan->workspace_size <= max_workspace);
+        }
+
+        auto batched = miopentensile::get_pointer_batched_gemm_plan(b, a, c, 4, 0.0);
+        EXPECT(batched->workspace_size == 0u);
+        if(batched->solution != nullptr)
+            EXPECT(batched->solution->requiredWorkspaceSize(batched->problem) == 0u);
+    }
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -0,0 +1,243 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/trace.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "fixtures.hpp"
+#include "test.hpp"
+
+// Runs without a gpu. Calls are traced with hand made plans, and through the
+// api against the installed libraries with a fake device.
+
+std::string temp_file(const std::string& name)
+{
+    return "/tmp/miopentensile_trace_" + std::to_string(getpid()) + "_" + name;
+}
+
+std::vector<std::string> read_lines(const std::string& path)
+{
+    std::vector<std::string> result;
+    std::ifstream is(path);
+    std::string line;
+    while(std::getline(is, line))
+        result.push_back(line);
+    return result;
+}
+
+std::size_t count_of(const std::string& text, const std::string& s)
+{
+    std::size_t result = 0;
+    for(auto i = text.find(s); i != std::string::npos; i = text.find(s, i + 1))
+        result++;
+    return result;
+}
+
+// The number after "name": in a json line
+std::size_t field(const std::string& line, const std::string& name)
+{
+    auto i = line.find("\"" + name + "\":");
+    if(i == std::string::npos)
+        return -1;
+    return std::stoull(line.substr(i + name.size() + 3));
+}
+
+miopentensile::gemm_plan_ptr make_plan(std::size_t m)
+{
+    auto p   = std::make_shared<miopentensile::gemm_plan>();
+    p->key.m = m;
+    p->key.n = 16;
+    p->key.k = 8;
+    return p;
+}
+
+void traced_call(std::size_t m, bool miss)
+{
+    miopentensile::trace_call trace{"test"};
+    if(miss)
+        miopentensile::trace_miss();
+    trace.planned(make_plan(m));
+    trace.finish(miopen_tensile_status_success);
+}
+
+TEST_CASE(trace_jsonl)
+{
+    // A small buffer so the rings fill and are written out while running
+    auto path = temp_file("calls.jsonl");
+    miopentensile::start_trace(path, miopentensile::trace_jsonl, 4);
+    EXPECT(miopentensile::tracing());
+    const std::size_t threads = 4;
+    const std::size_t calls   = 25;
+    std::vector<std::thread> workers;
+    for(std::size_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t] {
+            for(std::size_t i = 0; i < calls; i++)
+                traced_call(t * calls + i, i % 5 == 0);
+        });
+    }
+    for(auto&& w : workers)
+        w.join();
+    miopentensile::stop_trace();
+    EXPECT(not miopentensile::tracing());
+
+    auto lines = read_lines(path);
+    std::remove(path.c_str());
+    EXPECT(lines.size() == threads * calls);
+    std::size_t misses = 0;
+    std::vector<std::size_t> last(threads * calls, 0);
+    for(auto&& line : lines)
+    {
+        EXPECT(line.front() == '{');
+        EXPECT(line.back() == '}');
+        EXPECT(line.find("\"call\":\"test\"") != std::string::npos);
+        EXPECT(line.find("\"status\":0") != std::string::npos);
+        EXPECT(line.find("\"solution\":null") != std::string::npos);
+        EXPECT(field(line, "n") == 16u);
+        if(line.find("\"cache\":\"miss\"") != std::string::npos)
+            misses++;
+        // Records of a thread are written in the order of its calls
+        auto m = field(line, "m");
+        EXPECT(m < threads * calls);
+        auto& previous = last[m / calls];
+        EXPECT(m + 1 > previous);
+        previous = m + 1;
+    }
+    EXPECT(misses == threads * calls / 5);
+}
+
+TEST_CASE(trace_hand_off)
+{
+    // Every second call hands a full ring to the writer, and threads exit with
+    // records of theirs still being written
+    auto path = temp_file("hand_off.jsonl");
+    miopentensile::start_trace(path, miopentensile::trace_jsonl, 2);
+    const std::size_t threads = 3;
+    const std::size_t calls   = 51;
+    std::vector<std::thread> workers;
+    for(std::size_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t] {
+            for(std::size_t i = 0; i < calls; i++)
+                traced_call(t * calls + i, false);
+        });
+    }
+    for(auto&& w : workers)
+        w.join();
+    for(std::size_t i = 0; i < 7; i++)
+        traced_call(threads * calls + i, false);
+    miopentensile::stop_trace();
+
+    auto lines = read_lines(path);
+    std::remove(path.c_str());
+    EXPECT(lines.size() == threads * calls + 7);
+    std::vector<std::size_t> next(threads + 1, 0);
+    for(auto&& line : lines)
+    {
+        auto m = field(line, "m");
+        auto t = std::min(m / calls, threads);
+        EXPECT(m == t * calls + next[t]);
+        next[t]++;
+    }
+    EXPECT(next.back() == 7u);
+}
+
+TEST_CASE(trace_chrome)
+{
+    auto path = temp_file("calls.json");
+    miopentensile::start_trace(path, miopentensile::trace_chrome);
+    for(std::size_t i = 0; i < 10; i++)
+        traced_call(i, false);
+    {
+        // Calls inside a traced call belong to it
+        miopentensile::trace_call outer{"outer"};
+        EXPECT(outer.record != nullptr);
+        miopentensile::trace_call inner{"inner"};
+        EXPECT(inner.record == nullptr);
+    }
+    miopentensile::stop_trace();
+
+    std::ifstream is(path);
+    std::string text{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+    std::remove(path.c_str());
+    EXPECT(text.compare(0, 3, "[\n{") == 0);
+    EXPECT(text.size() > 4u);
+    EXPECT(text.compare(text.size() - 4, 4, "}\n]\n") == 0);
+    EXPECT(count_of(text, "\"ph\":\"X\"") == 11u);
+    EXPECT(count_of(text, "\"name\":\"test\"") == 10u);
+    EXPECT(count_of(text, "\"name\":\"outer\"") == 1u);
+    EXPECT(count_of(text, "\"name\":\"inner\"") == 0u);
+    EXPECT(count_of(text, "},\n{") == 10u);
+}
+
+TEST_CASE(trace_off)
+{
+    EXPECT(not miopentensile::tracing());
+    miopentensile::trace_call trace{"test"};
+    EXPECT(trace.record == nullptr);
+    EXPECT(miopentensile::current_trace() == nullptr);
+    EXPECT(trace.finish(miopen_tensile_status_no_solution) == miopen_tensile_status_no_solution);
+}
+
+struct recording_launcher : miopentensile::kernel_launcher
+{
+    void load_code_object(const std::string&) override {}
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>&, hipStream_t) override
+    {
+        return hipSuccess;
+    }
+};
+
+TEST_CASE(trace_api)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    miopentensile::set_kernel_launcher(std::make_shared<recording_launcher>());
+    miopentensile::clear_plan_cache();
+
+    auto path = temp_file("api.jsonl");
+    miopentensile::start_trace(path, miopentensile::trace_jsonl);
+    miopen_tensile_matrix a{{256, 128}, {128, 1}, {0, 0}, miopen_tensile_type_float, nullptr};
+    miopen_tensile_matrix b{{128, 512}, {512, 1}, {0, 0}, miopen_tensile_type_float, nullptr};
+    miopen_tensile_matrix c{{256, 512}, {512, 1}, {0, 0}, miopen_tensile_type_float, nullptr};
+    for(int i = 0; i < 2; i++)
+        EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 0.0) ==
+               miopen_tensile_status_success);
+    miopentensile::stop_trace();
+
+    auto lines = read_lines(path);
+    std::remove(path.c_str());
+    EXPECT(lines.size() == 2u);
+    if(lines.size() == 2)
+    {
+        EXPECT(lines[0].find("\"cache\":\"miss\"") != std::string::npos);
+        EXPECT(lines[1].find("\"cache\":\"hit\"") != std::string::npos);
+        // In tensile order, so m and n come from c of the gemm api
+        EXPECT(field(lines[0], "m") == 512u);
+        EXPECT(field(lines[0], "n") == 256u);
+        EXPECT(field(lines[0], "k") == 128u);
+        EXPECT(lines[0].find("\"beta\":\"zero\"") != std::string::npos);
+        // Enough to replay the call
+        EXPECT(lines[0].find("\"alpha\":1,\"beta_value\":0") != std::string::npos);
+        EXPECT(lines[0].find("\"max_workspace\":") != std::string::npos);
+        EXPECT(lines[0].find("\"solution\":\"Cijk_") != std::string::npos);
+        EXPECT(lines[0].find("\"kernels\":[\"") != std::string::npos);
+        EXPECT(lines[0].find("\"source\":") != std::string::npos);
+    }
+    miopentensile::set_kernel_launcher(miopentensile::hip_kernel_launcher());
+    miopentensile::clear_plan_cache();
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -0,0 +1,251 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <miopentensile/problem.hpp>
+#include <miopentensile/tuning.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "fixtures.hpp"
+#include "test.hpp"
+
+// Runs without a gpu: the timer is a stub, and the auto-tune test uses the
+// installed libraries with a fake device and records kernels instead of
+// launching them.
+
+std::string temp_path(const std::string& name)
+{
+    auto dir = "/tmp/miopentensile_test_" + std::to_string(getpid());
+    mkdir(dir.c_str(), 0700);
+    return dir + "/" + name;
+}
+
+void remove_db(const std::string& path)
+{
+    std::remove(path.c_str());
+    std::remove((path + ".lock").c_str());
+}
+
+std::string read_file(const std::string& path)
+{
+    std::ifstream is(path);
+    return {std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+}
+
+TEST_CASE(db_records)
+{
+    auto path = temp_path("records.db");
+    {
+        miopentensile::tuning_db db{path};
+        EXPECT(db.size() == 0u);
+        EXPECT(db.find("gfx908:120,1,0,0,64") == 0u);
+        db.store("gfx908:120,1,0,0,64", 0xabc);
+        db.store("gfx908:120,1,1,0,64", 7);
+        db.store("gfx908:120,1,0,0,64", 0xdef);
+        EXPECT(db.find("gfx908:120,1,0,0,64") == 0xdefu);
+        EXPECT(db.size() == 2u);
+    }
+    // One record per line with the id in hex
+    auto text = read_file(path);
+    EXPECT(text.find("gfx908:120,1,0,0,64 def\n") != std::string::npos);
+    EXPECT(text.find("gfx908:120,1,1,0,64 7\n") != std::string::npos);
+
+    // Another reader sees the records, and lines it cannot parse are skipped
+    {
+        std::ofstream os(path, std::ios::app);
+        os << "truncated\n\nbad zz\n";
+    }
+    miopentensile::tuning_db other{path};
+    EXPECT(other.size() == 2u);
+    EXPECT(other.find("gfx908:120,1,1,0,64") == 7u);
+
+    // Changes made through one instance are seen by the other
+    miopentensile::tuning_db db{path};
+    db.store("gfx90a:104,2,0,0,32", 9);
+    EXPECT(other.find("gfx90a:104,2,0,0,32") == 9u);
+    remove_db(path);
+    EXPECT(other.size() == 0u);
+
+    // Missing directories are created on the first write
+    auto nested = temp_path("nested/dir/records.db");
+    miopentensile::tuning_db{nested}.store("key", 1);
+    EXPECT(miopentensile::tuning_db{nested}.find("key") == 1u);
+    remove_db(nested);
+    rmdir(temp_path("nested/dir").c_str());
+    rmdir(temp_path("nested").c_str());
+}
+
+TEST_CASE(db_processes)
+{
+    // Writers in separate processes merge their records instead of replacing
+    // each other's
+    auto path                 = temp_path("shared.db");
+    const int processes       = 8;
+    const int records_per_one = 25;
+    std::vector<pid_t> children;
+    for(int i = 0; i < processes; i++)
+    {
+        auto pid = fork();
+        if(pid == 0)
+        {
+            miopentensile::tuning_db db{path};
+            for(int j = 0; j < records_per_one; j++)
+                db.store("p" + std::to_string(i) + "_" + std::to_string(j), j + 1);
+            _exit(0);
+        }
+        children.push_back(pid);
+    }
+    for(auto pid : children)
+    {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        EXPECT(WIFEXITED(status) and WEXITSTATUS(status) == 0);
+    }
+    miopentensile::tuning_db db{path};
+    EXPECT(db.size() == std::size_t(processes * records_per_one));
+    EXPECT(db.find("p3_24") == 25u);
+    remove_db(path);
+}
+
+struct recording_launcher : miopentensile::kernel_launcher
+{
+    std::vector<std::string> kernels;
+    void load_code_object(const std::string&) override {}
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>& invocations,
+                      hipStream_t) override
+    {
+        for(auto&& k : invocations)
+            kernels.push_back(k.kernelName);
+        return hipSuccess;
+    }
+};
+
+// Each candidate is faster than the one timed before it
+struct fake_timer : miopentensile::solution_timer
+{
+    std::vector<std::string> timed;
+    double time(const miopentensile::gemm_plan& p, const miopentensile::tensile_operands&) override
+    {
+        timed.push_back(p.solution->kernelName);
+        return 100.0 - timed.size();
+    }
+};
+
+TEST_CASE(auto_tune)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    auto launcher = std::make_shared<recording_launcher>();
+    auto timer    = std::make_shared<fake_timer>();
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    miopentensile::set_kernel_launcher(launcher);
+    miopentensile::set_solution_timer(timer);
+    auto path = temp_path("tune.db");
+    miopentensile::tuning_options options;
+    options.db_path    = path;
+    options.candidates = 3;
+    miopentensile::set_tuning_options(options);
+    miopentensile::clear_plan_cache();
+
+    auto a = mitensile::make_matrix(1000, 500);
+    auto b = mitensile::make_matrix(500, 1000);
+    auto c = mitensile::make_matrix(1000, 1000);
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    EXPECT(not timer->timed.empty());
+    EXPECT(timer->timed.size() <= 3u);
+    // The fastest candidate is recorded and run
+    auto winner = timer->timed.back();
+    EXPECT(std::count(launcher->kernels.begin(), launcher->kernels.end(), winner) > 0);
+    EXPECT(miopentensile::tuning_db{path}.size() == 1u);
+
+    // Later plans for the shape, in this or another process, read the record
+    // instead of tuning again
+    miopentensile::clear_plan_cache();
+    timer->timed.clear();
+    launcher->kernels.clear();
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    EXPECT(timer->timed.empty());
+    EXPECT(std::count(launcher->kernels.begin(), launcher->kernels.end(), winner) > 0);
+
+    // Records are used without tuning enabled, and a different beta class is
+    // a different problem
+    options.candidates = 0;
+    miopentensile::set_tuning_options(options);
+    miopentensile::clear_plan_cache();
+    launcher->kernels.clear();
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    EXPECT(std::count(launcher->kernels.begin(), launcher->kernels.end(), winner) > 0);
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &b, &c, 1.0, 1.0) ==
+           miopen_tensile_status_success);
+    EXPECT(timer->timed.empty());
+    EXPECT(miopentensile::tuning_db{path}.size() == 1u);
+
+    remove_db(path);
+    miopentensile::set_tuning_options(miopentensile::default_tuning_options());
+    miopentensile::set_solution_timer(miopentensile::hip_solution_timer());
+    miopentensile::set_kernel_launcher(miopentensile::hip_kernel_launcher());
+    miopentensile::clear_plan_cache();
+}
+
+TEST_CASE(default_options)
+{
+    // No database unless one is set or tuning is enabled
+    unsetenv("MIOPEN_TENSILE_TUNING_DB");
+    unsetenv("MIOPEN_TENSILE_TUNE");
+    EXPECT(miopentensile::default_tuning_options().db_path.empty());
+    setenv("HOME", "/home/user", 1);
+    unsetenv("XDG_CACHE_HOME");
+    setenv("MIOPEN_TENSILE_TUNE", "4", 1);
+    auto tune = miopentensile::default_tuning_options();
+    EXPECT(tune.candidates == 4u);
+    EXPECT(tune.db_path == "/home/user/.cache/miopentensile/tuning.db");
+    unsetenv("MIOPEN_TENSILE_TUNE");
+    setenv("MIOPEN_TENSILE_TUNING_DB", "/tmp/records.db", 1);
+    auto records = miopentensile::default_tuning_options();
+    EXPECT(records.candidates == 0u);
+    EXPECT(records.db_path == "/tmp/records.db");
+    unsetenv("MIOPEN_TENSILE_TUNING_DB");
+}
+
+TEST_CASE(tuning_key)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    auto hw = miopentensile::fake_hardware_provider(arch, 60)->create_hardware(0);
+    auto a  = mitensile::make_matrix(64, 32);
+    auto b  = mitensile::make_matrix(16, 64);
+    auto c  = mitensile::make_matrix(16, 32);
+    auto x  = miopentensile::create_problem_key(a, b, c, 0.0, 0);
+    auto y  = x;
+    // Device ordinal, workspace and pinned solution are not part of the key
+    y.device        = 3;
+    y.max_workspace = 1 << 20;
+    y.solution_id   = 5;
+    auto key        = miopentensile::tuning_key(x, *hw);
+    EXPECT(key == miopentensile::tuning_key(y, *hw));
+    EXPECT(key.find(' ') == std::string::npos);
+    EXPECT(key.compare(0, arch.size() + 4, arch + ":60,") == 0);
+    y.beta = miopentensile::beta_one;
+    EXPECT(key != miopentensile::tuning_key(y, *hw));
+    auto other = miopentensile::fake_hardware_provider(arch, 64)->create_hardware(0);
+    EXPECT(key != miopentensile::tuning_key(x, *other));
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -0,0 +1,120 @@
+#include <miopentensile/gemm.h>
+#include <miopentensile/gemm_plan.hpp>
+#include <miopentensile/hardware.hpp>
+#include <miopentensile/library.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "fixtures.hpp"
+#include "test.hpp"
+
+// Runs against the installed libraries with a fake device, so no gpu is
+// needed. Code object loads and launches are counted instead of done.
+
+struct counting_launcher : miopentensile::kernel_launcher
+{
+    std::atomic<std::size_t> loads{0};
+    std::atomic<std::size_t> launches{0};
+    void load_code_object(const std::string&) override { loads++; }
+    hipError_t launch(const std::vector<Tensile::KernelInvocation>&, hipStream_t) override
+    {
+        launches++;
+        return hipSuccess;
+    }
+};
+
+miopen_tensile_gemm_desc
+make_desc(std::size_t m, std::size_t n, std::size_t k, miopen_tensile_type type, double beta)
+{
+    return miopen_tensile_gemm_desc{mitensile::make_matrix(m, k, type),
+                                    mitensile::make_matrix(k, n, type),
+                                    mitensile::make_matrix(m, n, type),
+                                    1.0,
+                                    beta};
+}
+
+std::vector<miopen_tensile_gemm_desc> warmup_shapes()
+{
+    return {make_desc(1024, 1024, 512, miopen_tensile_type_float, 0.0),
+            make_desc(256, 768, 3072, miopen_tensile_type_float, 1.0),
+            make_desc(128, 4096, 1024, miopen_tensile_type_half, 0.0),
+            make_desc(333, 77, 129, miopen_tensile_type_float, 0.5)};
+}
+
+TEST_CASE(warmup_then_call)
+{
+    auto arch = mitensile::installed_arch();
+    if(arch.empty())
+    {
+        std::cout << "No library installed, skipping" << std::endl;
+        return;
+    }
+    auto launcher = std::make_shared<counting_launcher>();
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider(arch, 64));
+    miopentensile::set_kernel_launcher(launcher);
+    miopentensile::clear_plan_cache();
+
+    auto gemms = warmup_shapes();
+    miopen_tensile_warmup_handle handle = nullptr;
+    EXPECT(miopen_tensile_warmup_async(gemms.data(), gemms.size(), &handle) ==
+           miopen_tensile_status_success);
+    // The descriptors were copied
+    gemms.clear();
+    EXPECT(miopen_tensile_warmup_wait(handle) == miopen_tensile_status_success);
+    int done = 0;
+    EXPECT(miopen_tensile_warmup_query(handle, &done) == miopen_tensile_status_success);
+    EXPECT(done == 1);
+    EXPECT(miopen_tensile_warmup_destroy(handle) == miopen_tensile_status_success);
+    EXPECT(launcher->launches == 0u);
+
+    // Warmed shapes neither select nor load code objects
+    auto stats = miopentensile::plan_cache_stats();
+    auto loads = launcher->loads.load();
+    for(auto&& g : warmup_shapes())
+        EXPECT(miopen_tensile_gemm_hip(nullptr, &g.a, &g.b, &g.c, g.alpha, g.beta) ==
+               miopen_tensile_status_success);
+    auto after = miopentensile::plan_cache_stats();
+    EXPECT(after.misses == stats.misses);
+    EXPECT(after.hits == stats.hits + warmup_shapes().size());
+    EXPECT(launcher->loads == loads);
+    EXPECT(launcher->launches == warmup_shapes().size());
+
+    // A shape that was not warmed selects on its first call
+    auto cold = make_desc(640, 640, 640, miopen_tensile_type_float, 0.0);
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &cold.a, &cold.b, &cold.c, 1.0, 0.0) ==
+           miopen_tensile_status_success);
+    EXPECT(miopentensile::plan_cache_stats().misses == stats.misses + 1);
+
+    miopentensile::set_kernel_launcher(miopentensile::hip_kernel_launcher());
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+TEST_CASE(warmup_errors)
+{
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider("gfx906", 60));
+    EXPECT(miopen_tensile_warmup(nullptr, 0) == miopen_tensile_status_success);
+    EXPECT(miopen_tensile_warmup(nullptr, 1) == miopen_tensile_status_unknown);
+    auto gemms = warmup_shapes();
+    EXPECT(miopen_tensile_warmup_async(gemms.data(), gemms.size(), nullptr) ==
+           miopen_tensile_status_unknown);
+    int done = 0;
+    EXPECT(miopen_tensile_warmup_query(nullptr, &done) == miopen_tensile_status_unknown);
+    EXPECT(miopen_tensile_warmup_destroy(nullptr) == miopen_tensile_status_success);
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+TEST_CASE(null_arguments)
+{
+    // Errors are returned instead of thrown across the c api
+    miopentensile::set_hardware_provider(miopentensile::fake_hardware_provider("gfx906", 60));
+    miopen_tensile_matrix a{{64, 64}, {64, 1}, {0, 0}, miopen_tensile_type_float, nullptr};
+    EXPECT(miopen_tensile_gemm_hip(nullptr, &a, &a, nullptr, 1.0, 0.0) ==
+           miopen_tensile_status_unknown);
+    EXPECT(miopen_tensile_gemm_hip(nullptr, nullptr, &a, &a, 1.0, 0.0) ==
+           miopen_tensile_status_unknown);
+    EXPECT(miopen_tensile_get_solution_cache_stats(nullptr) == miopen_tensile_status_unknown);
+    miopentensile::set_hardware_provider(miopentensile::hip_hardware_provider());
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -0,0 +1,102 @@
+#include <miopentensile/cost_model.hpp>
+#include <miopentensile/logic_file.hpp>
+#include <miopentensile/logic_index.hpp>
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <iostream>
+#include <sys/stat.h>
+
+// Converts tensile logic yaml files into the binary index read at runtime,
+// with the cost model fitted to each of them:
+//
+//     miopen-tensile-compile-logic [--arch gfx906]... <output> <file or directory>...
+//
+// Directories are searched recursively for .yaml files. When architectures
+// are given only their files and the fallback files are kept.
+
+bool is_directory(const std::string& path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 and S_ISDIR(st.st_mode);
+}
+
+void find_logic_files(const std::string& path, std::vector<std::string>& result)
+{
+    if(not is_directory(path))
+    {
+        result.push_back(path);
+        return;
+    }
+    auto* dir = opendir(path.c_str());
+    if(dir == nullptr)
+        throw std::runtime_error("Failed to open directory: " + path);
+    while(auto* e = readdir(dir))
+    {
+        std::string name = e->d_name;
+        if(name == "." or name == "..")
+            continue;
+        auto child = path + "/" + name;
+        if(is_directory(child))
+            find_logic_files(child, result);
+        else if(name.size() > 5 and name.compare(name.size() - 5, 5, ".yaml") == 0)
+            result.push_back(child);
+    }
+    closedir(dir);
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<std::string> archs;
+    int arg = 1;
+    while(arg + 1 < argc and std::string(argv[arg]) == "--arch")
+    {
+        archs.push_back(argv[arg + 1]);
+        arg += 2;
+    }
+    if(argc - arg < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--arch gfx906]... <output> <file or directory>..."
+                  << std::endl;
+        return 1;
+    }
+    std::string output = argv[arg];
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::string> paths;
+        for(int i = arg + 1; i < argc; i++)
+            find_logic_files(argv[i], paths);
+        // Keep the output independent of the directory order
+        std::sort(paths.begin(), paths.end());
+
+        std::vector<miopentensile::logic_file> files;
+        std::size_t nsolutions = 0;
+        std::size_t nentries   = 0;
+        for(auto&& p : paths)
+        {
+            auto f = miopentensile::parse_logic_file(p);
+            if(not archs.empty() and f.arch != "fallback" and
+               std::find(archs.begin(), archs.end(), f.arch) == archs.end())
+                continue;
+            nsolutions += f.solutions.size();
+            nentries += f.exact.size();
+            files.push_back(std::move(f));
+        }
+        miopentensile::write_logic_index(files, output);
+        auto written = std::chrono::steady_clock::now();
+        // The cost model is fitted here so that processes only read it
+        miopentensile::write_logic_costs(
+            output, miopentensile::calibrate_logic_index(miopentensile::logic_index{output}));
+        auto finish = std::chrono::steady_clock::now();
+        auto ms     = [](auto d) { return std::chrono::duration<double, std::milli>(d).count(); };
+        std::cout << output << ": " << files.size() << " files, " << nsolutions << " solutions, "
+                  << nentries << " sizes in " << ms(written - start) << " ms, cost model in "
+                  << ms(finish - written) << " ms" << std::endl;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "MIOpenTensile error: " << e.what() << std::endl;
+        return 1;
+    }
+}